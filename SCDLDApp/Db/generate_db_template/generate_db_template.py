@@ -39,7 +39,7 @@ def generate_template(infile, outfile):
             if len(asynportname) == 0:
               continue
             datatype = param['data type']
-            if datatype == 'array2d':
+            if datatype in ('array2d', 'array3d'):
               continue
             # add entry for the request file
             try:
@@ -217,6 +217,22 @@ record(waveform, "$(P)$(R)<NAME>")
 }
 """
 
+DB_GEN_ARRAY1D_OUT = \
+"""
+record(waveform, "$(P)$(R)<NAME>")
+{
+    field(PINI, "YES")
+    field(DTYP, "asyn<ELEMTYPE>ArrayOut")<DESC>
+    field(INP,  "@asyn($(PORT),$(ADDR),$(TIMEOUT))<APNAME>")
+    field(FTVL, "<FTVL>")
+    field(NELM, "<MAXLENGTH>")
+    info(autosaveFields, "VAL")
+}
+"""
+
+# element types that are written without conversion
+DB_ARRAY1D_WRITEABLE_ELEMTYPES = ('i8', 'i16', 'i32', 'f32', 'f64')
+
 DB_ARRAY1D_ELEMTYPE_MAPPINGS = {
   'i8' :  ['Int8',    'CHAR'  ],
   'u8' :  ['Int16',   'SHORT' ], # needs conversion during updates
@@ -232,12 +248,14 @@ DB_ARRAY1D_ELEMTYPE_MAPPINGS = {
 
 def db_gen_array1d(name, asynportname, out=False, defaultval=None,
                    description=None, maxlength=2048, elementtype='f64'):
-  if out:
-    raise RuntimeError("db_gen_array1d: parameter {}: writeable arrays are not "
-                       "supported".format(name))
+  if out and elementtype not in DB_ARRAY1D_WRITEABLE_ELEMTYPES:
+    raise RuntimeError("db_gen_array1d: parameter {}: writeable arrays of "
+                       "element type {} are not supported".format(
+                         name, elementtype))
   asyn_elemtype = DB_ARRAY1D_ELEMTYPE_MAPPINGS[elementtype][0]
   ftvl = DB_ARRAY1D_ELEMTYPE_MAPPINGS[elementtype][1]
-  return DB_GEN_ARRAY1D_IN.replace(
+  template = DB_GEN_ARRAY1D_OUT if out else DB_GEN_ARRAY1D_IN
+  return template.replace(
     '<NAME>',      name                      ).replace(
     '<APNAME>',    asynportname              ).replace(
     '<DESC>',      gen_desc_str(description) ).replace(
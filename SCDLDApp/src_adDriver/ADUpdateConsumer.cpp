@@ -2,6 +2,26 @@
 #include "ADUpdateConsumer.hpp"
 #include "dldDetectorv2.h"
 #include "DldAppLibUser.hpp"
+#include <algorithm>
+#include <cstring>
+
+namespace {
+  // the NDArray data type for the elements of an image, false if none fits
+  bool toNDDataType(DldApp::ElementDatatypeEnum e, NDDataType_t* t)
+  {
+    switch (e) {
+    case DldApp::ELEMTYPE_I8: *t = NDInt8; return true;
+    case DldApp::ELEMTYPE_U8: *t = NDUInt8; return true;
+    case DldApp::ELEMTYPE_I16: *t = NDInt16; return true;
+    case DldApp::ELEMTYPE_U16: *t = NDUInt16; return true;
+    case DldApp::ELEMTYPE_I32: *t = NDInt32; return true;
+    case DldApp::ELEMTYPE_U32: *t = NDUInt32; return true;
+    case DldApp::ELEMTYPE_F32: *t = NDFloat32; return true;
+    case DldApp::ELEMTYPE_F64: *t = NDFloat64; return true;
+    default: return false;
+    }
+  }
+}
 
 // updates may be issued by the library synchronously in the course of
 // processing a write-parameter-request or spontaneously at any point in
@@ -10,6 +30,18 @@
 
 ADUpdateConsumer::ADUpdateConsumer(dldDetectorv2* parent) : parent_(parent) {
   arrays_.reset(new CachedArrays);
+  // the cache is fixed before the first update arrives
+  const auto& params = DldApp::Lib::instance().getParams();
+  for (std::size_t i = 0; i < params.size(); i++) {
+    const auto& param = params[i];
+    int drvpidx = parent_->libusr_.lib2ap(i);
+    if (param.lib_type == DldApp::DATATYPE_ARRAY1D && param.arr_cfg
+        && drvpidx >= 0)
+    {
+      arrays_->addArray1D(
+        drvpidx, param.arr_cfg->elemtype, param.arr_cfg->maxlength);
+    }
+  }
   /* // future support for images
     auto ins = [&](const std::string& s, int i) {
       to_ndarray[DldApp::Lib::instance().idxFromParamName(s)] = i;
@@ -21,24 +53,14 @@ ADUpdateConsumer::ADUpdateConsumer(dldDetectorv2* parent) : parent_(parent) {
 void ADUpdateConsumer::UpdateInt32(std::size_t libpidx, int val) {
   int drvpidx = parent_->libusr_.lib2ap(libpidx);
   if (drvpidx >= 0) {
-    parent_->worker_.addTask([this, drvpidx, val](){
-      parent_->lock();
-      parent_->setIntegerParam(drvpidx, val);
-      parent_->callParamCallbacks();
-      parent_->unlock();
-    });
+    addPending(drvpidx, asynParamInt32, val, 0.0, std::string());
   }
 }
 
 void ADUpdateConsumer::UpdateFloat64(std::size_t libpidx, double val) {
   int drvpidx = parent_->libusr_.lib2ap(libpidx);
   if (drvpidx >= 0) {
-    parent_->worker_.addTask([this, drvpidx, val](){
-      parent_->lock();
-      parent_->setDoubleParam(drvpidx, val);
-      parent_->callParamCallbacks();
-      parent_->unlock();
-    });
+    addPending(drvpidx, asynParamFloat64, 0, val, std::string());
   }
 }
 
@@ -46,12 +68,7 @@ void ADUpdateConsumer::UpdateString(std::size_t libpidx, const std::string& val)
 {
   int drvpidx = parent_->libusr_.lib2ap(libpidx);
   if (drvpidx >= 0) {
-    parent_->worker_.addTask([this, drvpidx, val](){
-      parent_->lock();
-      parent_->setStringParam(drvpidx, val.c_str());
-      parent_->callParamCallbacks();
-      parent_->unlock();
-    });
+    addPending(drvpidx, asynParamOctet, 0, 0.0, val);
   }
 }
 
@@ -64,48 +81,39 @@ void ADUpdateConsumer::UpdateArray1D(
       const auto& param = DldApp::Lib::instance().getParams().at(libpidx);
       DldApp::ElementDatatypeEnum elemtype = param.arr_cfg->elemtype;
       arrays_->updateArray1D(drvpidx, elemtype, bytelen, data);
+      // the tasks send the latest snapshot, which may already be newer than
+      // the data of this update
       switch(elemtype) {
       case DldApp::ELEMTYPE_I32:
-        parent_->worker_.addTask([this, drvpidx]() {
+        addTask([this, drvpidx]() {
+          auto s = arrays_->getArray1D(drvpidx, asynParamInt32Array);
+          if (!s) return;
           parent_->lock();
-          arrays_->getArray1D(
-            drvpidx,
-            asynParamInt32Array,
-            [this, drvpidx] (void* data, std::size_t bytelen)
-            {
-              parent_->doCallbacksInt32Array(
-                static_cast<epicsInt32*>(data), bytelen/sizeof(int), drvpidx, 0);
-            });
+          parent_->doCallbacksInt32Array(
+            reinterpret_cast<epicsInt32*>(const_cast<char*>(s->data())),
+            s->size()/sizeof(epicsInt32), drvpidx, 0);
           parent_->unlock();
         });
         break;
       case DldApp::ELEMTYPE_F32:
-        parent_->worker_.addTask([this, drvpidx]() {
+        addTask([this, drvpidx]() {
+          auto s = arrays_->getArray1D(drvpidx, asynParamFloat32Array);
+          if (!s) return;
           parent_->lock();
-          arrays_->getArray1D(
-            drvpidx,
-            asynParamFloat32Array,
-            [this, drvpidx] (void* data, std::size_t bytelen)
-            {
-              parent_->doCallbacksFloat32Array(
-                static_cast<epicsFloat32*>(data), bytelen/sizeof(epicsFloat32),
-                drvpidx, 0);
-            });
+          parent_->doCallbacksFloat32Array(
+            reinterpret_cast<epicsFloat32*>(const_cast<char*>(s->data())),
+            s->size()/sizeof(epicsFloat32), drvpidx, 0);
           parent_->unlock();
         });
         break;
       case DldApp::ELEMTYPE_F64:
-        parent_->worker_.addTask([this, drvpidx]() {
+        addTask([this, drvpidx]() {
+          auto s = arrays_->getArray1D(drvpidx, asynParamFloat64Array);
+          if (!s) return;
           parent_->lock();
-          arrays_->getArray1D(
-            drvpidx,
-            asynParamFloat64Array,
-            [this, drvpidx] (void* data, std::size_t bytelen)
-            {
-              parent_->doCallbacksFloat64Array(
-                static_cast<epicsFloat64*>(data), bytelen/sizeof(epicsFloat64),
-                drvpidx, 0);
-            });
+          parent_->doCallbacksFloat64Array(
+            reinterpret_cast<epicsFloat64*>(const_cast<char*>(s->data())),
+            s->size()/sizeof(epicsFloat64), drvpidx, 0);
           parent_->unlock();
         });
         break;
@@ -117,56 +125,164 @@ void ADUpdateConsumer::UpdateArray1D(
 }
 
 void ADUpdateConsumer::UpdateArray2D(
-  std::size_t libpidx, std::size_t bytelen, std::size_t width, void* data)
+  std::size_t libpidx, DldApp::ElementDatatypeEnum elemtype,
+  std::size_t bytelen, std::size_t width, void* data)
 {
   int addr = parent_->libusr_.array2d_address(libpidx);
-  auto elemtype = parent_->libusr_.element_type(libpidx);
   auto maxlength = parent_->libusr_.array_maxlength(libpidx);
+  auto elemsize = DldApp::elementSize(elemtype);
   if (addr < 0 || addr >= DldApp::Lib::instance().numberArray2dParams()
-      || elemtype == DldApp::ELEMTYPE_INVALID
+      || elemsize == 0
       || width == 0)
   {
     return;
   }
-  //
-  // (1) we have no guarantees from the libdldApp that the data memory buffer will
-  // live longer than when we return from this function, so we make a copy here
-  // (by calling arrays_->updateImage)
-  // (2) ADUpdateConsumer::UpdateArray2D(...) may be called at any time, so we
-  // don't know whether we can lock the ADDriver and we might not want to block
-  // the app library, so we defer ADDriver actions to a separate worker thread.
-  // Currently, these circumstances lead us to making 2 copies of the image,
-  // one in arrays_->updateImage(...), and one memcpy down below in the worker
-  // task. This is a bit wasteful, but at least safe.
-  // We could pass our copied data buffer to the pNDArrayPool->alloc, thereby
-  // eliminating the 2nd copy, but our copied data buffer does not necessarily
-  // remain unchanged until all users of the NDArray have released it.
-  arrays_->updateImage(addr, elemtype, maxlength, bytelen, width, data);
-  parent_->worker_.addTask([this, addr, bytelen]() {
+  auto length = std::min(bytelen / elemsize, maxlength);
+  // NDArray dimensions start with the fastest varying index
+  size_t dims[] = {width, length / width};
+  publishArray(addr, 2, dims, elemtype, data);
+}
+
+void ADUpdateConsumer::UpdateArray3D(
+  std::size_t libpidx, std::size_t bytelen, std::size_t width,
+  std::size_t height, void* data)
+{
+  int addr = parent_->libusr_.array2d_address(libpidx);
+  auto elemtype = parent_->libusr_.element_type(libpidx);
+  auto maxlength = parent_->libusr_.array_maxlength(libpidx);
+  auto elemsize = DldApp::elementSize(elemtype);
+  if (addr < 0 || addr >= DldApp::Lib::instance().numberArray2dParams()
+      || elemsize == 0
+      || width == 0 || height == 0)
+  {
+    return;
+  }
+  auto length = std::min(bytelen / elemsize, maxlength);
+  size_t dims[] = {width, height, length / (width * height)};
+  publishArray(addr, 3, dims, elemtype, data);
+}
+
+void ADUpdateConsumer::publishArray(
+  int addr, int ndims, std::size_t* dims,
+  DldApp::ElementDatatypeEnum elemtype, void* data)
+{
+  // We have no guarantees from the libdldApp that the data memory buffer will
+  // live longer than when we return from this function, so we copy it, but
+  // directly into an NDArray: the pool is thread-safe, unlike the rest of
+  // the driver, which we might not be able to lock here without blocking the
+  // app library. The NDArray is passed on by a separate worker thread.
+  // If the pool has reached its memory limit because the worker thread or the
+  // plugins are behind, the frame is dropped.
+  NDDataType_t ndtype;
+  if (!toNDDataType(elemtype, &ndtype)
+      || std::find(dims, dims + ndims, 0u) != dims + ndims)
+  {
+    return;
+  }
+  NDArray* pNew = parent_->pNDArrayPool->alloc(ndims, dims, ndtype, 0, NULL);
+  if (!pNew) {
+    return;
+  }
+  NDArrayInfo_t info;
+  pNew->getInfo(&info);
+  memcpy(pNew->pData, data, info.totalBytes);
+  addTask([this, addr, pNew]() {
     parent_->lock();
-    bool image_found = arrays_->getImage(
-      addr,
-      [this, addr, bytelen](void* data, std::size_t width, std::size_t height) {
-        auto& pArr = parent_->pArrays[addr];
-        if (pArr != 0) {
-          pArr->release();
-        }
-        size_t dims[] = {height, width};
-        pArr = parent_->pNDArrayPool->alloc(2, dims, NDInt32, 0, NULL);
-        if (!pArr) {
-          return;
-        }
-        parent_->updateTimeStamp(&(pArr->epicsTS));
-        NDArrayInfo_t info;
-        pArr->getInfo(&info);
-        memcpy(pArr->pData, data, std::min(bytelen, info.totalBytes));
-      });
+    parent_->updateTimeStamp(&(pNew->epicsTS));
+    // pArrays holds the latest array of each address for the driver
+    auto& pArr = parent_->pArrays[addr];
+    if (pArr != nullptr) {
+      pArr->release();
+    }
+    pArr = pNew;
     parent_->unlock();
-    if (image_found) {
-      auto& pArr = parent_->pArrays[addr];
-      if (pArr != nullptr) {
-        parent_->doCallbacksGenericPointer(pArr, parent_->NDArrayData, addr);
+    parent_->doCallbacksGenericPointer(pNew, parent_->NDArrayData, addr);
+  });
+}
+
+void ADUpdateConsumer::addPending(
+  int drvpidx, asynParamType type, int ival, double dval,
+  const std::string& sval)
+{
+  std::shared_ptr<Batch> created;
+  {
+    std::lock_guard<std::mutex> l(batch_mutex_);
+    if (!batch_) {
+      batch_ = std::make_shared<Batch>();
+      created = batch_;
+    }
+    // a burst of updates touches few parameters, a linear search is fine
+    bool found = false;
+    for (auto& v : batch_->values) {
+      if (v.drvpidx == drvpidx) {
+        v.type = type;
+        v.ival = ival;
+        v.dval = dval;
+        v.sval = sval;
+        found = true;
+        break;
       }
     }
+    if (!found) {
+      PendingValue v = {drvpidx, type, ival, dval, sval};
+      batch_->values.push_back(v);
+    }
+  }
+  if (created) {
+    // the values are set when the worker thread gets to this task, with
+    // whatever has been added to the batch until then
+    parent_->worker_.addTask([this, created]() { applyBatch(created); });
+  }
+}
+
+void ADUpdateConsumer::applyBatch(const std::shared_ptr<Batch>& b)
+{
+  {
+    std::lock_guard<std::mutex> l(batch_mutex_);
+    if (b->applied) {
+      return;
+    }
+    b->applied = true;
+    if (batch_ == b) {
+      batch_.reset(); // later updates go into a new batch
+    }
+  }
+  parent_->lock();
+  for (const auto& v : b->values) {
+    switch (v.type) {
+    case asynParamInt32:
+      parent_->setIntegerParam(v.drvpidx, v.ival);
+      break;
+    case asynParamFloat64:
+      parent_->setDoubleParam(v.drvpidx, v.dval);
+      break;
+    case asynParamOctet:
+      parent_->setStringParam(v.drvpidx, v.sval.c_str());
+      break;
+    default:
+      break;
+    }
+  }
+  parent_->callParamCallbacks();
+  parent_->unlock();
+}
+
+template <typename F> void ADUpdateConsumer::addTask(F&& task)
+{
+  // Scalar updates after this one must not overtake the task (e.g. the end
+  // of the acquisition overtaking its last image), so they start a new batch.
+  // The task of the closed batch may be queued after this one by another
+  // thread, so this task sets the batch if it comes first.
+  std::shared_ptr<Batch> b;
+  {
+    std::lock_guard<std::mutex> l(batch_mutex_);
+    b.swap(batch_);
+  }
+  typename std::decay<F>::type t(std::forward<F>(task));
+  parent_->worker_.addTask([this, b, t]() mutable {
+    if (b) {
+      applyBatch(b);
+    }
+    t();
   });
 }
@@ -4,12 +4,32 @@
 
 #include "UpdateConsumer.hpp"
 #include "CachedArrays.hpp"
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
 
 class dldDetectorv2;
 
 class ADUpdateConsumer : public DldApp::UpdateConsumer {
   dldDetectorv2* parent_;
   std::unique_ptr<CachedArrays> arrays_;
+  // the latest value of a scalar parameter, waiting to be set in the driver
+  struct PendingValue {
+    int drvpidx;
+    asynParamType type;
+    int ival;
+    double dval;
+    std::string sval;
+  };
+  // scalar updates that arrive before the worker thread has set the previous
+  // ones are collected in one batch, set by a single task
+  struct Batch {
+    std::vector<PendingValue> values;
+    bool applied = false;
+  };
+  std::shared_ptr<Batch> batch_; // open for more updates while not null
+  std::mutex batch_mutex_;       // for batch_ and the Batch members
   /*
   std::unordered_map<size_t, int> to_ndarray; // maps indices from lib parameter to NDArray
   */
@@ -22,8 +42,25 @@ public:
   virtual void UpdateArray1D(
     std::size_t libpidx, std::size_t bytelen, void* data) override;
   virtual void UpdateArray2D(
+    std::size_t libpidx, DldApp::ElementDatatypeEnum elemtype,
+    std::size_t bytelen, std::size_t width, void* data) override;
+  virtual void UpdateArray3D(
     std::size_t libpidx, std::size_t bytelen, std::size_t width,
-    void* data) override; // TODO support for images
+    std::size_t height, void* data) override;
 
   CachedArrays& arrays() { return *arrays_; }
+
+private:
+  // record the value in the open batch (or a new one), latest value wins
+  void addPending(int drvpidx, asynParamType type, int ival, double dval,
+                  const std::string& sval);
+  // set the values of a batch and call the callbacks once, unless that has
+  // been done already
+  void applyBatch(const std::shared_ptr<Batch>&);
+  // queue a task that sets the open batch first, closing it for further
+  // updates
+  template <typename F> void addTask(F&& task);
+  // copy data into a new NDArray of dims, pass it on in the worker thread
+  void publishArray(int addr, int ndims, std::size_t* dims,
+                    DldApp::ElementDatatypeEnum elemtype, void* data);
 };
@@ -1,192 +1,96 @@
 /* Copyright 2022 Surface Concept GmbH */
 #include "CachedArrays.hpp"
-#include <cstring>
+#include <algorithm>
+#include <atomic>
 
 // TODO: handle all element data types, some of which need conversion to one
 // of the supported asynPortDriver array types
 
-CachedArrays::CachedArrays()
-{
-
-}
-
 namespace {
-  template <DldApp::ElementDatatypeEnum E>
-  struct toType { };
-  template <> struct toType<DldApp::ELEMTYPE_I8> { typedef char t; };
-  template <> struct toType<DldApp::ELEMTYPE_I16> { typedef short t; };
-  template <> struct toType<DldApp::ELEMTYPE_I32> { typedef int t; };
-  template <> struct toType<DldApp::ELEMTYPE_F32> { typedef float t; };
-  template <> struct toType<DldApp::ELEMTYPE_F64> { typedef double t; };
+  // the asynPortDriver array type that holds elements without conversion
+  asynParamType arrayType(DldApp::ElementDatatypeEnum e)
+  {
+    switch (e) {
+    case DldApp::ELEMTYPE_I8: return asynParamInt8Array;
+    case DldApp::ELEMTYPE_I16: return asynParamInt16Array;
+    case DldApp::ELEMTYPE_I32: return asynParamInt32Array;
+    case DldApp::ELEMTYPE_F32: return asynParamFloat32Array;
+    case DldApp::ELEMTYPE_F64: return asynParamFloat64Array;
+    default: return asynParamNotDefined;
+    }
+  }
 }
 
-template <DldApp::ElementDatatypeEnum E>
-struct CachedArrays::EDTHelper
-{
-};
-template <>
-struct CachedArrays::EDTHelper<DldApp::ELEMTYPE_I8>
-{
-  CachedArrays& i;
-  EDTHelper(CachedArrays& i) : i(i) {}
-  std::unordered_map<std::size_t, i8array>& arrays() { return i.i8arrays; }
-};
-template <>
-struct CachedArrays::EDTHelper<DldApp::ELEMTYPE_I16>
-{
-  CachedArrays& i;
-  EDTHelper(CachedArrays& i) : i(i) {}
-  std::unordered_map<std::size_t, i16array>& arrays() { return i.i16arrays; }
-};
-template <>
-struct CachedArrays::EDTHelper<DldApp::ELEMTYPE_I32>
-{
-  CachedArrays& i;
-  EDTHelper(CachedArrays& i) : i(i) {}
-  std::unordered_map<std::size_t, i32array>& arrays() { return i.i32arrays; }
-};
-template <>
-struct CachedArrays::EDTHelper<DldApp::ELEMTYPE_F32>
-{
-  CachedArrays& i;
-  EDTHelper(CachedArrays& i) : i(i) {}
-  std::unordered_map<std::size_t, f32array>& arrays() { return i.f32arrays; }
-};
-template <>
-struct CachedArrays::EDTHelper<DldApp::ELEMTYPE_F64>
+CachedArrays::CachedArrays()
 {
-  CachedArrays& i;
-  EDTHelper(CachedArrays& i) : i(i) {}
-  std::unordered_map<std::size_t, f64array>& arrays() { return i.f64arrays; }
-};
-
 
+}
 
-template<DldApp::ElementDatatypeEnum E>
-void CachedArrays::updateArray1D_impl(
-  std::size_t drvpidx, std::size_t bytelen, void* data)
+void CachedArrays::addArray1D(
+  std::size_t drvpidx, DldApp::ElementDatatypeEnum elementtype,
+  std::size_t maxlength)
 {
-  auto nr_elements = bytelen / sizeof(typename toType<E>::t);
-  EDTHelper<E> h(*this);
-  try {
-    auto& v = h.arrays().at(drvpidx);
-    v.resize(nr_elements);
-    memcpy(v.data(), data, bytelen);
+  if (arrayType(elementtype) == asynParamNotDefined) {
+    return;
+  }
+  std::unique_ptr<Slot> s(new Slot);
+  s->elemtype = elementtype;
+  s->maxbytes = maxlength * DldApp::elementSize(elementtype);
+  for (auto& b : s->buffers) {
+    b = std::make_shared<Bytes>();
+    b->reserve(s->maxbytes);
   }
-  catch (const std::out_of_range&) {
-    h.arrays()[drvpidx] = {};
-    auto& v = h.arrays().at(drvpidx);
-    v.resize(nr_elements);
-    memcpy(v.data(), data, bytelen);
+  if (drvpidx >= slots_.size()) {
+    slots_.resize(drvpidx + 1);
   }
+  slots_[drvpidx] = std::move(s);
+}
+
+const CachedArrays::Slot* CachedArrays::slot(std::size_t drvpidx) const
+{
+  return drvpidx < slots_.size() ? slots_[drvpidx].get() : nullptr;
 }
 
 void CachedArrays::updateArray1D(
   std::size_t drvpidx,
   DldApp::ElementDatatypeEnum elementtype,
   std::size_t bytelen,
-  void* data)
+  const void* data)
 {
-  std::lock_guard<std::mutex> l(mutex_);
-  switch (elementtype) {
-  case DldApp::ELEMTYPE_I8:
-    updateArray1D_impl<DldApp::ELEMTYPE_I8>(drvpidx, bytelen, data);
-    break;
-  case DldApp::ELEMTYPE_I16:
-    updateArray1D_impl<DldApp::ELEMTYPE_I16>(drvpidx, bytelen, data);
-    break;
-  case DldApp::ELEMTYPE_I32:
-    updateArray1D_impl<DldApp::ELEMTYPE_I32>(drvpidx, bytelen, data);
-    break;
-  case DldApp::ELEMTYPE_F32:
-    updateArray1D_impl<DldApp::ELEMTYPE_F32>(drvpidx, bytelen, data);
-    break;
-  case DldApp::ELEMTYPE_F64:
-    updateArray1D_impl<DldApp::ELEMTYPE_F64>(drvpidx, bytelen, data);
-    break;
-  default:
-    break;
+  Slot* s = const_cast<Slot*>(slot(drvpidx));
+  if (!s || s->elemtype != elementtype) {
+    return;
   }
-}
-
-void CachedArrays::updateImage(
-  int addr, DldApp::ElementDatatypeEnum elementtype,
-  std::size_t maxlength, std::size_t bytelen, std::size_t width, void* data)
-{
-  std::lock_guard<std::mutex> l(mutex_);
-  switch (elementtype) {
-  case DldApp::ELEMTYPE_I32:
-    {
-      auto length = bytelen / sizeof(int);
-      if (i32images.find(addr)==i32images.end()) {
-        i32images[addr] = {};
-        i32images[addr].data.reserve(maxlength);
-        // we must prevent that the memory buffer of the vector is ever
-        // relocated, once we passed the data pointer to an NDArray
-        // this would happen, if the resize
-      }
-      if (length > maxlength) {
-        length = maxlength;
-      }
-      image<int>& img = i32images.at(addr);
-      img.data.resize(length);
-      img.width = width;
-      img.height = img.data.size() / std::max(width, std::size_t{1u});
-      memcpy(img.data.data(), data, bytelen);
+  const char* begin = static_cast<const char*>(data);
+  bytelen = std::min(bytelen, s->maxbytes);
+  bytelen -= bytelen % DldApp::elementSize(elementtype);
+  std::lock_guard<std::mutex> l(s->write_mutex);
+  // Readers only get hold of the current snapshot, so a buffer that is not
+  // current and only owned by the slot has no readers and cannot get any.
+  Bytes* current = const_cast<Bytes*>(std::atomic_load(&s->current).get());
+  std::shared_ptr<Bytes>* free = nullptr;
+  for (auto& b : s->buffers) {
+    if (b.get() != current && b.use_count() == 1) {
+      free = &b;
+      break;
     }
-    break;
-  default:
-    break;
   }
-
-}
-
-bool CachedArrays::getArray1D(
-  std::size_t drvpidx,
-  asynParamType arraytype,
-  std::function<void (void*, std::size_t)> f)
-{
-  std::lock_guard<std::mutex> l(mutex_);
-  try {
-    if (arraytype == asynParamInt8Array) {
-      auto& v = i8arrays.at(drvpidx);
-      f(v.data(), v.size() * sizeof(char));
-      return true;
-    }
-    if (arraytype == asynParamInt16Array) {
-      auto& v = i16arrays.at(drvpidx);
-      f(v.data(), v.size() * sizeof(short));
-      return true;
-    }
-    if (arraytype == asynParamInt32Array) {
-      auto& v = i32arrays.at(drvpidx);
-      f(v.data(), v.size() * sizeof(int));
-      return true;
-    }
-    else if (arraytype == asynParamFloat32Array) {
-      auto& v = f32arrays.at(drvpidx);
-      f(v.data(), v.size() * sizeof(float));
-      return true;
-    }
-    else if (arraytype == asynParamFloat64Array) {
-      auto& v = f64arrays.at(drvpidx);
-      f(v.data(), v.size() * sizeof(double));
-      return true;
-    }
+  if (!free) {
+    return; // slow readers hold all buffers, skip this update
   }
-  catch (const std::out_of_range&) { }
-  return false;
+  // pairs with the release of the last reader, which has dropped its
+  // reference after reading
+  std::atomic_thread_fence(std::memory_order_acquire);
+  (*free)->assign(begin, begin + bytelen);
+  std::atomic_store(&s->current, Snapshot(*free));
 }
 
-bool CachedArrays::getImage(
-  int addr, std::function<void (void*, std::size_t, std::size_t)> f)
+CachedArrays::Snapshot CachedArrays::getArray1D(
+  std::size_t drvpidx, asynParamType arraytype) const
 {
-  std::lock_guard<std::mutex> l(mutex_);
-  try {
-    auto& img = i32images.at(addr);
-    f(img.data.data(), img.width, img.height);
-    return true;
+  const Slot* s = slot(drvpidx);
+  if (!s || arrayType(s->elemtype) != arraytype) {
+    return Snapshot();
   }
-  catch (const std::out_of_range&) { }
-  return false;
+  return std::atomic_load(&s->current);
 }
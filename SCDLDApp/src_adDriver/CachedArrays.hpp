@@ -5,9 +5,8 @@
 #include <cstddef>
 #include <asynParamType.h>
 #include "DldAppLib.hpp"
-#include <unordered_map>
 #include <vector>
-#include <functional>
+#include <memory>
 #include <mutex>
 
 /**
@@ -30,11 +29,29 @@
  * f64 -> asynParamFloat64Array
  * This choice is made to avoid data loss wherever possible (not generally
  * possible for i64 and u64).
+ * An update publishes a new, immutable snapshot of the array by an atomic
+ * pointer exchange, so readers never wait for an update or for each other.
+ * A reader keeps its snapshot alive as long as it needs it; the buffer of a
+ * snapshot without readers is reused by a later update.
+ * The slots are indexed by the driver parameter index and their buffers are
+ * allocated for the maximum array length up front, so that updates and reads
+ * neither search nor allocate.
  */
 class CachedArrays
 {
 public:
+  typedef std::vector<char> Bytes;
+  // the data of an array at the time of one update
+  typedef std::shared_ptr<const Bytes> Snapshot;
+
   CachedArrays();
+  /**
+   * @brief addArray1D make room for the data of a driver parameter, must be
+   * called for all parameters before the first update
+   * @param maxlength the maximum number of elements, longer updates are cut
+   */
+  void addArray1D(std::size_t drvpidx, DldApp::ElementDatatypeEnum,
+                  std::size_t maxlength);
   /**
    * @brief cache data associated to a driver parameter index
    * @param drvpidx
@@ -45,60 +62,30 @@ public:
     std::size_t drvpidx,
     DldApp::ElementDatatypeEnum,
     std::size_t bytelen,
-    void* data);
-
-  void updateImage(
-    int addr,
-    DldApp::ElementDatatypeEnum,
-    std::size_t maxlen,
-    std::size_t bytelen,
-    std::size_t width,
-    void* data);
+    const void* data);
 
   /**
    * @brief get array data that has been cached by a previous call to
-   * updateArray1D()
+   * updateArray1D(), without locking
    * @param drvpidx the parameter index as delivered by asynUser::reason
    * @param arraytype one of the asynParamXYZArray constants
-   * @param consumer a function that gets passed the pointer to the data and
-   * the size of the data in bytes
-   * @return true if array data was available
+   * @return the latest data, or nullptr if no array data was available
    */
-  bool getArray1D(
-    std::size_t drvpidx,
-    asynParamType arraytype,
-    std::function<void(void*, std::size_t)> consumer);
-
-  // getImage: currently only for Int32 voxels
-  // consumer function gets data pointer, width and height
-  bool getImage(
-    int addr,
-    std::function<void(void*, std::size_t, std::size_t)> consumer);
+  Snapshot getArray1D(std::size_t drvpidx, asynParamType arraytype) const;
 
 private:
-  typedef std::vector<char> i8array;
-  typedef std::vector<short> i16array;
-  typedef std::vector<int> i32array;
-  typedef std::vector<float> f32array;
-  typedef std::vector<double> f64array;
-  std::unordered_map<std::size_t, i8array> i8arrays;
-  std::unordered_map<std::size_t, i16array> i16arrays;
-  std::unordered_map<std::size_t, i32array> i32arrays;
-  std::unordered_map<std::size_t, f32array> f32arrays;
-  std::unordered_map<std::size_t, f64array> f64arrays;
-  template <typename T> struct image {
-    std::size_t width;
-    std::size_t height;
-    std::vector<T> data;
+  // the current snapshot, one that a reader may still hold and one to
+  // write the next update into
+  static const std::size_t BUFFERS_PER_SLOT = 3;
+  struct Slot {
+    DldApp::ElementDatatypeEnum elemtype;
+    std::size_t maxbytes;
+    Snapshot current;              // only with atomic_load/atomic_exchange
+    std::mutex write_mutex;        // for concurrent updates, not for readers
+    std::shared_ptr<Bytes> buffers[BUFFERS_PER_SLOT];
   };
-  std::unordered_map<int, image<int> > i32images;
-  std::mutex mutex_;
-  template <DldApp::ElementDatatypeEnum E>
-  struct EDTHelper;
-  template <DldApp::ElementDatatypeEnum E>
-  void updateArray1D_impl(
-    std::size_t drvpidx,
-    std::size_t bytelen,
-    void* data);
+  const Slot* slot(std::size_t drvpidx) const;
+  // indexed by driver parameter index, fixed after the calls to addArray1D
+  std::vector<std::unique_ptr<Slot> > slots_;
 };
 
@@ -15,7 +15,8 @@ enum DatatypeEnum {
   DATATYPE_FLOAT64 = 3,
   DATATYPE_STRING = 4,
   DATATYPE_ARRAY1D = 5,
-  DATATYPE_ARRAY2D = 6
+  DATATYPE_ARRAY2D = 6,
+  DATATYPE_ARRAY3D = 7
 };
 enum ElementDatatypeEnum {
   ELEMTYPE_INVALID = 0,
@@ -42,7 +43,7 @@ struct ArrayParam {
     : elemtype(e), maxlength(l), address(-1) {}
   ElementDatatypeEnum elemtype;  // C type for the elements of the array
   std::size_t maxlength;
-  int address; // only for 2D arrays
+  int address; // only for 2D and 3D arrays (the NDArray address)
 };
 
 struct Param {
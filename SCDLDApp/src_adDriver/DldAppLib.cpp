@@ -95,6 +95,7 @@ asynParamType Lib::drvType(const Param& p)
       m[DATATYPE_FLOAT64] = asynParamFloat64;
       m[DATATYPE_STRING] = asynParamOctet;
       m[DATATYPE_ARRAY2D] = asynParamGenericPointer;
+      m[DATATYPE_ARRAY3D] = asynParamGenericPointer;
     }
     try {
       drvtype = m.at(p.lib_type);
@@ -31,6 +31,7 @@ class Lib // I'm a singleton
 
 public:
   int numberDrvParams() const;
+  // number of 2D and 3D array parameters, each has its own NDArray address
   int numberArray2dParams() const;
   bool hasParamName(const std::string&) const;
   std::size_t idxFromParamName(const std::string&) const;
@@ -1,6 +1,7 @@
 /* Copyright 2022 Surface Concept GmbH */
 #include "DldAppLibUser.hpp"
 #include <dldApp.h> // public API of application library
+#include <algorithm>
 #include <exception>
 #include <string>
 #include <memory>
@@ -31,6 +32,8 @@ LibUser::LibUser()
   scdldapp_set_callback_string(user_id_, this, static_cb_string);
   scdldapp_set_callback_arr1d(user_id_, this, static_cb_arr1d);
   scdldapp_set_callback_arr2d(user_id_, this, static_cb_arr2d);
+  scdldapp_set_callback_arr3d(user_id_, this, static_cb_arr3d);
+  scdldapp_set_callback_arr2d_typed(user_id_, this, static_cb_arr2d_typed);
 }
 
 LibUser::~LibUser()
@@ -276,6 +279,25 @@ template
 int LibUser::writeAndReadAny(
   const std::string& name, const std::string& value, std::function<void(const std::string&)> f);
 
+int LibUser::writeArray1D(int drvpidx, ElementDatatypeEnum elemtype,
+                          std::size_t bytelen, const void* data)
+{
+  try {
+    auto pidx = ap2lib(drvpidx);
+    const Param& p = Lib::instance().params().at(pidx);
+    if (p.lib_type != DATATYPE_ARRAY1D || !p.arr_cfg) {
+      return DLDAPPLIB_NOT_MY_PARAM;
+    }
+    if (p.arr_cfg->elemtype != elemtype) {
+      return DLDAPPLIB_WRONG_DATATYPE;
+    }
+    bytelen = std::min(bytelen, p.arr_cfg->maxlength * elementSize(elemtype));
+    return scdldapp_write_arr1d(user_id_, pidx, bytelen, data);
+  } catch (const std::out_of_range&) {
+    return DLDAPPLIB_NOT_MY_PARAM;
+  }
+}
+
 int LibUser::readStrImpl(
   int libparidx, std::function<void (const std::string &)> f)
 {
@@ -329,7 +351,25 @@ void LibUser::cb_arr1d(size_t pidx, size_t bytelen, void* data)
 void LibUser::cb_arr2d(size_t pidx, size_t bytelen, size_t width, void* data)
 {
   if (update_consumer_) {
-    update_consumer_->UpdateArray2D(pidx, bytelen, width, data);
+    update_consumer_->UpdateArray2D(
+      pidx, element_type(pidx), bytelen, width, data);
+  }
+}
+
+void LibUser::cb_arr2d_typed(size_t pidx, int elemtype, size_t bytelen,
+                             size_t width, void* data)
+{
+  if (update_consumer_) {
+    update_consumer_->UpdateArray2D(
+      pidx, static_cast<ElementDatatypeEnum>(elemtype), bytelen, width, data);
+  }
+}
+
+void LibUser::cb_arr3d(size_t pidx, size_t bytelen, size_t width,
+                       size_t height, void* data)
+{
+  if (update_consumer_) {
+    update_consumer_->UpdateArray3D(pidx, bytelen, width, height, data);
   }
 }
 
@@ -363,6 +403,19 @@ void LibUser::static_cb_arr2d(void* priv, size_t pidx, size_t bytelen, size_t wi
   reinterpret_cast<LibUser*>(priv)->cb_arr2d(pidx, bytelen, width, d);
 }
 
+void LibUser::static_cb_arr3d(void* priv, size_t pidx, size_t bytelen,
+                              size_t width, size_t height, void* d)
+{
+  reinterpret_cast<LibUser*>(priv)->cb_arr3d(pidx, bytelen, width, height, d);
+}
+
+void LibUser::static_cb_arr2d_typed(void* priv, size_t pidx, int elemtype,
+                                    size_t bytelen, size_t width, void* d)
+{
+  reinterpret_cast<LibUser*>(priv)->cb_arr2d_typed(
+    pidx, elemtype, bytelen, width, d);
+}
+
 int LibUser::firstDriverParamIdx() const
 {
   return first_driver_param_;
@@ -71,6 +71,15 @@ public:
   int writeAndReadAny(const std::string& name, const ValueType& value,
                       std::function<void(const ValueType&)>);
 
+  /**
+   * @brief writeArray1D write a 1d array parameter of the library
+   * @param elemtype element type of data, must match the parameter
+   * @return 0 on success, DLDAPPLIB_NOT_MY_PARAM if drvpidx is not a 1d
+   * array of the library
+   */
+  int writeArray1D(int drvpidx, ElementDatatypeEnum elemtype,
+                   std::size_t bytelen, const void* data);
+
   int firstDriverParamIdx() const;
   std::size_t ap2lib(int asynport_param_idx) const; // may throw std::out_of_range
   int lib2ap(std::size_t libpidx) const;
@@ -95,12 +104,16 @@ private:
   void cb_enum(size_t, int);
   void cb_arr1d(size_t, size_t, void*);
   void cb_arr2d(size_t, size_t, size_t, void*);
+  void cb_arr3d(size_t, size_t, size_t, size_t, void*);
+  void cb_arr2d_typed(size_t, int, size_t, size_t, void*);
   static void static_cb_int32(void*, size_t, int);
   static void static_cb_float64(void*, size_t, double);
   static void static_cb_string(void*, size_t, const char*);
   static void static_cb_enum(void*, size_t, int);
   static void static_cb_arr1d(void*, size_t, size_t, void*);
   static void static_cb_arr2d(void*, size_t, size_t, size_t, void*);
+  static void static_cb_arr3d(void*, size_t, size_t, size_t, size_t, void*);
+  static void static_cb_arr2d_typed(void*, size_t, int, size_t, size_t, void*);
 };
 
 } // namespace DldApp
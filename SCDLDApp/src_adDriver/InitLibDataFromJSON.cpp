@@ -16,6 +16,7 @@ DldApp::DatatypeEnum libtypeFromString(const std::string& s) {
     m["string"] = DldApp::DATATYPE_STRING;
     m["array1d"] = DldApp::DATATYPE_ARRAY1D;
     m["array2d"] = DldApp::DATATYPE_ARRAY2D;
+    m["array3d"] = DldApp::DATATYPE_ARRAY3D;
   }
   try {
     return m.at(s);
@@ -52,7 +53,8 @@ bool is_scalar_datatype (const std::string& s) {
       || s.compare("float64")==0 || s.compare("string")==0);
 }
 bool is_array(const std::string& s) {
-  return (s.compare("array1d")==0 || s.compare("array2d")==0);
+  return (s.compare("array1d")==0 || s.compare("array2d")==0
+      || s.compare("array3d")==0);
 }
 } // namespace
 
@@ -65,8 +67,8 @@ int init_libdata_from_json(Lib& lib)
                               // create an asynPortDriver parameter, ourselves.
                               // This excludes parameters with an empty
                               // asynportname value in the JSON config
-                              // 2d arrays should have an empty asynportname and
-                              // are not counted.
+                              // 2d and 3d arrays should have an empty
+                              // asynportname and are not counted.
     int nr_array2d_params = 0;
     for (std::size_t pidx = 0; pidx < j.size(); pidx++) {
       auto jpar = j.at(pidx);
@@ -89,12 +91,13 @@ int init_libdata_from_json(Lib& lib)
       lib.params_.emplace_back(libptype, drvname);
       // -> parameter added in vector
       // store additional meta data if parameter type is an array
-      if(libptype == DATATYPE_ARRAY1D || libptype == DATATYPE_ARRAY2D) {
+      if(libptype == DATATYPE_ARRAY1D || libptype == DATATYPE_ARRAY2D
+         || libptype == DATATYPE_ARRAY3D) {
         std::size_t maxlen = jpar.at("maxlen");
         ElementDatatypeEnum etype =
           elemtypeFromString(jpar.at("element data type"));
         lib.params_.back().arr_cfg.reset(new ArrayParam(etype, maxlen));
-        if (libptype == DATATYPE_ARRAY2D) {
+        if (libptype == DATATYPE_ARRAY2D || libptype == DATATYPE_ARRAY3D) {
           nr_array2d_params++;
           lib.params_.back().arr_cfg->address =
             jpar.at("epicsprops").at("address");
@@ -4,6 +4,7 @@
 
 #include <cstddef>
 #include <string>
+#include "DldAppCommon.hpp"
 
 namespace DldApp
 {
@@ -16,7 +17,10 @@ public:
   virtual void UpdateFloat64(std::size_t libpidx, double) = 0;
   virtual void UpdateString(std::size_t libpidx, const std::string&) = 0;
   virtual void UpdateArray1D(std::size_t libpidx, std::size_t bytelen, void* data) = 0;
-  virtual void UpdateArray2D(std::size_t libpidx, std::size_t bytelen, std::size_t width, void* data) = 0;
+  // elemtype: from the parameter configuration, or sent with the data if
+  // the element type of the parameter is selectable
+  virtual void UpdateArray2D(std::size_t libpidx, ElementDatatypeEnum elemtype, std::size_t bytelen, std::size_t width, void* data) = 0;
+  virtual void UpdateArray3D(std::size_t libpidx, std::size_t bytelen, std::size_t width, std::size_t height, void* data) = 0;
 };
 
 } // namespace DldApp
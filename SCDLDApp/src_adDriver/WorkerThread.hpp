@@ -2,21 +2,96 @@
 
 #pragma once
 
+#include <chrono>
+#include <cstddef>
 #include <functional>
 #include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
 
 /**
  * @brief a worker thread for fire-and-forget tasks
+ * Tasks are passed through a bounded queue that multiple threads can add to
+ * without locking. A task whose captures fit into TASK_STORAGE is stored in
+ * the queue itself, so adding it does not allocate. If the queue is full,
+ * the task goes to an overflow list on the heap, under a mutex; addTask never
+ * waits for the worker thread.
+ * Timers (addTaskAt) are kept by the worker thread in a heap ordered by their
+ * deadlines; it sleeps until the next deadline or the next task, whichever
+ * comes first.
+ * Tasks still queued at terminate() are destroyed without running.
  */
 class WorkerThread
 {
   struct Priv;
 public:
+  // bytes for the callable of a task inside the queue
+  static const std::size_t TASK_STORAGE = 64;
+  // number of tasks queued without allocation, a power of two
+  static const std::size_t CAPACITY = 1024;
+
+  struct Stats {
+    std::size_t depth;               // currently queued tasks
+    std::size_t max_depth;           // since construction
+    unsigned long long overflowed;   // tasks that went to the overflow list
+    unsigned long long tasks;        // tasks started
+    double mean_latency_us;          // from addTask to the start of the task
+    double max_latency_us;
+  };
+
+  typedef std::chrono::steady_clock Clock;
+  // receives the message of an exception that escaped from a task
+  typedef std::function<void(const char*)> ErrorHandler;
+
   WorkerThread();
   ~WorkerThread();
-  void addTask(std::function<void()>);
+  template <typename F> void addTask(F&& f);
+  // run the task at tp or as soon as possible after it, in the order of the
+  // deadlines; pending timers are dropped by terminate()
+  void addTaskAt(Clock::time_point tp, std::function<void()> task);
+  // called in the worker thread, for the tasks added after this call
+  void setErrorHandler(ErrorHandler handler);
   void terminate();
   bool alive() const;
+  Stats stats() const;
 private:
+  typedef void (*TaskFn)(void*);
+  // the storage of the next queue entry
+  void* claim();
+  // make the entry of claim() visible to the worker thread
+  void commit(void* storage, TaskFn run, TaskFn destroy);
+
+  template <typename T, bool INLINE =
+    (sizeof(T) <= TASK_STORAGE && alignof(T) <= alignof(std::max_align_t))>
+  struct Holder {
+    template <typename F> static void create(void* s, F&& f)
+    { new (s) T(std::forward<F>(f)); }
+    static void run(void* s) { (*static_cast<T*>(s))(); }
+    static void destroy(void* s) { static_cast<T*>(s)->~T(); }
+  };
+  template <typename T>
+  struct Holder<T, false> {
+    template <typename F> static void create(void* s, F&& f)
+    { *static_cast<T**>(s) = new T(std::forward<F>(f)); }
+    static void run(void* s) { (**static_cast<T**>(s))(); }
+    static void destroy(void* s) { delete *static_cast<T**>(s); }
+  };
+  static void noop(void*) {}
+
   std::unique_ptr<Priv> p_;
 };
+
+template <typename F> void WorkerThread::addTask(F&& f)
+{
+  typedef typename std::decay<F>::type T;
+  if (!alive()) return;
+  void* s = claim();
+  try {
+    Holder<T>::create(s, std::forward<F>(f));
+  } catch (...) {
+    commit(s, noop, noop); // the entry is claimed, it must be released
+    throw;
+  }
+  commit(s, Holder<T>::run, Holder<T>::destroy);
+}
@@ -193,23 +193,63 @@ asynStatus dldDetectorv2::writeOctet(
   return status;
 }
 
+/**
+ * @brief Called when clients write an int32 array parameter, the library
+ * sends the accepted value back as an array update
+ */
+asynStatus dldDetectorv2::writeInt32Array(
+  asynUser* pasynUser, epicsInt32* value, size_t nElements)
+{
+  const int param_idx = pasynUser->reason;
+  int ret = libusr_.writeArray1D(
+    param_idx, DldApp::ELEMTYPE_I32, nElements * sizeof(epicsInt32), value);
+  if (ret == DLDAPPLIB_NOT_MY_PARAM) {
+    return ADDriver::writeInt32Array(pasynUser, value, nElements);
+  }
+  if (ret != 0) {
+    asynPrint(pasynUser, ASYN_TRACE_ERROR,
+              "%s:writeInt32Array() : app library returned error %d for "
+              "parameter %s\n", driverName, ret,
+              libusr_.paramName(param_idx).c_str());
+    return asynError;
+  }
+  return asynSuccess;
+}
+
+/**
+ * @brief Called when clients write a float64 array parameter, the library
+ * sends the accepted value back as an array update
+ */
+asynStatus dldDetectorv2::writeFloat64Array(
+  asynUser* pasynUser, epicsFloat64* value, size_t nElements)
+{
+  const int param_idx = pasynUser->reason;
+  int ret = libusr_.writeArray1D(
+    param_idx, DldApp::ELEMTYPE_F64, nElements * sizeof(epicsFloat64), value);
+  if (ret == DLDAPPLIB_NOT_MY_PARAM) {
+    return ADDriver::writeFloat64Array(pasynUser, value, nElements);
+  }
+  if (ret != 0) {
+    asynPrint(pasynUser, ASYN_TRACE_ERROR,
+              "%s:writeFloat64Array() : app library returned error %d for "
+              "parameter %s\n", driverName, ret,
+              libusr_.paramName(param_idx).c_str());
+    return asynError;
+  }
+  return asynSuccess;
+}
+
 asynStatus dldDetectorv2::readInt8Array(
   asynUser* pasynUser, epicsInt8* value, size_t nElements, size_t* nIn)
 {
   const int param_idx = pasynUser->reason;
-  auto data_found = arrays_->getArray1D(
-    param_idx,
-    asynParamInt8Array,
-    [this, value, nElements, nIn](void* data, std::size_t bytelen) {
-      auto elements_to_copy = std::min(bytelen/sizeof(char), nElements);
-      *nIn = elements_to_copy;
-      memcpy(value, data, elements_to_copy * sizeof(char));
-    }
-  );
-  if (data_found) {
+  auto s = arrays_->getArray1D(param_idx, asynParamInt8Array);
+  if (!s) {
+    *nIn = 0; // no data, return empty array
     return asynSuccess;
   }
-  *nIn = 0; // no data, return empty array
+  *nIn = std::min(s->size()/sizeof(*value), nElements);
+  memcpy(value, s->data(), *nIn * sizeof(*value));
   return asynSuccess;
 }
 
@@ -217,19 +257,13 @@ asynStatus dldDetectorv2::readInt16Array(
   asynUser* pasynUser, epicsInt16* value, size_t nElements, size_t* nIn)
 {
   const int param_idx = pasynUser->reason;
-  auto data_found = arrays_->getArray1D(
-    param_idx,
-    asynParamInt16Array,
-    [this, value, nElements, nIn](void* data, std::size_t bytelen) {
-      auto elements_to_copy = std::min(bytelen/sizeof(short), nElements);
-      *nIn = elements_to_copy;
-      memcpy(value, data, elements_to_copy * sizeof(short));
-    }
-  );
-  if (data_found) {
+  auto s = arrays_->getArray1D(param_idx, asynParamInt16Array);
+  if (!s) {
+    *nIn = 0; // no data, return empty array
     return asynSuccess;
   }
-  *nIn = 0; // no data, return empty array
+  *nIn = std::min(s->size()/sizeof(*value), nElements);
+  memcpy(value, s->data(), *nIn * sizeof(*value));
   return asynSuccess;
 }
 
@@ -237,19 +271,13 @@ asynStatus dldDetectorv2::readInt32Array(
   asynUser* pasynUser, epicsInt32* value, size_t nElements, size_t* nIn)
 {
   const int param_idx = pasynUser->reason;
-  auto data_found = arrays_->getArray1D(
-    param_idx,
-    asynParamInt32Array,
-    [this, value, nElements, nIn](void* data, std::size_t bytelen) {
-      auto elements_to_copy = std::min(bytelen/sizeof(int), nElements);
-      *nIn = elements_to_copy;
-      memcpy(value, data, elements_to_copy * sizeof(int));
-    }
-  );
-  if (data_found) {
+  auto s = arrays_->getArray1D(param_idx, asynParamInt32Array);
+  if (!s) {
+    *nIn = 0; // no data, return empty array
     return asynSuccess;
   }
-  *nIn = 0; // no data, return empty array
+  *nIn = std::min(s->size()/sizeof(*value), nElements);
+  memcpy(value, s->data(), *nIn * sizeof(*value));
   return asynSuccess;
 }
 
@@ -257,19 +285,13 @@ asynStatus dldDetectorv2::readFloat32Array(
   asynUser* pasynUser, epicsFloat32* value, size_t nElements, size_t* nIn)
 {
   const int param_idx = pasynUser->reason;
-  auto data_found = arrays_->getArray1D(
-    param_idx,
-    asynParamFloat32Array,
-    [this, value, nElements, nIn](void* data, std::size_t bytelen) {
-      auto elements_to_copy = std::min(bytelen/sizeof(float), nElements);
-      *nIn = elements_to_copy;
-      memcpy(value, data, elements_to_copy * sizeof(float));
-    }
-  );
-  if (data_found) {
+  auto s = arrays_->getArray1D(param_idx, asynParamFloat32Array);
+  if (!s) {
+    *nIn = 0; // no data, return empty array
     return asynSuccess;
   }
-  *nIn = 0; // no data, return empty array
+  *nIn = std::min(s->size()/sizeof(*value), nElements);
+  memcpy(value, s->data(), *nIn * sizeof(*value));
   return asynSuccess;
 }
 
@@ -277,19 +299,13 @@ asynStatus dldDetectorv2::readFloat64Array(
   asynUser* pasynUser, epicsFloat64* value, size_t nElements, size_t* nIn)
 {
   const int param_idx = pasynUser->reason;
-  auto data_found = arrays_->getArray1D(
-    param_idx,
-    asynParamFloat64Array,
-    [this, value, nElements, nIn](void* data, std::size_t bytelen) {
-      auto elements_to_copy = std::min(bytelen/sizeof(double), nElements);
-      *nIn = elements_to_copy;
-      memcpy(value, data, elements_to_copy * sizeof(double));
-    }
-  );
-  if (data_found) {
+  auto s = arrays_->getArray1D(param_idx, asynParamFloat64Array);
+  if (!s) {
+    *nIn = 0; // no data, return empty array
     return asynSuccess;
   }
-  *nIn = 0; // no data, return empty array
+  *nIn = std::min(s->size()/sizeof(*value), nElements);
+  memcpy(value, s->data(), *nIn * sizeof(*value));
   return asynSuccess;
 }
 
@@ -379,6 +395,10 @@ dldDetectorv2::dldDetectorv2(
   libusr_.linkParam(ADSizeY, asynParamInt32, "SizeY");
 
 
+  worker_.setErrorHandler([this](const char* msg) {
+    asynPrint(pasynUserSelf, ASYN_TRACE_ERROR,
+              "%s: exception in a worker task: %s\n", driverName, msg);
+  });
   std::unique_ptr<ADUpdateConsumer> upd_cons_{new ADUpdateConsumer(this)};
   arrays_ = &(upd_cons_->arrays());
   libusr_.setUpdateConsumer(std::move(upd_cons_));
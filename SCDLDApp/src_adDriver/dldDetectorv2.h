@@ -29,6 +29,12 @@ public:
     asynUser *pasynUser, const char *value, size_t nChars,
     size_t *nActual) override;
 
+  virtual asynStatus writeInt32Array(
+    asynUser *pasynUser, epicsInt32 *value, size_t nElements) override;
+
+  virtual asynStatus writeFloat64Array(
+    asynUser *pasynUser, epicsFloat64 *value, size_t nElements) override;
+
   virtual asynStatus readInt8Array(
     asynUser *pasynUser, epicsInt8 *value, size_t nElements, size_t *nIn)
     override;
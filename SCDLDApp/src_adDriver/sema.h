@@ -8,6 +8,7 @@
 
 #include <atomic>
 #include <cassert>
+#include <cstdint>
 
 
 #if defined(_WIN32)
@@ -44,6 +45,16 @@ public:
         WaitForSingleObject(m_hSema, INFINITE);
     }
 
+    bool tryWait()
+    {
+        return WaitForSingleObject(m_hSema, 0) == WAIT_OBJECT_0;
+    }
+
+    bool timedWait(std::uint64_t usecs)
+    {
+        return WaitForSingleObject(m_hSema, (DWORD)((usecs + 999) / 1000)) == WAIT_OBJECT_0;
+    }
+
     void signal(int count = 1)
     {
         ReleaseSemaphore(m_hSema, count, NULL);
@@ -84,6 +95,19 @@ public:
         semaphore_wait(m_sema);
     }
 
+    bool tryWait()
+    {
+        return timedWait(0);
+    }
+
+    bool timedWait(std::uint64_t usecs)
+    {
+        mach_timespec_t ts;
+        ts.tv_sec = (unsigned int)(usecs / 1000000);
+        ts.tv_nsec = (int)((usecs % 1000000) * 1000);
+        return semaphore_timedwait(m_sema, ts) == KERN_SUCCESS;
+    }
+
     void signal()
     {
         semaphore_signal(m_sema);
@@ -105,6 +129,9 @@ public:
 //---------------------------------------------------------
 
 #include <semaphore.h>
+#include <cerrno>
+#include <ctime>
+#include <chrono>
 
 class Semaphore
 {
@@ -114,6 +141,13 @@ private:
     Semaphore(const Semaphore& other) = delete;
     Semaphore& operator=(const Semaphore& other) = delete;
 
+    static void addUsecs(struct timespec& ts, std::uint64_t usecs)
+    {
+        const std::uint64_t nsecs = (std::uint64_t)ts.tv_nsec + (usecs % 1000000) * 1000;
+        ts.tv_sec += (time_t)(usecs / 1000000 + nsecs / 1000000000);
+        ts.tv_nsec = (long)(nsecs % 1000000000);
+    }
+
 public:
     Semaphore(int initialCount = 0)
     {
@@ -137,6 +171,56 @@ public:
         while (rc == -1 && errno == EINTR);
     }
 
+    bool tryWait()
+    {
+        int rc;
+        do
+        {
+            rc = sem_trywait(&m_sema);
+        }
+        while (rc == -1 && errno == EINTR);
+        return rc == 0;
+    }
+
+    bool timedWait(std::uint64_t usecs)
+    {
+#if defined(__USE_GNU) && defined(__GLIBC__) && \
+    (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 30))
+        // the callers compute the timeout from steady_clock deadlines, so
+        // the absolute time must not follow jumps of the wall clock
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        addUsecs(ts, usecs);
+        int rc;
+        do
+        {
+            rc = sem_clockwait(&m_sema, CLOCK_MONOTONIC, &ts);
+        }
+        while (rc == -1 && errno == EINTR);
+        return rc == 0;
+#else
+        // sem_timedwait takes an absolute time of CLOCK_REALTIME, which may
+        // jump: wait again for the rest of the steady_clock timeout
+        const std::chrono::steady_clock::time_point deadline =
+            std::chrono::steady_clock::now() + std::chrono::microseconds(usecs);
+        while (true)
+        {
+            struct timespec ts;
+            clock_gettime(CLOCK_REALTIME, &ts);
+            addUsecs(ts, usecs);
+            const int rc = sem_timedwait(&m_sema, &ts);
+            if (rc == 0)
+                return true;
+            if (errno != EINTR && errno != ETIMEDOUT)
+                return false;
+            const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+            if (now >= deadline)
+                return false;
+            usecs = (std::uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(deadline - now).count();
+        }
+#endif
+    }
+
     void signal()
     {
         sem_post(&m_sema);
@@ -168,7 +252,8 @@ private:
     std::atomic<int> m_count;
     Semaphore m_sema;
 
-    void waitWithPartialSpinning()
+    // timeout_usecs < 0: without timeout
+    bool waitWithPartialSpinning(std::int64_t timeout_usecs = -1)
     {
         int oldCount;
         // Is there a better way to set the initial spin count?
@@ -179,13 +264,28 @@ private:
         {
             oldCount = m_count.load(std::memory_order_relaxed);
             if ((oldCount > 0) && m_count.compare_exchange_strong(oldCount, oldCount - 1, std::memory_order_acquire))
-                return;
+                return true;
             std::atomic_signal_fence(std::memory_order_acquire);     // Prevent the compiler from collapsing the loop.
         }
         oldCount = m_count.fetch_sub(1, std::memory_order_acquire);
-        if (oldCount <= 0)
+        if (oldCount > 0)
+            return true;
+        if (timeout_usecs < 0)
         {
             m_sema.wait();
+            return true;
+        }
+        if (timeout_usecs > 0 && m_sema.timedWait((std::uint64_t)timeout_usecs))
+            return true;
+        // Timed out, but the count is still decremented for us. Undo that,
+        // unless a signal has arrived for us in the meantime.
+        while (true)
+        {
+            oldCount = m_count.load(std::memory_order_acquire);
+            if (oldCount >= 0 && m_sema.tryWait())
+                return true;
+            if (oldCount < 0 && m_count.compare_exchange_strong(oldCount, oldCount + 1, std::memory_order_relaxed))
+                return false;
         }
     }
 
@@ -207,6 +307,12 @@ public:
             waitWithPartialSpinning();
     }
 
+    // false if the timeout has expired without a signal
+    bool wait(std::int64_t timeout_usecs)
+    {
+        return tryWait() || waitWithPartialSpinning(timeout_usecs);
+    }
+
     void signal(int count = 1)
     {
         int oldCount = m_count.fetch_add(count, std::memory_order_release);
@@ -3,10 +3,11 @@
 #include "DLD.hpp"
 #include <string>
 #include <thread>
-#include <future>
+#include <algorithm>
 
 #include <scTDC.h>              // scTDC SDK
 #include <scTDC_error_codes.h>  // scTDC SDK
+#include "HistoConvert.hpp"
 
 #include <iostream>
 
@@ -30,20 +31,20 @@ enum DetectorStateEnum : int {
 };
 
 namespace {
-template <class F>
-void call_async(F&& fun) {
-    auto futptr = std::make_shared<std::future<void>>();
-    *futptr = std::async(std::launch::async, [futptr, fun]() {
-        fun();
-    });
-}
+// length of the hardware measurement in the gapless mode, which is restarted
+// when it runs out (with a short gap, the incomplete frame is discarded)
+const int GAPLESS_MEASUREMENT_MS = 24 * 3600 * 1000;
 }
 
 DLD::DLD()
   : Glue(this),
     dev_desc_(-1),
-    timehisto_(timebin_)
+    timehisto_(timebin_),
+    imagexyt_(timebin_, liveimagexy_, timehisto_)
 {
+  worker_.setErrorHandler([this](const char* msg) {
+    update_StatusMessage(std::string("internal error: ") + msg);
+  });
   configure_pipes();
 }
 
@@ -56,6 +57,7 @@ DLD::Data::Data()
     image_mode(IMAGEMODE_SINGLE),
     num_images(1),
     image_counter(0),
+    gapless_frames(0),
     detector_state(DETECTORSTATE_DISCONNECTED),
     ratemeter_max(0),
     sizeT(100),
@@ -166,10 +168,20 @@ int DLD::write_Acquire(int v)
   if (data_.acquire == 0 && v == 1 && data_.initialized == 1) {
     data_.image_counter = 0;
     user_stop_request_ = false;
+    gapless_ = data_.gapless_frames == 1 &&
+               data_.image_mode != IMAGEMODE_SINGLE;
+    liveimagexy_.setPublishing(!gapless_);
+    timehisto_.setPublishing(!gapless_);
+    imagexyt_.setPublishing(!gapless_);
+    frameslicer_.stop(); // gated views of the previous acquisition
     return start_measurement();
   }
   else if (data_.acquire == 1 && v == 0 && data_.initialized == 1) {
-    if (data_.image_mode == IMAGEMODE_SINGLE) {
+    if (gapless_) {
+      user_stop_request_ = true;
+      sc_tdc_interrupt2(dev_desc_);
+    }
+    else if (data_.image_mode == IMAGEMODE_SINGLE) {
       sc_tdc_interrupt2(dev_desc_); // asynchronous, do not update_Acquire yet
     }
     else {
@@ -216,6 +228,31 @@ int DLD::read_NumImagesCounter(int *dest)
   return 0;
 }
 
+int DLD::write_GaplessFrames(int v)
+{
+  // takes effect at the next start of an acquisition
+  data_.gapless_frames = v;
+  return 0;
+}
+
+int DLD::read_GaplessFrames(int *dest)
+{
+  *dest = data_.gapless_frames;
+  return 0;
+}
+
+int DLD::write_HistoThreads(int v)
+{
+  frameslicer_.setThreads(static_cast<unsigned>(std::max(0, v)));
+  return 0;
+}
+
+int DLD::read_HistoThreads(int *dest)
+{
+  *dest = static_cast<int>(frameslicer_.threads());
+  return 0;
+}
+
 int DLD::write_BinX(int v)
 {
   liveimagexy_.setBinX(v);
@@ -358,6 +395,7 @@ int DLD::write_H5EventsActive(int v)
 {
   hdf5stream_.setActive(v);
   update_H5EventsFileError(hdf5stream_.fileError());
+  publish_hdf5stream_stats();
   return 0;
 }
 
@@ -373,6 +411,113 @@ int DLD::read_H5EventsFileError(int *dest)
   return 0;
 }
 
+int DLD::write_H5EventsPageSize(int v)
+{
+  hdf5stream_.setPageSize(v);
+  return 0;
+}
+
+int DLD::read_H5EventsPageSize(int *dest)
+{
+  *dest = hdf5stream_.pageSize();
+  return 0;
+}
+
+int DLD::write_H5EventsChunkSize(int v)
+{
+  hdf5stream_.setChunkSize(v);
+  return 0;
+}
+
+int DLD::read_H5EventsChunkSize(int *dest)
+{
+  *dest = hdf5stream_.chunkSize();
+  return 0;
+}
+
+int DLD::write_H5EventsChunkCache(int v)
+{
+  hdf5stream_.setChunkCacheMiB(v);
+  return 0;
+}
+
+int DLD::read_H5EventsChunkCache(int *dest)
+{
+  *dest = hdf5stream_.chunkCacheMiB();
+  return 0;
+}
+
+int DLD::write_H5EventsCompression(int v)
+{
+  return hdf5stream_.setCompression(v);
+}
+
+int DLD::read_H5EventsCompression(int *dest)
+{
+  *dest = hdf5stream_.compression();
+  return 0;
+}
+
+int DLD::write_H5EventsPackLevel(int v)
+{
+  hdf5stream_.setPackLevel(v);
+  return 0;
+}
+
+int DLD::read_H5EventsPackLevel(int *dest)
+{
+  *dest = hdf5stream_.packLevel();
+  return 0;
+}
+
+int DLD::write_H5EventsRawCapture(int v)
+{
+  hdf5stream_.setRawCapture(v);
+  return 0;
+}
+
+int DLD::read_H5EventsRawCapture(int *dest)
+{
+  *dest = hdf5stream_.rawCapture();
+  return 0;
+}
+
+int DLD::write_H5EventsRotateMiB(int v)
+{
+  hdf5stream_.setRotateMiB(v);
+  return 0;
+}
+
+int DLD::read_H5EventsRotateMiB(int *dest)
+{
+  *dest = hdf5stream_.rotateMiB();
+  return 0;
+}
+
+int DLD::write_H5EventsRotateSeconds(int v)
+{
+  hdf5stream_.setRotateSeconds(v);
+  return 0;
+}
+
+int DLD::read_H5EventsRotateSeconds(int *dest)
+{
+  *dest = hdf5stream_.rotateSeconds();
+  return 0;
+}
+
+int DLD::write_H5EventsVDSMaster(int v)
+{
+  hdf5stream_.setVDSMaster(v);
+  return 0;
+}
+
+int DLD::read_H5EventsVDSMaster(int *dest)
+{
+  *dest = hdf5stream_.vdsMaster();
+  return 0;
+}
+
 int DLD::write_LiveImageXYAccum(int v)
 {
   liveimagexy_.setAccumulate(v);
@@ -385,6 +530,98 @@ int DLD::read_LiveImageXYAccum(int *dest)
   return 0;
 }
 
+int DLD::write_LiveImageXYWindow(int v)
+{
+  liveimagexy_.setWindow(v);
+  return 0;
+}
+
+int DLD::read_LiveImageXYWindow(int *dest)
+{
+  *dest = liveimagexy_.window();
+  return 0;
+}
+
+int DLD::write_LiveImageXYAccumDepth(int v)
+{
+  liveimagexy_.setAccumDepth(v);
+  return 0;
+}
+
+int DLD::read_LiveImageXYAccumDepth(int *dest)
+{
+  *dest = liveimagexy_.accumDepth();
+  return 0;
+}
+
+int DLD::write_LiveImageXYPixelType(int v)
+{
+  liveimagexy_.setPixelType(v);
+  return 0;
+}
+
+int DLD::read_LiveImageXYPixelType(int *dest)
+{
+  *dest = liveimagexy_.pixelType();
+  return 0;
+}
+
+int DLD::read_H5EventsReceived(double *dest)
+{
+  *dest = hdf5stream_.stats().events_received;
+  return 0;
+}
+
+int DLD::read_H5EventsWritten(double *dest)
+{
+  *dest = hdf5stream_.stats().events_written;
+  return 0;
+}
+
+int DLD::read_H5EventsDropped(double *dest)
+{
+  *dest = hdf5stream_.stats().events_dropped;
+  return 0;
+}
+
+int DLD::read_H5EventsWriteRate(double *dest)
+{
+  *dest = hdf5stream_.stats().mbytes_per_s;
+  return 0;
+}
+
+int DLD::read_H5EventsRingFill(int *dest)
+{
+  *dest = hdf5stream_.stats().ring_fill;
+  return 0;
+}
+
+int DLD::read_H5EventsPushTime(double *dest)
+{
+  *dest = hdf5stream_.stats().push_seconds;
+  return 0;
+}
+
+int DLD::read_H5EventsMaxAppend(double *dest)
+{
+  *dest = hdf5stream_.stats().max_append_ms;
+  return 0;
+}
+
+void DLD::publish_hdf5stream_stats()
+{
+  HDF5Stream::Stats s = hdf5stream_.stats();
+  update_H5EventsReceived(s.events_received);
+  update_H5EventsWritten(s.events_written);
+  update_H5EventsDropped(s.events_dropped);
+  update_H5EventsWriteRate(s.mbytes_per_s);
+  update_H5EventsRingFill(s.ring_fill);
+  update_H5EventsPushTime(s.push_seconds);
+  update_H5EventsMaxAppend(s.max_append_ms);
+  if (s.file_error)
+    update_H5EventsFileError(1);
+}
+
 int DLD::write_TimeHistoAccum(int v)
 {
   timehisto_.setAccumulate(v);
@@ -397,6 +634,114 @@ int DLD::read_TimeHistoAccum(int *dest)
   return 0;
 }
 
+int DLD::write_TimeHistoWindow(int v)
+{
+  timehisto_.setWindow(v);
+  return 0;
+}
+
+int DLD::read_TimeHistoWindow(int *dest)
+{
+  *dest = timehisto_.window();
+  return 0;
+}
+
+int DLD::write_TimeHistoAccumDepth(int v)
+{
+  timehisto_.setAccumDepth(v);
+  return 0;
+}
+
+int DLD::read_TimeHistoAccumDepth(int *dest)
+{
+  *dest = timehisto_.accumDepth();
+  return 0;
+}
+
+int DLD::write_GatedImagesTSI(size_t n, const double* v)
+{
+  // pairs of start, length; takes effect at the next start of an acquisition
+  n = std::min<size_t>(n, 2 * HistoEngine::MAX_GATES) / 2 * 2;
+  gated_images_tsi_.assign(v, v + n);
+  update_GatedImagesTSI(gated_images_tsi_.size(), gated_images_tsi_.data());
+  return 0;
+}
+
+int DLD::write_GatedHistosXY(size_t n, const int* v)
+{
+  // groups of x, y, width, height
+  n = std::min<size_t>(n, 4 * HistoEngine::MAX_GATES) / 4 * 4;
+  gated_histos_xy_.assign(v, v + n);
+  update_GatedHistosXY(gated_histos_xy_.size(), gated_histos_xy_.data());
+  return 0;
+}
+
+int DLD::write_XYTCube(int v)
+{
+  imagexyt_.setEnabled(v);
+  return 0;
+}
+
+int DLD::read_XYTCube(int *dest)
+{
+  *dest = imagexyt_.enabled();
+  return 0;
+}
+
+int DLD::write_XYTBinX(int v)
+{
+  imagexyt_.setBinX(v);
+  return 0;
+}
+
+int DLD::read_XYTBinX(int *dest)
+{
+  *dest = imagexyt_.binX();
+  return 0;
+}
+
+int DLD::write_XYTBinY(int v)
+{
+  imagexyt_.setBinY(v);
+  return 0;
+}
+
+int DLD::read_XYTBinY(int *dest)
+{
+  *dest = imagexyt_.binY();
+  return 0;
+}
+
+int DLD::write_XYTSizeT(int v)
+{
+  imagexyt_.setSizeT(v);
+  return 0;
+}
+
+int DLD::read_XYTSizeT(int *dest)
+{
+  *dest = imagexyt_.sizeT();
+  return 0;
+}
+
+int DLD::write_XYTMaxMiB(int v)
+{
+  imagexyt_.setMaxMiB(v);
+  return 0;
+}
+
+int DLD::read_XYTMaxMiB(int *dest)
+{
+  *dest = imagexyt_.maxMiB();
+  return 0;
+}
+
+int DLD::read_XYTSliceNs(double *dest)
+{
+  *dest = imagexyt_.sliceNs();
+  return 0;
+}
+
 int DLD::init_impl()
 {
   int ret = sc_tdc_init_inifile(data_.configfile.c_str());
@@ -414,18 +759,36 @@ void DLD::configure_pipes()
   configure_pipes_ratemeter();
   configure_pipes_liveimagexy();
   configure_pipes_timehisto();
+  configure_pipes_imagexyt();
+  configure_frameslicer();
   configure_hdf5stream();
 }
 
 void DLD::configure_pipes_liveimagexy()
 {
   liveimagexy_.setDataConsumer(
-    [this](std::size_t length, std::size_t width, int* data) {
-      update_LiveImageXY(length, width, data);
+    [this](std::size_t length, std::size_t width,
+           PipeImageXY::PixelType type, void* data)
+    {
+      switch (type) {
+      case PipeImageXY::PIXEL_UINT32:
+        update_LiveImageXY(length, width, static_cast<unsigned*>(data));
+        break;
+      case PipeImageXY::PIXEL_UINT16:
+        update_LiveImageXY(length, width, static_cast<unsigned short*>(data));
+        break;
+      case PipeImageXY::PIXEL_UINT8:
+        update_LiveImageXY(length, width, static_cast<unsigned char*>(data));
+        break;
+      default:
+        update_LiveImageXY(length, width, static_cast<int*>(data));
+        break;
+      }
     });
   created_at_init_.push_back(&liveimagexy_);
   som_listeners_.push_back(&liveimagexy_);
   eom_listeners_.push_back(&liveimagexy_);
+  frame_publishers_.push_back(&liveimagexy_);
 }
 
 void DLD::configure_pipes_ratemeter()
@@ -435,6 +798,12 @@ void DLD::configure_pipes_ratemeter()
     update_Ratemeter(length, data);
     data_.ratemeter_max = maxrate;
     update_RatemeterMax(maxrate);
+    if (length > 4) {
+      hdf5stream_.setRateHint(data[4]); // DLD event rate
+    }
+    // (the rate meter interval is a good pace for the writer statistics)
+    if (hdf5stream_.isActive())
+      publish_hdf5stream_stats();
   });
   created_at_init_.push_back(&ratemeter_);
   som_listeners_.push_back(&ratemeter_);
@@ -451,6 +820,68 @@ void DLD::configure_pipes_timehisto()
   created_at_init_.push_back(&timehisto_);
   som_listeners_.push_back(&timehisto_);
   eom_listeners_.push_back(&timehisto_);
+  frame_publishers_.push_back(&timehisto_);
+}
+
+void DLD::configure_pipes_imagexyt()
+{
+  imagexyt_.setDataConsumer(
+    [this](std::size_t length, std::size_t width, std::size_t height,
+           int* data)
+    {
+      update_XYTSliceNs(imagexyt_.sliceNs());
+      update_XYTCubeData(length, width, height, data);
+    });
+  created_at_init_.push_back(&imagexyt_);
+  som_listeners_.push_back(&imagexyt_);
+  eom_listeners_.push_back(&imagexyt_);
+  frame_publishers_.push_back(&imagexyt_);
+}
+
+void DLD::configure_frameslicer()
+{
+  frameslicer_.setFrameConsumer([this](PipeFrameSlicer::FramePtr f) {
+    // called in the USER_CALLBACKS thread, which must not be held up
+    worker_.addTask([this, f]() {
+      frameslicer_.accumulate(*f);
+      // the gated views come with every frame, the images and histograms
+      // only in gapless mode (otherwise they are from the hardware pipes)
+      if (!f->gated_images->empty()) {
+        gated_images_out_.resize(f->gated_images->size());
+        histo_convert::to_int(f->gated_images->data(),
+                              gated_images_out_.data(),
+                              gated_images_out_.size());
+        update_GatedImagesXY(
+          gated_images_out_.size(), liveimagexy_.activeParams().roi.size.x,
+          gated_images_out_.data());
+      }
+      if (!f->gated_histos->empty()) {
+        gated_histos_out_.resize(f->gated_histos->size());
+        histo_convert::to_double(f->gated_histos->data(),
+                                 gated_histos_out_.data(),
+                                 gated_histos_out_.size());
+        update_GatedTimeHistos(gated_histos_out_.size(),
+                               gated_histos_out_.data());
+      }
+      if (gapless_) {
+        liveimagexy_.publish(f->image->data(), f->image->size());
+        timehisto_.publish(f->histo->data(), f->histo->size());
+        hdf5stream_.setRateHint(f->events * 1000.0 / f->ms);
+        if (hdf5stream_.isActive())
+          publish_hdf5stream_stats();
+        data_.image_counter++;
+        update_NumImagesCounter(data_.image_counter);
+        if (data_.image_mode == IMAGEMODE_MULTIPLE &&
+            data_.image_counter >= data_.num_images && !user_stop_request_)
+        {
+          user_stop_request_ = true;
+          sc_tdc_interrupt2(dev_desc_);
+        }
+      }
+      frameslicer_.recycle(f);
+    });
+  });
+  created_at_init_.push_back(&frameslicer_);
 }
 
 void DLD::configure_timebin()
@@ -475,12 +906,33 @@ void DLD::cb_measurement_complete(int reason)
   if (reason != EARLY_NOTIF) {
 
     worker_.addTask([&]() {
+      if (gapless_) {
+        // the hardware pipes are read, but only the rate meter sends data
+        for (auto& eom_listener : eom_listeners_) {
+          eom_listener->end_of_measurement();
+        }
+        if (user_stop_request_) {
+          stop_gapless();
+        }
+        else {
+          start_measurement(); // the long measurement has run out
+        }
+        return;
+      }
       for (auto& eom_listener : eom_listeners_) {
         eom_listener->end_of_measurement();
       }
+      // the pipes have swapped their buffers; the data of this measurement
+      // is sent out after the next one has been started
+      auto publish_frames = [this]() {
+        for (auto& frame_publisher : frame_publishers_) {
+          frame_publisher->publish_frame();
+        }
+      };
       data_.image_counter++;
       update_NumImagesCounter(data_.image_counter);
       if (data_.image_mode == IMAGEMODE_SINGLE) {
+        publish_frames();
         data_.acquire = 0;
         update_Acquire(0);
         update_DetectorState(DETECTORSTATE_IDLE);
@@ -492,6 +944,7 @@ void DLD::cb_measurement_complete(int reason)
             data_.image_counter >= data_.num_images)
             || user_stop_request_)
         {
+          publish_frames();
           data_.acquire = 0;
           update_Acquire(0);
           update_DetectorState(DETECTORSTATE_IDLE);
@@ -502,13 +955,12 @@ void DLD::cb_measurement_complete(int reason)
                 static_cast<int>(data_.acquire_period * 1000.0));
           if (tp <= std::chrono::steady_clock::now()) {
             start_measurement();
+            publish_frames();
           }
           else {
+            publish_frames();
             update_DetectorState(DETECTORSTATE_WAITING);
-            call_async([this, tp]() {
-              std::this_thread::sleep_until(tp);
-              start_measurement();
-            });
+            worker_.addTaskAt(tp, [this]() { start_measurement(); });
           }
         }
       }
@@ -524,9 +976,49 @@ void DLD::cb_static_measurement_complete(void *priv, int reason)
 int DLD::start_measurement()
 {
   auto time_ms = static_cast<int>(data_.exposure * 1000.0);
+  if (gapless_) {
+    time_ms = GAPLESS_MEASUREMENT_MS;
+  }
   for (auto& som_listener : som_listeners_) {
     som_listener->start_of_measurement(time_ms);
   }
+  if (gapless_) {
+    // after the start_of_measurement of the pipes, which applies changes of
+    // their parameters
+    unsigned long long max_frames = 0;
+    if (data_.image_mode == IMAGEMODE_MULTIPLE) {
+      max_frames = data_.num_images > data_.image_counter
+        ? static_cast<unsigned long long>(
+            data_.num_images - data_.image_counter) : 1ull;
+    }
+    int ret = frameslicer_.start(
+      liveimagexy_.activeParams(), timehisto_.activeParams(), gates(),
+      static_cast<unsigned>(std::max(1.0, data_.exposure * 1000.0 + 0.5)),
+      frame_accumulation(), max_frames);
+    if (ret < 0) {
+      char buf[ERRSTRLEN];
+      buf[0] = '\0';
+      sc_get_err_msg(ret, buf);
+      update_StatusMessage(buf);
+      stop_gapless();
+      return ret;
+    }
+  }
+  else if (!frameslicer_.active() &&
+           (!gated_images_tsi_.empty() || !gated_histos_xy_.empty()))
+  {
+    // the gated views are binned in software, one frame per measurement;
+    // the pipe stays open until the next start of an acquisition
+    int ret = frameslicer_.start(
+      liveimagexy_.activeParams(), timehisto_.activeParams(), gates(), 0,
+      frame_accumulation(), 0);
+    if (ret < 0) {
+      char buf[ERRSTRLEN];
+      buf[0] = '\0';
+      sc_get_err_msg(ret, buf);
+      update_StatusMessage(buf);
+    }
+  }
   last_acq_start_ = std::chrono::steady_clock::now();
   // start acquisition
   int ret = sc_tdc_start_measure2(dev_desc_, time_ms);
@@ -548,6 +1040,65 @@ int DLD::start_measurement()
     buf[0] = '\0';
     sc_get_err_msg(ret, buf);
     update_StatusMessage(buf);
+    if (gapless_) {
+      stop_gapless();
+    }
   }
   return ret;
 }
+
+HistoEngine::Gates DLD::gates() const
+{
+  HistoEngine::Gates g;
+  const double binsize = timebin_(); // ns
+  auto to_bins = [binsize](double t) {
+    return static_cast<unsigned long long>(std::max(0.0, t / binsize + 0.5));
+  };
+  auto to_pixels = [](int v) {
+    return static_cast<unsigned long long>(std::max(0, v));
+  };
+  g.ntime = static_cast<unsigned>(gated_images_tsi_.size() / 2);
+  for (unsigned i = 0; i < g.ntime; i++) {
+    g.t0[i] = to_bins(gated_images_tsi_[2 * i]);
+    g.tw[i] = to_bins(gated_images_tsi_[2 * i + 1]);
+  }
+  g.nxy = static_cast<unsigned>(gated_histos_xy_.size() / 4);
+  for (unsigned i = 0; i < g.nxy; i++) {
+    g.x0[i] = to_pixels(gated_histos_xy_[4 * i]);
+    g.y0[i] = to_pixels(gated_histos_xy_[4 * i + 1]);
+    g.xw[i] = to_pixels(gated_histos_xy_[4 * i + 2]);
+    g.yw[i] = to_pixels(gated_histos_xy_[4 * i + 3]);
+  }
+  return g;
+}
+
+PipeFrameSlicer::Accumulate DLD::frame_accumulation() const
+{
+  PipeFrameSlicer::Accumulate a;
+  a.image = liveimagexy_.accumulatesFrames();
+  a.histo = timehisto_.accumulatesFrames();
+  // the gated views are always summed up in the 32 bit frame buffers
+  a.gated_images =
+    liveimagexy_.accumulate() == 1 && liveimagexy_.window() == 0;
+  a.gated_histos = timehisto_.accumulate() == 1 && timehisto_.window() == 0;
+  return a;
+}
+
+void DLD::stop_gapless()
+{
+  frameslicer_.stop(); // the incomplete frame is discarded
+  if (frameslicer_.framesDropped() > 0) {
+    char buf[ERRSTRLEN];
+    snprintf(buf, sizeof(buf),
+             "%llu frames merged into the next (not consumed in time)",
+             frameslicer_.framesDropped());
+    update_StatusMessage(buf);
+  }
+  gapless_ = false;
+  liveimagexy_.setPublishing(true);
+  timehisto_.setPublishing(true);
+  imagexyt_.setPublishing(true);
+  data_.acquire = 0;
+  update_Acquire(0);
+  update_DetectorState(DETECTORSTATE_IDLE);
+}
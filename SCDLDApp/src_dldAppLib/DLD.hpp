@@ -10,6 +10,8 @@
 #include "PipeRatemeter.hpp"
 #include "PipeImageXY.hpp"
 #include "PipeTimeHisto.hpp"
+#include "PipeImageXYT.hpp"
+#include "PipeFrameSlicer.hpp"
 #include "TimeBin.hpp"
 #include "iDisconnectListener.hpp"
 #include "HDF5Stream.hpp"
@@ -26,6 +28,7 @@ class DLD : public Glue<DLD>
     int image_mode;
     int num_images;
     int image_counter;
+    int gapless_frames;
     int detector_state;
     int ratemeter_max;
     int sizeT;
@@ -52,6 +55,10 @@ public:
   int write_NumImages(int);
   int read_NumImages(int*);
   int read_NumImagesCounter(int*);
+  int write_GaplessFrames(int);
+  int read_GaplessFrames(int*);
+  int write_HistoThreads(int);
+  int read_HistoThreads(int*);
   int write_BinX(int);
   int read_BinX(int*);
   int write_BinY(int);
@@ -78,10 +85,58 @@ public:
   int write_H5EventsActive(int);
   int read_H5EventsActive(int*);
   int read_H5EventsFileError(int*);
+  int write_H5EventsPageSize(int);
+  int read_H5EventsPageSize(int*);
+  int write_H5EventsChunkSize(int);
+  int read_H5EventsChunkSize(int*);
+  int write_H5EventsChunkCache(int);
+  int read_H5EventsChunkCache(int*);
+  int write_H5EventsCompression(int);
+  int read_H5EventsCompression(int*);
+  int write_H5EventsPackLevel(int);
+  int read_H5EventsPackLevel(int*);
+  int write_H5EventsRawCapture(int);
+  int read_H5EventsRawCapture(int*);
+  int write_H5EventsRotateMiB(int);
+  int read_H5EventsRotateMiB(int*);
+  int write_H5EventsRotateSeconds(int);
+  int read_H5EventsRotateSeconds(int*);
+  int write_H5EventsVDSMaster(int);
+  int read_H5EventsVDSMaster(int*);
+  int read_H5EventsReceived(double*);
+  int read_H5EventsWritten(double*);
+  int read_H5EventsDropped(double*);
+  int read_H5EventsWriteRate(double*);
+  int read_H5EventsRingFill(int*);
+  int read_H5EventsPushTime(double*);
+  int read_H5EventsMaxAppend(double*);
   int write_LiveImageXYAccum(int);
   int read_LiveImageXYAccum(int*);
+  int write_LiveImageXYWindow(int);
+  int read_LiveImageXYWindow(int*);
+  int write_LiveImageXYAccumDepth(int);
+  int read_LiveImageXYAccumDepth(int*);
+  int write_LiveImageXYPixelType(int);
+  int read_LiveImageXYPixelType(int*);
   int write_TimeHistoAccum(int);
   int read_TimeHistoAccum(int*);
+  int write_TimeHistoWindow(int);
+  int read_TimeHistoWindow(int*);
+  int write_TimeHistoAccumDepth(int);
+  int read_TimeHistoAccumDepth(int*);
+  int write_GatedImagesTSI(size_t, const double*);
+  int write_GatedHistosXY(size_t, const int*);
+  int write_XYTCube(int);
+  int read_XYTCube(int*);
+  int write_XYTBinX(int);
+  int read_XYTBinX(int*);
+  int write_XYTBinY(int);
+  int read_XYTBinY(int*);
+  int write_XYTSizeT(int);
+  int read_XYTSizeT(int*);
+  int write_XYTMaxMiB(int);
+  int read_XYTMaxMiB(int*);
+  int read_XYTSliceNs(double*);
 
 
 private:
@@ -91,23 +146,39 @@ private:
   void configure_pipes_liveimagexy();
   void configure_pipes_ratemeter();
   void configure_pipes_timehisto();
+  void configure_pipes_imagexyt();
+  void configure_frameslicer();
   void configure_timebin();
   void configure_hdf5stream();
+  void publish_hdf5stream_stats();
   void cb_measurement_complete(int reason);
   static void cb_static_measurement_complete(void* priv, int reason);
   int start_measurement();
+  void stop_gapless();
+  HistoEngine::Gates gates() const;
+  PipeFrameSlicer::Accumulate frame_accumulation() const;
   // variables
   int dev_desc_;
   bool user_stop_request_ = false;
+  bool gapless_ = false; // current acquisition uses frameslicer_
   std::chrono::steady_clock::time_point last_acq_start_;
   WorkerThread worker_;
   TimeBin timebin_; // keep this above timehisto_
   PipeRatemeter ratemeter_;
   PipeImageXY liveimagexy_;
   PipeTimeHisto timehisto_;
+  PipeImageXYT imagexyt_; // keep this below liveimagexy_ and timehisto_
+  PipeFrameSlicer frameslicer_;
   HDF5Stream hdf5stream_;
+  // start, length in ns per time gate
+  std::vector<double> gated_images_tsi_;
+  // x, y, width, height in detector pixels per XY gate
+  std::vector<int> gated_histos_xy_;
+  std::vector<int> gated_images_out_;
+  std::vector<double> gated_histos_out_;
   std::vector<iCreatedAtInit*> created_at_init_;
   std::vector<iEndOfMeasListener*> eom_listeners_;
   std::vector<iStartOfMeasListener*> som_listeners_;
   std::vector<iDisconnectListener*> disconnect_listeners_;
+  std::vector<iFramePublisher*> frame_publishers_;
 };
@@ -0,0 +1,78 @@
+/* Copyright 2022 Surface Concept GmbH */
+#include "FramePool.hpp"
+#include <algorithm>
+
+FramePool::FramePool(std::size_t max_free)
+  : max_free_(max_free), thread_([this]() { run_(); })
+{
+}
+
+FramePool::~FramePool()
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    quit_ = true;
+  }
+  cv_.notify_all();
+  thread_.join();
+}
+
+void FramePool::setLength(std::size_t n)
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (n == length_)
+    return;
+  length_ = n;
+  free_.clear();
+}
+
+std::size_t FramePool::length() const
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  return length_;
+}
+
+FramePool::Buffer FramePool::take()
+{
+  std::size_t n;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!free_.empty()) {
+      Buffer b = free_.back();
+      free_.pop_back();
+      return b;
+    }
+    n = length_;
+  }
+  return std::make_shared<std::vector<unsigned>>(n, 0u);
+}
+
+void FramePool::recycle(FramePool::Buffer b)
+{
+  if (!b)
+    return;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (b->size() != length_ || free_.size() + to_zero_.size() >= max_free_)
+      return; // dropped
+    to_zero_.push_back(b);
+  }
+  cv_.notify_one();
+}
+
+void FramePool::run_()
+{
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (true) {
+    cv_.wait(lock, [this]() { return quit_ || !to_zero_.empty(); });
+    if (quit_)
+      break;
+    Buffer b = to_zero_.front();
+    to_zero_.pop_front();
+    lock.unlock();
+    std::fill(b->begin(), b->end(), 0u);
+    lock.lock();
+    if (b->size() == length_)
+      free_.push_back(b);
+  }
+}
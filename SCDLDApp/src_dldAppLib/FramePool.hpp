@@ -0,0 +1,53 @@
+#ifndef FRAMEPOOL_HPP
+#define FRAMEPOOL_HPP
+
+/* Copyright 2022 Surface Concept GmbH */
+
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief The FramePool class keeps histogram buffers of one length for reuse,
+ * such that a new measurement can fill a buffer while the previous one is
+ * still being published. Buffers passed to recycle() are zeroed on a
+ * background thread, so take() normally returns a buffer without touching
+ * its memory. If no zeroed buffer is available, take() allocates one.
+ */
+class FramePool
+{
+public:
+  typedef std::shared_ptr<std::vector<unsigned>> Buffer;
+
+  /** @param max_free number of zeroed buffers kept for reuse */
+  explicit FramePool(std::size_t max_free = 2);
+  ~FramePool();
+
+  FramePool(const FramePool&) = delete;
+  FramePool& operator=(const FramePool&) = delete;
+
+  /** set the number of elements per buffer, drops buffers of other lengths */
+  void setLength(std::size_t);
+  std::size_t length() const;
+  /** a zeroed buffer of length() elements */
+  Buffer take();
+  /** return a buffer once it is no longer used */
+  void recycle(Buffer);
+
+private:
+  void run_();
+
+  const std::size_t max_free_;
+  mutable std::mutex mutex_;
+  std::condition_variable cv_;
+  std::size_t length_ = 0;
+  std::vector<Buffer> free_;     // zeroed
+  std::deque<Buffer> to_zero_;
+  bool quit_ = false;
+  std::thread thread_;
+};
+
+#endif // FRAMEPOOL_HPP
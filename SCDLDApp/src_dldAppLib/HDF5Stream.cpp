@@ -66,6 +66,125 @@ std::string HDF5Stream::userComment() const
   return comment_;
 }
 
+void HDF5Stream::setPageSize(int v)
+{
+  page_size_ = v;
+  sc_tdc_hdf5_cfg_pagesize(hdf5obj_, static_cast<unsigned long long>(v));
+}
+
+int HDF5Stream::pageSize() const
+{
+  return page_size_;
+}
+
+void HDF5Stream::setChunkSize(int v)
+{
+  chunk_size_ = v;
+  sc_tdc_hdf5_cfg_chunksize(hdf5obj_, static_cast<unsigned long long>(v));
+}
+
+int HDF5Stream::chunkSize() const
+{
+  return chunk_size_;
+}
+
+void HDF5Stream::setChunkCacheMiB(int v)
+{
+  chunk_cache_mib_ = v;
+  sc_tdc_hdf5_cfg_chunkcache(hdf5obj_,
+    static_cast<unsigned long long>(v) * 1024ull * 1024ull);
+}
+
+int HDF5Stream::chunkCacheMiB() const
+{
+  return chunk_cache_mib_;
+}
+
+int HDF5Stream::setCompression(int v)
+{
+  // fails if the codec is not compiled into the add-on library
+  auto retcode = sc_tdc_hdf5_cfg_compression(
+    hdf5obj_, static_cast<unsigned>(v), pack_level_);
+  if (retcode == 0)
+    codec_ = v;
+  return retcode;
+}
+
+int HDF5Stream::compression() const
+{
+  return codec_;
+}
+
+void HDF5Stream::setPackLevel(int v)
+{
+  pack_level_ = v;
+  sc_tdc_hdf5_cfg_compression(hdf5obj_, static_cast<unsigned>(codec_), v);
+}
+
+int HDF5Stream::packLevel() const
+{
+  return pack_level_;
+}
+
+void HDF5Stream::setRateHint(double v)
+{
+  // used for the automatic chunk size, comes into effect at the next
+  // activation
+  sc_tdc_hdf5_cfg_ratehint(hdf5obj_, v);
+}
+
+void HDF5Stream::setRawCapture(int v)
+{
+  static const unsigned long long PREALLOC_BYTES = 1ull << 30;
+  raw_capture_ = v;
+  sc_tdc_hdf5_cfg_rawcapture(hdf5obj_, v, PREALLOC_BYTES);
+}
+
+int HDF5Stream::rawCapture() const
+{
+  return raw_capture_;
+}
+
+void HDF5Stream::setRotateMiB(int v)
+{
+  rotate_mib_ = v;
+  cfgRotation();
+}
+
+int HDF5Stream::rotateMiB() const
+{
+  return rotate_mib_;
+}
+
+void HDF5Stream::setRotateSeconds(int v)
+{
+  rotate_seconds_ = v;
+  cfgRotation();
+}
+
+int HDF5Stream::rotateSeconds() const
+{
+  return rotate_seconds_;
+}
+
+void HDF5Stream::setVDSMaster(int v)
+{
+  vds_master_ = v;
+  cfgRotation();
+}
+
+int HDF5Stream::vdsMaster() const
+{
+  return vds_master_;
+}
+
+void HDF5Stream::cfgRotation()
+{
+  sc_tdc_hdf5_cfg_rotation(hdf5obj_,
+    static_cast<unsigned long long>(rotate_mib_) * 1024ull * 1024ull, 0,
+    static_cast<double>(rotate_seconds_), vds_master_);
+}
+
 int HDF5Stream::setActive(int v)
 {
   auto retcode = sc_tdc_hdf5_setactive(hdf5obj_, v);
@@ -78,6 +197,25 @@ int HDF5Stream::isActive() const
   return sc_tdc_hdf5_isactive(hdf5obj_);
 }
 
+HDF5Stream::Stats HDF5Stream::stats() const
+{
+  Stats r;
+  struct sc_tdc_hdf5_stats s;
+  if (sc_tdc_hdf5_get_stats(hdf5obj_, &s) < 0)
+    return r;
+  r.events_received = static_cast<double>(s.events_received);
+  r.events_written = static_cast<double>(s.events_written);
+  r.events_dropped = static_cast<double>(s.events_dropped);
+  r.mbytes_per_s = s.mbytes_per_s;
+  r.ring_fill = static_cast<int>(s.ring_fill);
+  r.push_seconds = s.push_seconds;
+  r.max_append_ms = s.max_append_ms;
+  r.file_error = s.file_error;
+  if (s.file_error)
+    file_error_ = 1;
+  return r;
+}
+
 int HDF5Stream::fileError() const
 {
   return file_error_;
@@ -9,6 +9,18 @@
 class HDF5Stream : public iCreatedAtInit, public iDisconnectListener
 {
 public:
+  // health counters of the writer (see sc_tdc_hdf5_get_stats)
+  struct Stats {
+    double events_received = 0.0;
+    double events_written = 0.0;
+    double events_dropped = 0.0;
+    double mbytes_per_s = 0.0;
+    int ring_fill = 0;
+    double push_seconds = 0.0;
+    double max_append_ms = 0.0;
+    int file_error = 0;
+  };
+
   HDF5Stream();
   virtual ~HDF5Stream();
   int create(int dev_desc) override;
@@ -17,14 +29,44 @@ public:
   std::string filePath() const;
   void setUserComment(const std::string&);
   std::string userComment() const;
+  void setPageSize(int);
+  int pageSize() const;
+  void setChunkSize(int);
+  int chunkSize() const;
+  void setChunkCacheMiB(int);
+  int chunkCacheMiB() const;
+  int setCompression(int);
+  int compression() const;
+  void setPackLevel(int);
+  int packLevel() const;
+  void setRateHint(double);
+  void setRawCapture(int);
+  int rawCapture() const;
+  void setRotateMiB(int);
+  int rotateMiB() const;
+  void setRotateSeconds(int);
+  int rotateSeconds() const;
+  void setVDSMaster(int);
+  int vdsMaster() const;
   int setActive(int);
   int isActive() const;
   int fileError() const;
+  Stats stats() const;
 
 private:
   int hdf5obj_ = -1;
   int active_ = 0;
-  int file_error_ = 0;
+  mutable int file_error_ = 0; // also set by stats() on a write error
   std::string filepath_;
   std::string comment_;
+  int page_size_ = 262144;
+  int chunk_size_ = 0;
+  int chunk_cache_mib_ = 0;
+  int codec_ = 0;
+  int pack_level_ = 0;
+  int raw_capture_ = 0;
+  int rotate_mib_ = 0;
+  int rotate_seconds_ = 0;
+  int vds_master_ = 0;
+  void cfgRotation();
 };
@@ -0,0 +1,203 @@
+/* Copyright 2022 Surface Concept GmbH */
+#include "HistoConvert.hpp"
+
+#include <climits>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace histo_convert
+{
+
+void to_int(const unsigned* src, int* dst, std::size_t n)
+{
+  std::size_t i = 0;
+#ifdef __SSE2__
+  const __m128i max = _mm_set1_epi32(INT_MAX);
+  for (; i + 4 <= n; i += 4) {
+    const __m128i v =
+      _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+    // all bits set where the sign bit is set, i.e. above INT_MAX
+    const __m128i over = _mm_srai_epi32(v, 31);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i),
+                     _mm_or_si128(_mm_andnot_si128(over, v),
+                                  _mm_and_si128(over, max)));
+  }
+#endif
+  for (; i < n; i++)
+    dst[i] = src[i] > INT_MAX ? INT_MAX : static_cast<int>(src[i]);
+}
+
+void to_int(const unsigned long long* src, int* dst, std::size_t n)
+{
+  std::size_t i = 0;
+#ifdef __SSE2__
+  const __m128i max = _mm_set1_epi32(INT_MAX);
+  const __m128i zero = _mm_setzero_si128();
+  for (; i + 4 <= n; i += 4) {
+    const __m128 a = _mm_castsi128_ps(
+      _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i)));
+    const __m128 b = _mm_castsi128_ps(
+      _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i + 2)));
+    // the lower and upper 32 bits of the four elements
+    const __m128i lo = _mm_castps_si128(_mm_shuffle_ps(a, b, 0x88));
+    const __m128i hi = _mm_castps_si128(_mm_shuffle_ps(a, b, 0xDD));
+    const __m128i over = _mm_or_si128(
+      _mm_andnot_si128(_mm_cmpeq_epi32(hi, zero), _mm_set1_epi32(-1)),
+      _mm_srai_epi32(lo, 31));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i),
+                     _mm_or_si128(_mm_andnot_si128(over, lo),
+                                  _mm_and_si128(over, max)));
+  }
+#endif
+  for (; i < n; i++)
+    dst[i] = src[i] > INT_MAX ? INT_MAX : static_cast<int>(src[i]);
+}
+
+void to_unsigned(const unsigned long long* src, unsigned* dst, std::size_t n)
+{
+  std::size_t i = 0;
+#ifdef __SSE2__
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i ones = _mm_set1_epi32(-1);
+  for (; i + 4 <= n; i += 4) {
+    const __m128 a = _mm_castsi128_ps(
+      _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i)));
+    const __m128 b = _mm_castsi128_ps(
+      _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i + 2)));
+    const __m128i lo = _mm_castps_si128(_mm_shuffle_ps(a, b, 0x88));
+    const __m128i hi = _mm_castps_si128(_mm_shuffle_ps(a, b, 0xDD));
+    const __m128i over = _mm_andnot_si128(_mm_cmpeq_epi32(hi, zero), ones);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i),
+                     _mm_or_si128(lo, over));
+  }
+#endif
+  for (; i < n; i++)
+    dst[i] = src[i] > UINT_MAX ? UINT_MAX : static_cast<unsigned>(src[i]);
+}
+
+#ifdef __SSE2__
+namespace {
+  // min(v, max) for unsigned 32 bit values, with max below 2^31. SSE2 only
+  // compares signed values, so both sides get their sign bit flipped.
+  inline __m128i min_epu32(__m128i v, __m128i max)
+  {
+    const __m128i flip = _mm_set1_epi32(INT_MIN);
+    const __m128i over = _mm_cmpgt_epi32(_mm_xor_si128(v, flip),
+                                         _mm_xor_si128(max, flip));
+    return _mm_or_si128(_mm_andnot_si128(over, v), _mm_and_si128(over, max));
+  }
+}
+#endif
+
+void to_ushort(const unsigned* src, unsigned short* dst, std::size_t n)
+{
+  std::size_t i = 0;
+#ifdef __SSE2__
+  const __m128i max = _mm_set1_epi32(USHRT_MAX);
+  // _mm_packs_epi32 saturates signed values, so the range is shifted by
+  // 2^15 before packing and back afterwards
+  const __m128i shift32 = _mm_set1_epi32(0x8000);
+  const __m128i shift16 = _mm_set1_epi16(static_cast<short>(0x8000));
+  for (; i + 8 <= n; i += 8) {
+    const __m128i* s = reinterpret_cast<const __m128i*>(src + i);
+    const __m128i a = _mm_sub_epi32(min_epu32(_mm_loadu_si128(s), max),
+                                    shift32);
+    const __m128i b = _mm_sub_epi32(min_epu32(_mm_loadu_si128(s + 1), max),
+                                    shift32);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i),
+                     _mm_xor_si128(_mm_packs_epi32(a, b), shift16));
+  }
+#endif
+  for (; i < n; i++) {
+    dst[i] = src[i] > USHRT_MAX ? USHRT_MAX
+                                : static_cast<unsigned short>(src[i]);
+  }
+}
+
+void to_uchar(const unsigned* src, unsigned char* dst, std::size_t n)
+{
+  std::size_t i = 0;
+#ifdef __SSE2__
+  const __m128i max = _mm_set1_epi32(UCHAR_MAX);
+  for (; i + 16 <= n; i += 16) {
+    const __m128i* s = reinterpret_cast<const __m128i*>(src + i);
+    // after the min, neither packing step saturates
+    const __m128i ab = _mm_packs_epi32(min_epu32(_mm_loadu_si128(s), max),
+                                       min_epu32(_mm_loadu_si128(s + 1), max));
+    const __m128i cd = _mm_packs_epi32(min_epu32(_mm_loadu_si128(s + 2), max),
+                                       min_epu32(_mm_loadu_si128(s + 3), max));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i),
+                     _mm_packus_epi16(ab, cd));
+  }
+#endif
+  for (; i < n; i++) {
+    dst[i] = src[i] > UCHAR_MAX ? UCHAR_MAX
+                                : static_cast<unsigned char>(src[i]);
+  }
+}
+
+void to_double(const unsigned* src, double* dst, std::size_t n)
+{
+  std::size_t i = 0;
+#ifdef __SSE2__
+  // SSE2 only converts signed values: flip the sign bit, convert, add 2^31
+  const __m128i flip = _mm_set1_epi32(INT_MIN);
+  const __m128d offset = _mm_set1_pd(2147483648.0);
+  for (; i + 4 <= n; i += 4) {
+    const __m128i v = _mm_xor_si128(
+      _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i)), flip);
+    _mm_storeu_pd(dst + i, _mm_add_pd(_mm_cvtepi32_pd(v), offset));
+    _mm_storeu_pd(dst + i + 2, _mm_add_pd(
+      _mm_cvtepi32_pd(_mm_shuffle_epi32(v, 0xEE)), offset));
+  }
+#endif
+  for (; i < n; i++)
+    dst[i] = static_cast<double>(src[i]);
+}
+
+void to_double(const unsigned long long* src, double* dst, std::size_t n)
+{
+  std::size_t i = 0;
+#ifdef __SSE2__
+  // the lower and upper 32 bits are put into the mantissas of 2^52 and 2^84,
+  // the difference of both doubles minus the offsets is the value
+  const __m128i mask_lo = _mm_set1_epi64x(0xFFFFFFFFll);
+  const __m128i exp_lo = _mm_set1_epi64x(0x4330000000000000ll); // 2^52
+  const __m128i exp_hi = _mm_set1_epi64x(0x4530000000000000ll); // 2^84
+  const __m128d offset = _mm_set1_pd(19342813118337666422669312.0); // 2^84+2^52
+  for (; i + 2 <= n; i += 2) {
+    const __m128i v =
+      _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+    const __m128d lo =
+      _mm_castsi128_pd(_mm_or_si128(_mm_and_si128(v, mask_lo), exp_lo));
+    const __m128d hi =
+      _mm_castsi128_pd(_mm_or_si128(_mm_srli_epi64(v, 32), exp_hi));
+    _mm_storeu_pd(dst + i, _mm_add_pd(_mm_sub_pd(hi, offset), lo));
+  }
+#endif
+  for (; i < n; i++)
+    dst[i] = static_cast<double>(src[i]);
+}
+
+void add(unsigned long long* dst, const unsigned* src, std::size_t n)
+{
+  std::size_t i = 0;
+#ifdef __SSE2__
+  const __m128i zero = _mm_setzero_si128();
+  for (; i + 4 <= n; i += 4) {
+    __m128i* d = reinterpret_cast<__m128i*>(dst + i);
+    const __m128i v =
+      _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+    // zero extension to 64 bit
+    _mm_storeu_si128(d, _mm_add_epi64(_mm_loadu_si128(d),
+                                      _mm_unpacklo_epi32(v, zero)));
+    _mm_storeu_si128(d + 1, _mm_add_epi64(_mm_loadu_si128(d + 1),
+                                          _mm_unpackhi_epi32(v, zero)));
+  }
+#endif
+  for (; i < n; i++)
+    dst[i] += src[i];
+}
+
+} // namespace histo_convert
@@ -0,0 +1,29 @@
+#ifndef HISTOCONVERT_HPP
+#define HISTOCONVERT_HPP
+
+/* Copyright 2022 Surface Concept GmbH */
+
+#include <cstddef>
+
+/**
+ * Conversions of histogram counts into the data types of the published
+ * parameters. The narrowing conversions saturate instead of wrapping
+ * around, e.g. at 2^31 - 1 for int instead of giving negative counts. The
+ * conversions from 64 bit to double are exact below 2^53 counts.
+ */
+namespace histo_convert
+{
+  void to_int(const unsigned* src, int* dst, std::size_t n);
+  void to_int(const unsigned long long* src, int* dst, std::size_t n);
+  // saturating at the maximum of the destination type
+  void to_unsigned(const unsigned long long* src, unsigned* dst,
+                   std::size_t n);
+  void to_ushort(const unsigned* src, unsigned short* dst, std::size_t n);
+  void to_uchar(const unsigned* src, unsigned char* dst, std::size_t n);
+  void to_double(const unsigned* src, double* dst, std::size_t n);
+  void to_double(const unsigned long long* src, double* dst, std::size_t n);
+  /** dst[i] += src[i] */
+  void add(unsigned long long* dst, const unsigned* src, std::size_t n);
+}
+
+#endif // HISTOCONVERT_HPP
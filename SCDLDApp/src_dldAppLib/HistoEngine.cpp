@@ -0,0 +1,267 @@
+/* Copyright 2022 Surface Concept GmbH */
+#include "HistoEngine.hpp"
+
+#include <scTDC_types.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace {
+  // below this number of events per slice, the thread handover costs more
+  // than the binning
+  const std::size_t MIN_EVENTS_PER_PART = 8192;
+  // upper limit for the automatic number of threads
+  const unsigned AUTO_THREADS_MAX = 4;
+
+  // dst[i] += src[i]; src[i] = 0
+  void add_and_clear(unsigned* dst, unsigned* src, std::size_t n)
+  {
+    std::size_t i = 0;
+#ifdef __SSE2__
+    const __m128i zero = _mm_setzero_si128();
+    for (; i + 8 <= n; i += 8) {
+      __m128i* d = reinterpret_cast<__m128i*>(dst + i);
+      __m128i* s = reinterpret_cast<__m128i*>(src + i);
+      __m128i a0 = _mm_loadu_si128(d);
+      __m128i a1 = _mm_loadu_si128(d + 1);
+      __m128i b0 = _mm_loadu_si128(s);
+      __m128i b1 = _mm_loadu_si128(s + 1);
+      _mm_storeu_si128(d, _mm_add_epi32(a0, b0));
+      _mm_storeu_si128(d + 1, _mm_add_epi32(a1, b1));
+      _mm_storeu_si128(s, zero);
+      _mm_storeu_si128(s + 1, zero);
+    }
+#endif
+    for (; i < n; i++) {
+      dst[i] += src[i];
+      src[i] = 0;
+    }
+  }
+
+  // [begin, end) of part i of n parts of len elements
+  void stripe(std::size_t len, unsigned i, unsigned n, std::size_t* begin,
+              std::size_t* end)
+  {
+    *begin = len * i / n;
+    *end = len * (i + 1) / n;
+  }
+
+  // bit i is set if e is inside time gate i. The unsigned subtraction wraps
+  // around for values below the start, so one comparison per gate suffices.
+  inline unsigned time_mask(const HistoEngine::Gates& g, const sc_DldEvent& e)
+  {
+    unsigned m = 0;
+    for (unsigned i = 0; i < HistoEngine::MAX_GATES; i++)
+      m |= static_cast<unsigned>(e.sum - g.t0[i] < g.tw[i]) << i;
+    return m;
+  }
+
+  // bit i is set if e is inside XY gate i
+  inline unsigned xy_mask(const HistoEngine::Gates& g, const sc_DldEvent& e)
+  {
+    const unsigned long long x = e.dif1;
+    const unsigned long long y = e.dif2;
+    unsigned m = 0;
+    for (unsigned i = 0; i < HistoEngine::MAX_GATES; i++)
+      m |= static_cast<unsigned>((x - g.x0[i] < g.xw[i]) &
+                                 (y - g.y0[i] < g.yw[i])) << i;
+    return m;
+  }
+}
+
+bool HistoEngine::Binning::index(
+  const sc_DldEvent& e, bool xy, std::size_t* idx) const
+{
+  const long long bx = static_cast<long long>(e.dif1 / bin[0]) - offset[0];
+  const long long by = static_cast<long long>(e.dif2 / bin[1]) - offset[1];
+  const long long bt = static_cast<long long>(e.sum / bin[2]) - offset[2];
+  if (bx < 0 || by < 0 || bt < 0 ||
+      static_cast<unsigned long long>(bx) >= size[0] ||
+      static_cast<unsigned long long>(by) >= size[1] ||
+      static_cast<unsigned long long>(bt) >= size[2])
+    return false;
+  *idx = xy ? static_cast<std::size_t>(by * size[0] + bx)
+            : static_cast<std::size_t>(bt);
+  return true;
+}
+
+HistoEngine::HistoEngine()
+{
+
+}
+
+HistoEngine::~HistoEngine()
+{
+  stop_threads_();
+}
+
+void HistoEngine::setup(const HistoEngine::Binning& image,
+                        const HistoEngine::Binning& histo,
+                        const HistoEngine::Gates& gates, unsigned nthreads)
+{
+  if (nthreads == 0) {
+    nthreads = std::max(1u, std::min(AUTO_THREADS_MAX,
+                                     std::thread::hardware_concurrency()));
+  }
+  if (nthreads != threads()) {
+    stop_threads_();
+    shards_.resize(nthreads);
+    const unsigned long long g = generation_;
+    for (unsigned i = 1; i < nthreads; i++)
+      threads_.emplace_back([this, i, g]() { worker_(i, g); });
+  }
+  image_bins_ = image;
+  histo_bins_ = histo;
+  gates_ = gates;
+  gates_.ntime = std::min(gates_.ntime, MAX_GATES);
+  gates_.nxy = std::min(gates_.nxy, MAX_GATES);
+  for (unsigned i = gates_.ntime; i < MAX_GATES; i++)
+    gates_.tw[i] = 0;
+  for (unsigned i = gates_.nxy; i < MAX_GATES; i++)
+    gates_.xw[i] = gates_.yw[i] = 0;
+  len_[IMAGE] = static_cast<std::size_t>(image.size[0] * image.size[1]);
+  len_[HISTO] = static_cast<std::size_t>(histo.size[2]);
+  len_[GATED_IMAGES] = gates_.ntime * len_[IMAGE];
+  len_[GATED_HISTOS] = gates_.nxy * len_[HISTO];
+  for (std::size_t i = 1; i < shards_.size(); i++) {
+    Shard& s = shards_[i];
+    for (int v = 0; v < NR_VIEWS; v++) {
+      // merge() leaves the shards cleared
+      if (s.dirty || s.view[v].size() != len_[v])
+        s.view[v].assign(len_[v], 0u);
+    }
+    s.dirty = false;
+  }
+}
+
+unsigned HistoEngine::threads() const
+{
+  return static_cast<unsigned>(std::max<std::size_t>(1, shards_.size()));
+}
+
+std::size_t HistoEngine::length(HistoEngine::View v) const
+{
+  return len_[v];
+}
+
+void HistoEngine::fill(const sc_DldEvent* e, std::size_t len,
+                       const HistoEngine::Targets& t)
+{
+  events_ = e;
+  nevents_ = len;
+  targets_ = t;
+  const std::size_t n = std::min<std::size_t>(
+    threads(), len / MIN_EVENTS_PER_PART);
+  if (n <= 1)
+    part_(Job::FILL, 0, 1);
+  else
+    run_(Job::FILL, static_cast<unsigned>(n));
+}
+
+void HistoEngine::merge(const HistoEngine::Targets& t)
+{
+  bool dirty = false;
+  for (std::size_t i = 1; i < shards_.size(); i++)
+    dirty = dirty || shards_[i].dirty;
+  if (!dirty)
+    return;
+  targets_ = t;
+  run_(Job::MERGE, threads());
+  for (auto& s : shards_)
+    s.dirty = false;
+}
+
+void HistoEngine::run_(HistoEngine::Job job, unsigned nparts)
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    job_ = job;
+    nparts_ = nparts;
+    pending_ = nparts - 1;
+    generation_++;
+  }
+  cv_start_.notify_all();
+  part_(job, 0, nparts);
+  std::unique_lock<std::mutex> lock(mutex_);
+  cv_done_.wait(lock, [this]() { return pending_ == 0; });
+}
+
+void HistoEngine::part_(HistoEngine::Job job, unsigned i, unsigned nparts)
+{
+  if (job == Job::FILL) {
+    std::size_t begin, end;
+    stripe(nevents_, i, nparts, &begin, &end);
+    Targets t = targets_;
+    if (i > 0) {
+      shards_[i].dirty = true;
+      for (int v = 0; v < NR_VIEWS; v++)
+        t.view[v] = shards_[i].view[v].data();
+    }
+    const bool time_gates = gates_.ntime > 0;
+    const bool xy_gates = gates_.nxy > 0;
+    std::size_t idx;
+    for (std::size_t k = begin; k < end; k++) {
+      const sc_DldEvent& e = events_[k];
+      if (image_bins_.index(e, true, &idx)) {
+        t.view[IMAGE][idx]++;
+        if (time_gates) {
+          for (unsigned m = time_mask(gates_, e); m != 0; m &= m - 1)
+            t.view[GATED_IMAGES][__builtin_ctz(m) * len_[IMAGE] + idx]++;
+        }
+      }
+      if (histo_bins_.index(e, false, &idx)) {
+        t.view[HISTO][idx]++;
+        if (xy_gates) {
+          for (unsigned m = xy_mask(gates_, e); m != 0; m &= m - 1)
+            t.view[GATED_HISTOS][__builtin_ctz(m) * len_[HISTO] + idx]++;
+        }
+      }
+    }
+  }
+  else {
+    // every thread adds one stripe of all shards
+    for (int v = 0; v < NR_VIEWS; v++) {
+      std::size_t begin, end;
+      stripe(len_[v], i, nparts, &begin, &end);
+      for (std::size_t s = 1; s < shards_.size(); s++) {
+        if (shards_[s].dirty)
+          add_and_clear(targets_.view[v] + begin,
+                        shards_[s].view[v].data() + begin, end - begin);
+      }
+    }
+  }
+}
+
+void HistoEngine::worker_(unsigned i, unsigned long long seen)
+{
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (true) {
+    cv_start_.wait(lock, [&]() { return quit_ || generation_ != seen; });
+    if (quit_)
+      break;
+    seen = generation_;
+    const Job job = job_;
+    const unsigned nparts = nparts_;
+    if (i >= nparts)
+      continue;
+    lock.unlock();
+    part_(job, i, nparts);
+    lock.lock();
+    if (--pending_ == 0)
+      cv_done_.notify_one();
+  }
+}
+
+void HistoEngine::stop_threads_()
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    quit_ = true;
+  }
+  cv_start_.notify_all();
+  for (auto& t : threads_)
+    t.join();
+  threads_.clear();
+  shards_.clear();
+  quit_ = false;
+}
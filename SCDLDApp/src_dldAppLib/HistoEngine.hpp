@@ -0,0 +1,136 @@
+#ifndef HISTOENGINE_HPP
+#define HISTOENGINE_HPP
+
+/* Copyright 2022 Surface Concept GmbH */
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+struct sc_DldEvent;
+
+/**
+ * @brief The HistoEngine class fills an XY image and a time histogram from
+ * batches of DLD events, using several threads. Each batch is split into
+ * slices. The calling thread bins its slice directly into the target
+ * buffers, and every other thread bins into a private shard of the same
+ * size, so no atomic increments are needed. merge() adds the shards to the
+ * target buffers in parallel stripes and clears them, at the end of a frame.
+ * Small batches are binned by the calling thread alone.
+ * In the same pass over the events, the engine fills the gated views: XY
+ * images of events inside time windows, and time histograms of events inside
+ * XY regions (see Gates). Each event is compared against all gates at once,
+ * giving a bit mask of the gates that it passes.
+ * fill() and merge() must be called from one thread at a time.
+ */
+class HistoEngine
+{
+public:
+  // bin edges of one histogram, as in the scTDC pipe parameters
+  struct Binning {
+    unsigned long long bin[3] = {1, 1, 1};  // x, y, time
+    long long offset[3] = {0, 0, 0};
+    unsigned long long size[3] = {0, 0, 0};
+    template <typename P> void set(const P& p)
+    {
+      bin[0] = std::max(1ull, static_cast<unsigned long long>(p.binning.x));
+      bin[1] = std::max(1ull, static_cast<unsigned long long>(p.binning.y));
+      bin[2] = std::max(1ull, static_cast<unsigned long long>(p.binning.time));
+      offset[0] = static_cast<long long>(p.roi.offset.x);
+      offset[1] = static_cast<long long>(p.roi.offset.y);
+      offset[2] = static_cast<long long>(p.roi.offset.time);
+      size[0] = p.roi.size.x;
+      size[1] = p.roi.size.y;
+      size[2] = p.roi.size.time;
+    }
+    // true if e is inside, then *idx is the index in the histogram data
+    bool index(const sc_DldEvent& e, bool xy, std::size_t* idx) const;
+  };
+
+  static constexpr unsigned MAX_GATES = 4;
+  /**
+   * @brief gates of the additional views, in the (unbinned) units of the
+   * events; a gate of zero width or height never matches
+   */
+  struct Gates {
+    // XY images (binned as the image) of the events with
+    // t0 <= sum < t0 + tw
+    unsigned ntime = 0;
+    unsigned long long t0[MAX_GATES] = {};
+    unsigned long long tw[MAX_GATES] = {};
+    // time histograms (binned as the histogram) of the events with
+    // x0 <= dif1 < x0 + xw and y0 <= dif2 < y0 + yw
+    unsigned nxy = 0;
+    unsigned long long x0[MAX_GATES] = {};
+    unsigned long long xw[MAX_GATES] = {};
+    unsigned long long y0[MAX_GATES] = {};
+    unsigned long long yw[MAX_GATES] = {};
+  };
+
+  enum View {
+    IMAGE,          // XY layout
+    HISTO,
+    GATED_IMAGES,   // Gates::ntime images, one after the other
+    GATED_HISTOS,   // Gates::nxy histograms, one after the other
+    NR_VIEWS
+  };
+  // buffers of the views, of the lengths given by length()
+  struct Targets {
+    unsigned* view[NR_VIEWS] = {};
+  };
+
+  HistoEngine();
+  ~HistoEngine();
+  HistoEngine(const HistoEngine&) = delete;
+  HistoEngine& operator=(const HistoEngine&) = delete;
+
+  /**
+   * @brief setup set the binnings, gates and the number of threads, clears
+   * the shards. Not to be called concurrently with fill() or merge().
+   * @param nthreads 0 selects the number of threads automatically
+   */
+  void setup(const Binning& image, const Binning& histo, const Gates& gates,
+             unsigned nthreads);
+  unsigned threads() const;
+  std::size_t length(View) const;
+  /** add the events to the views, partly through the shards */
+  void fill(const sc_DldEvent* e, std::size_t len, const Targets& t);
+  /** add the contents of the shards to the views */
+  void merge(const Targets& t);
+
+private:
+  enum class Job { FILL, MERGE };
+  struct Shard {
+    std::vector<unsigned> view[NR_VIEWS];
+    bool dirty = false;
+  };
+  void run_(Job job, unsigned nparts);
+  void part_(Job job, unsigned i, unsigned nparts);
+  void worker_(unsigned i, unsigned long long seen);
+  void stop_threads_();
+
+  Binning image_bins_;
+  Binning histo_bins_;
+  Gates gates_;
+  std::size_t len_[NR_VIEWS] = {};
+  std::vector<Shard> shards_; // [0] is unused, slice 0 goes to the targets
+  std::vector<std::thread> threads_;
+  std::mutex mutex_;
+  std::condition_variable cv_start_;
+  std::condition_variable cv_done_;
+  unsigned long long generation_ = 0;
+  unsigned pending_ = 0;
+  bool quit_ = false;
+  // the current job of the threads, written before generation_ is
+  // incremented
+  Job job_ = Job::FILL;
+  unsigned nparts_ = 1;
+  const sc_DldEvent* events_ = nullptr;
+  std::size_t nevents_ = 0;
+  Targets targets_;
+};
+
+#endif // HISTOENGINE_HPP
@@ -0,0 +1,245 @@
+/* Copyright 2022 Surface Concept GmbH */
+#include "PipeFrameSlicer.hpp"
+
+#include <algorithm>
+#include <scTDC.h>
+#include <scTDC_types.h>
+
+PipeFrameSlicer::PipeFrameSlicer()
+{
+
+}
+
+PipeFrameSlicer::~PipeFrameSlicer()
+{
+  stop();
+}
+
+int PipeFrameSlicer::create(int dev_desc)
+{
+  dev_desc_ = dev_desc;
+  pipe_desc_ = -1;
+  return 0;
+}
+
+void PipeFrameSlicer::setFrameConsumer(PipeFrameSlicer::frame_consumer_t f)
+{
+  frame_consumer_ = f;
+}
+
+void PipeFrameSlicer::setThreads(unsigned n)
+{
+  threads_ = n;
+}
+
+unsigned PipeFrameSlicer::threads() const
+{
+  return threads_;
+}
+
+int PipeFrameSlicer::start(const sc_pipe_dld_image_xy_params_t& image,
+                           const sc_pipe_dld_sum_histo_params_t& histo,
+                           const HistoEngine::Gates& gates,
+                           unsigned frame_ms,
+                           const PipeFrameSlicer::Accumulate& accumulate,
+                           unsigned long long max_frames)
+{
+  stop();
+  image_bins_.set(image);
+  histo_bins_.set(histo);
+  engine_.setup(image_bins_, histo_bins_, gates, threads_);
+  frame_ms_ = frame_ms;
+  max_frames_ = max_frames;
+  unsigned run;
+  {
+    std::lock_guard<std::mutex> lock(free_mutex_);
+    run = ++run_;
+    free_.clear();
+    free_.reserve(NR_FRAMES);
+  }
+  for (unsigned i = 0; i < NR_FRAMES; i++) {
+    FramePtr f = std::make_shared<Frame>();
+    f->image = std::make_shared<std::vector<unsigned>>(
+      engine_.length(HistoEngine::IMAGE), 0u);
+    f->histo = std::make_shared<std::vector<unsigned>>(
+      engine_.length(HistoEngine::HISTO), 0u);
+    f->gated_images = std::make_shared<std::vector<unsigned>>(
+      engine_.length(HistoEngine::GATED_IMAGES), 0u);
+    f->gated_histos = std::make_shared<std::vector<unsigned>>(
+      engine_.length(HistoEngine::GATED_HISTOS), 0u);
+    f->run = run;
+    f->accumulate = accumulate;
+    std::lock_guard<std::mutex> lock(free_mutex_);
+    free_.push_back(f);
+  }
+  cur_ = take_frame_();
+  ms_in_frame_ = 0;
+  frames_cut_ = 0;
+  frames_dropped_.store(0);
+
+  sc_pipe_callbacks pcb;
+  pcb.priv = this;
+  pcb.start_of_measure = cb_start_of_meas;
+  pcb.end_of_measure = cb_end_of_meas;
+  pcb.millisecond_countup = cb_millisecond;
+  pcb.statistics = cb_statistics;
+  pcb.tdc_event = cb_tdc_event;
+  pcb.dld_event = cb_dld_event;
+  sc_pipe_callback_params_t pcbp;
+  pcbp.callbacks = &pcb;
+  int ret = sc_pipe_open2(dev_desc_, USER_CALLBACKS, &pcbp);
+  if (ret >= 0)
+    pipe_desc_ = ret;
+  return ret;
+}
+
+void PipeFrameSlicer::stop()
+{
+  if (pipe_desc_ < 0)
+    return;
+  // after this, the callbacks are no longer called
+  sc_pipe_close2(dev_desc_, pipe_desc_);
+  pipe_desc_ = -1;
+  cur_.reset();
+}
+
+bool PipeFrameSlicer::active() const
+{
+  return pipe_desc_ >= 0;
+}
+
+void PipeFrameSlicer::accumulate(PipeFrameSlicer::Frame& f)
+{
+  if (f.run != sums_run_) {
+    sums_ = Frame();
+    sums_run_ = f.run;
+  }
+  FramePool::Buffer* const views[] = {
+    &f.image, &f.histo, &f.gated_images, &f.gated_histos};
+  FramePool::Buffer* const sums[] = {
+    &sums_.image, &sums_.histo, &sums_.gated_images, &sums_.gated_histos};
+  const bool on[] = {f.accumulate.image, f.accumulate.histo,
+                     f.accumulate.gated_images, f.accumulate.gated_histos};
+  for (std::size_t v = 0; v < 4; v++) {
+    if (!on[v])
+      continue;
+    std::vector<unsigned>& d = **views[v];
+    if (!*sums[v])
+      *sums[v] = std::make_shared<std::vector<unsigned>>(d.size(), 0u);
+    std::vector<unsigned>& s = **sums[v];
+    for (std::size_t i = 0; i < d.size(); i++) {
+      s[i] += d[i];
+      d[i] = s[i];
+    }
+  }
+}
+
+void PipeFrameSlicer::recycle(PipeFrameSlicer::FramePtr f)
+{
+  if (!f)
+    return;
+  {
+    std::lock_guard<std::mutex> lock(free_mutex_);
+    if (f->run != run_)
+      return; // of a previous start(), dropped
+  }
+  std::fill(f->image->begin(), f->image->end(), 0u);
+  std::fill(f->histo->begin(), f->histo->end(), 0u);
+  std::fill(f->gated_images->begin(), f->gated_images->end(), 0u);
+  std::fill(f->gated_histos->begin(), f->gated_histos->end(), 0u);
+  std::lock_guard<std::mutex> lock(free_mutex_);
+  if (f->run == run_ && free_.size() < NR_FRAMES)
+    free_.push_back(f); // within the capacity reserved by start()
+}
+
+unsigned long long PipeFrameSlicer::framesDropped() const
+{
+  return frames_dropped_.load();
+}
+
+PipeFrameSlicer::FramePtr PipeFrameSlicer::take_frame_()
+{
+  std::lock_guard<std::mutex> lock(free_mutex_);
+  if (free_.empty())
+    return FramePtr();
+  FramePtr f;
+  f.swap(free_.back());
+  free_.pop_back();
+  f->events = 0;
+  f->index = 0;
+  f->ms = 0;
+  return f;
+}
+
+HistoEngine::Targets PipeFrameSlicer::targets_(PipeFrameSlicer::Frame& f) const
+{
+  HistoEngine::Targets t;
+  t.view[HistoEngine::IMAGE] = f.image->data();
+  t.view[HistoEngine::HISTO] = f.histo->data();
+  t.view[HistoEngine::GATED_IMAGES] = f.gated_images->data();
+  t.view[HistoEngine::GATED_HISTOS] = f.gated_histos->data();
+  return t;
+}
+
+void PipeFrameSlicer::cb_millisecond(void* priv)
+{
+  static_cast<PipeFrameSlicer*>(priv)->millisecond();
+}
+
+void PipeFrameSlicer::cb_end_of_meas(void* priv)
+{
+  static_cast<PipeFrameSlicer*>(priv)->end_of_meas();
+}
+
+void PipeFrameSlicer::cb_dld_event(
+  void* priv, const sc_DldEvent* const e, std::size_t len)
+{
+  static_cast<PipeFrameSlicer*>(priv)->dld_event(e, len);
+}
+
+void PipeFrameSlicer::millisecond()
+{
+  if (!cur_)
+    return; // frame limit reached
+  ++ms_in_frame_;
+  if (frame_ms_ > 0 && ms_in_frame_ >= frame_ms_)
+    cut_();
+}
+
+void PipeFrameSlicer::end_of_meas()
+{
+  if (frame_ms_ == 0 && cur_)
+    cut_();
+}
+
+void PipeFrameSlicer::cut_()
+{
+  FramePtr done = cur_;
+  FramePtr next;
+  if (max_frames_ == 0 || frames_cut_ + 1 < max_frames_) {
+    next = take_frame_();
+    if (!next) {
+      // the consumer is behind: the current frame continues to the next cut
+      frames_dropped_++;
+      done->ms += ms_in_frame_;
+      ms_in_frame_ = 0;
+      return;
+    }
+  }
+  engine_.merge(targets_(*done));
+  done->index = frames_cut_++;
+  done->ms += ms_in_frame_;
+  ms_in_frame_ = 0;
+  cur_ = next; // null after the last frame
+  if (frame_consumer_)
+    frame_consumer_(done);
+}
+
+void PipeFrameSlicer::dld_event(const sc_DldEvent* e, std::size_t len)
+{
+  if (!cur_)
+    return;
+  Frame& f = *cur_;
+  engine_.fill(e, len, targets_(f));
+  f.events += len;
+}
@@ -0,0 +1,141 @@
+#ifndef PIPEFRAMESLICER_HPP
+#define PIPEFRAMESLICER_HPP
+
+/* Copyright 2022 Surface Concept GmbH */
+
+#include "iCreatedAtInit.hpp"
+#include "FramePool.hpp"
+#include "HistoEngine.hpp"
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+struct sc_pipe_dld_image_xy_params_t;
+struct sc_pipe_dld_sum_histo_params_t;
+struct sc_TdcEvent;
+struct statistics_t;
+
+/**
+ * @brief The PipeFrameSlicer class builds the XY image and the time histogram
+ * in software from the events of a USER_CALLBACKS pipe, for the gapless
+ * acquisition mode. One long hardware measurement runs, and a frame is cut
+ * every frame_ms millisecond markers, so consecutive frames have no dead time
+ * in between and their boundaries fall exactly on the TDC millisecond ticks.
+ * The ROIs and binnings are the same as for the hardware pipes (PipeImageXY,
+ * PipeTimeHisto) whose parameters are passed to start(). The events are
+ * binned by a HistoEngine, which uses several threads at high event rates,
+ * and which also fills the gated views in the same pass. With frame_ms 0,
+ * the frame is cut at the end of each hardware measurement instead, so the
+ * gated views are also available in the other acquisition modes.
+ * The completed frames are passed to the frame consumer in the
+ * USER_CALLBACKS thread, which should hand them over to another thread and
+ * pass them back via recycle() after use. The frames and their buffers are
+ * allocated by start() and reused, the USER_CALLBACKS thread neither
+ * allocates nor copies or clears frame buffers: each frame holds only the
+ * counts of its own period, the consumer calls accumulate() for the running
+ * sums, and recycle() clears the buffers. If the consumer has not passed
+ * back a frame in time, the frame boundary is dropped (see framesDropped())
+ * and the frame continues until the next one.
+ */
+class PipeFrameSlicer : public iCreatedAtInit
+{
+public:
+  // the views of a frame that start from the data of the previous frame
+  struct Accumulate {
+    bool image = false;
+    bool histo = false;
+    bool gated_images = false;
+    bool gated_histos = false;
+  };
+  struct Frame {
+    FramePool::Buffer image;       // layout of the PipeImageXY data
+    FramePool::Buffer histo;       // layout of the PipeTimeHisto data
+    FramePool::Buffer gated_images; // one image per time gate
+    FramePool::Buffer gated_histos; // one histogram per XY gate
+    unsigned long long events = 0; // all events, also outside of the ROIs
+    unsigned long long index = 0;  // frame number since start()
+    unsigned ms = 0;               // duration of the frame
+    unsigned run = 0;              // the start() that allocated the frame
+    Accumulate accumulate;         // of that start()
+  };
+  typedef std::shared_ptr<Frame> FramePtr;
+  typedef std::function<void(FramePtr)> frame_consumer_t;
+
+  PipeFrameSlicer();
+  virtual ~PipeFrameSlicer();
+  int create(int dev_desc) override;
+  void setFrameConsumer(frame_consumer_t);
+  /** number of histogramming threads (HistoEngine), 0 for automatic,
+   * applied at the next start() */
+  void setThreads(unsigned);
+  unsigned threads() const;
+  /**
+   * @brief start open the USER_CALLBACKS pipe, before the start of the
+   * hardware measurement
+   * @param frame_ms frame duration in millisecond markers, 0 to cut one
+   * frame per hardware measurement
+   * @param max_frames number of frames after which further events are
+   * ignored, 0 for no limit
+   * @return the pipe descriptor or a negative scTDC error code
+   */
+  int start(const sc_pipe_dld_image_xy_params_t& image,
+            const sc_pipe_dld_sum_histo_params_t& histo,
+            const HistoEngine::Gates& gates, unsigned frame_ms,
+            const Accumulate& accumulate, unsigned long long max_frames);
+  /** close the pipe, the incomplete frame is discarded */
+  void stop();
+  bool active() const;
+  /** to be called by the frame consumer (not in the USER_CALLBACKS thread)
+   * for each frame in order: replaces the views that accumulate by the sums
+   * since start() */
+  void accumulate(Frame&);
+  /** return a frame received by the frame consumer for reuse, clears its
+   * buffers in the calling thread */
+  void recycle(FramePtr);
+  /** number of frame boundaries dropped since start() because no free frame
+   * was left; the counts of such a frame go to the next frame, whose ms
+   * covers both */
+  unsigned long long framesDropped() const;
+
+private:
+  static void cb_millisecond(void* priv);
+  static void cb_start_of_meas(void*) {}
+  static void cb_end_of_meas(void* priv);
+  static void cb_statistics(void*, const statistics_t*) {}
+  static void cb_tdc_event(void*, const sc_TdcEvent* const, std::size_t) {}
+  static void cb_dld_event(void* priv, const sc_DldEvent* const e,
+                           std::size_t len);
+  void millisecond();
+  void end_of_meas();
+  void cut_();
+  void dld_event(const sc_DldEvent* e, std::size_t len);
+  FramePtr take_frame_();
+  HistoEngine::Targets targets_(Frame&) const;
+
+  int dev_desc_ = -1;
+  int pipe_desc_ = -1;
+  frame_consumer_t frame_consumer_;
+  HistoEngine::Binning image_bins_;
+  HistoEngine::Binning histo_bins_;
+  unsigned threads_ = 0;
+  unsigned frame_ms_ = 1;
+  unsigned long long max_frames_ = 0;
+  // USER_CALLBACKS thread only (while the pipe is open)
+  FramePtr cur_;
+  unsigned ms_in_frame_ = 0;
+  unsigned long long frames_cut_ = 0;
+  std::atomic<unsigned long long> frames_dropped_{0};
+  HistoEngine engine_;
+  // the frame being filled and the frames at the consumer
+  static const unsigned NR_FRAMES = 6;
+  std::mutex free_mutex_;
+  std::vector<FramePtr> free_; // zeroed frames of the current run
+  unsigned run_ = 0;           // incremented by start(), under free_mutex_
+  // consumer thread only
+  Frame sums_;                 // of the views that accumulate
+  unsigned sums_run_ = 0;
+};
+
+#endif // PIPEFRAMESLICER_HPP
@@ -1,9 +1,11 @@
 /* Copyright 2022 Surface Concept GmbH */
 #include "PipeImageXY.hpp"
 
+#include <algorithm>
 #include <cstring>
 #include <scTDC.h>
 #include <scTDC_types.h>
+#include "HistoConvert.hpp"
 
 
 PipeImageXY::PipeImageXY()
@@ -59,15 +61,110 @@ void PipeImageXY::end_of_measurement()
 {
   void* dummy;
   sc_pipe_read2(dev_desc_, pipe_desc_, &dummy, 100);
-  data_consumer_(
-    data_.size(),
-    params_->roi.size.x,
-    reinterpret_cast<int*>(data_.data()));
-  // slightly evil (unsigned misinterpreted as int. scTDC1 only has
-  // unsigned buffer types for the histogram pipes, and ADDriver only has
-  // signed buffer types and I don't want to convert. This is fine, as long
-  // as the counts per pixel are not going above max int = 2^31 - 1, which
-  // is about 2 billion)
+  // the next measurement fills another buffer, so that this one can be sent
+  // out by publish_frame() while the hardware is already busy again
+  done_ = filling_;
+  filling_ = pool_.take();
+  if (accumulatesFrames() && done_) {
+    std::copy(done_->begin(), done_->end(), filling_->begin());
+  }
+  if (!publishing_) {
+    pool_.recycle(done_);
+    done_.reset();
+  }
+}
+
+void PipeImageXY::publish_frame()
+{
+  if (!done_) {
+    return;
+  }
+  FramePool::Buffer b;
+  b.swap(done_);
+  publish(b->data(), b->size());
+  pool_.recycle(b); // the consumer has made its copy
+}
+
+void PipeImageXY::publish(unsigned* data, std::size_t length)
+{
+  if (length != pool_.length()) {
+    return; // from before a change of the ROI
+  }
+  if (accumulate_ && window_ > 0) {
+    rolling_.setup(length, window_);
+    data = rolling_.add(data);
+  }
+  else if (rolling_.length() > 0) {
+    rolling_.setup(0, 1); // release the ring
+  }
+  const unsigned long long* wide = nullptr;
+  if (accumulate_ && window_ == 0 && wide_) {
+    if (wide_sum_.size() != length) {
+      wide_sum_.assign(length, 0ull);
+    }
+    histo_convert::add(wide_sum_.data(), data, length);
+    wide = wide_sum_.data();
+  }
+  else {
+    std::vector<unsigned long long>().swap(wide_sum_);
+  }
+  const PixelType type = pixel_type_;
+  if (wide && type != PIXEL_INT32) {
+    wide_out_.resize(length);
+    histo_convert::to_unsigned(wide, wide_out_.data(), length);
+    data = wide_out_.data();
+    wide = nullptr;
+  }
+  else {
+    std::vector<unsigned>().swap(wide_out_);
+  }
+  if (type != PIXEL_INT32) {
+    std::vector<int>().swap(out_int_);
+  }
+  if (type != PIXEL_UINT16) {
+    std::vector<unsigned short>().swap(out_ushort_);
+  }
+  if (type != PIXEL_UINT8) {
+    std::vector<unsigned char>().swap(out_uchar_);
+  }
+  const std::size_t width = params_->roi.size.x;
+  switch (type) {
+  case PIXEL_UINT32:
+    data_consumer_(length, width, PIXEL_UINT32, data);
+    break;
+  case PIXEL_UINT16:
+    out_ushort_.resize(length);
+    histo_convert::to_ushort(data, out_ushort_.data(), length);
+    data_consumer_(length, width, PIXEL_UINT16, out_ushort_.data());
+    break;
+  case PIXEL_UINT8:
+    out_uchar_.resize(length);
+    histo_convert::to_uchar(data, out_uchar_.data(), length);
+    data_consumer_(length, width, PIXEL_UINT8, out_uchar_.data());
+    break;
+  default:
+    // the element type of the parameter configuration, which clients of
+    // earlier versions expect
+    out_int_.resize(length);
+    if (wide) {
+      histo_convert::to_int(wide, out_int_.data(), length);
+    }
+    else {
+      histo_convert::to_int(data, out_int_.data(), length);
+    }
+    data_consumer_(length, width, PIXEL_INT32, out_int_.data());
+    break;
+  }
+}
+
+void PipeImageXY::setPublishing(bool v)
+{
+  publishing_ = v;
+}
+
+const sc_pipe_dld_image_xy_params_t& PipeImageXY::activeParams() const
+{
+  return *params_;
 }
 
 void PipeImageXY::setDataConsumer(PipeImageXY::data_consumer_t v)
@@ -173,6 +270,49 @@ int PipeImageXY::accumulate() const
   return accumulate_ ? 1 : 0;
 }
 
+void PipeImageXY::setWindow(int v)
+{
+  window_ = static_cast<unsigned>(std::max(0, v));
+}
+
+int PipeImageXY::window() const
+{
+  return static_cast<int>(window_);
+}
+
+void PipeImageXY::setAccumDepth(int v)
+{
+  wide_ = v > 0;
+}
+
+int PipeImageXY::accumDepth() const
+{
+  return wide_ ? 1 : 0;
+}
+
+void PipeImageXY::setPixelType(int v)
+{
+  PixelType t = PIXEL_INT32;
+  switch (v) {
+  case PIXEL_UINT32: t = PIXEL_UINT32; break;
+  case PIXEL_UINT16: t = PIXEL_UINT16; break;
+  case PIXEL_UINT8: t = PIXEL_UINT8; break;
+  default: break;
+  }
+  pixel_type_ = t; // the buffers of the previous type are released in publish
+}
+
+int PipeImageXY::pixelType() const
+{
+  return pixel_type_;
+}
+
+bool PipeImageXY::accumulatesFrames() const
+{
+  // the rolling sum and the 64 bit sum need the frames separately
+  return accumulate_ && window_ == 0 && !wide_;
+}
+
 int PipeImageXY::static_allocator_cb(void* priv, void** buf)
 {
   return static_cast<PipeImageXY*>(priv)->allocator_cb(buf);
@@ -180,19 +320,17 @@ int PipeImageXY::static_allocator_cb(void* priv, void** buf)
 
 int PipeImageXY::allocator_cb(void** buf)
 {
-  // called by scTDC at the beginning of the measurement
-  if (!accumulate_) {
-    std::fill(data_.begin(), data_.end(), 0u); // reset to all zeros
-  }
-  *buf = data_.data();
+  // called by scTDC at the beginning of the measurement, the buffer is zeroed
+  // or holds a copy of the previous image (accumulation)
+  *buf = filling_->data();
   return 0;
 }
 
 void PipeImageXY::resize_data()
 {
-  data_.resize(
+  pool_.setLength(
     static_cast<std::size_t>(params_->roi.size.x) * params_->roi.size.y);
-  std::fill(data_.begin(), data_.end(), 0u);
+  filling_ = pool_.take();
 }
 
 int PipeImageXY::log2_(unsigned v)
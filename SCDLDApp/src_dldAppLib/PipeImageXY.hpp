@@ -6,25 +6,41 @@
 #include "iCreatedAtInit.hpp"
 #include "iStartOfMeasListener.hpp"
 #include "iEndOfMeasListener.hpp"
+#include "iFramePublisher.hpp"
+#include "FramePool.hpp"
+#include "RollingSum.hpp"
 #include <functional>
 #include <memory>
+#include <vector>
 
 struct sc_pipe_dld_image_xy_params_t;
 
 class PipeImageXY
   : public iCreatedAtInit,
     public iStartOfMeasListener,
-    public iEndOfMeasListener
+    public iEndOfMeasListener,
+    public iFramePublisher
 {
 public:
-  // data_consumer_t args are nr_elements, width of image, data
-  typedef std::function<void(size_t, size_t, int*)> data_consumer_t;
+  // element type of the published image, the counts are clipped at the
+  // maximum value of the type (the hardware buffers are always 32 bit)
+  enum PixelType { PIXEL_INT32, PIXEL_UINT32, PIXEL_UINT16, PIXEL_UINT8 };
+  // data_consumer_t args are nr_elements, width of image, pixel type, data
+  typedef std::function<void(size_t, size_t, PixelType, void*)>
+    data_consumer_t;
   PipeImageXY();
   virtual ~PipeImageXY();
   virtual int create(int dev_desc);
   virtual void start_of_measurement(int time_ms);
   virtual void end_of_measurement();
+  virtual void publish_frame();
   void setDataConsumer(data_consumer_t);
+  // send an image of the active ROI, e.g. built by PipeFrameSlicer
+  void publish(unsigned* data, std::size_t length);
+  // whether end_of_measurement sends out the image of the hardware pipe
+  void setPublishing(bool);
+  // parameters of the pipe since the last start_of_measurement
+  const sc_pipe_dld_image_xy_params_t& activeParams() const;
   void setMinX(int);
   void setMinY(int);
   void setSizeX(int);
@@ -39,6 +55,17 @@ public:
   int binY() const;
   void setAccumulate(int);
   int accumulate() const;
+  // with accumulation, the number of frames summed up, 0 for all
+  void setWindow(int);
+  int window() const;
+  // with accumulation of all frames, 0: 32 bit counts in the scTDC buffers,
+  // 1: 64 bit counts, to which each frame is added when published
+  void setAccumDepth(int);
+  int accumDepth() const;
+  void setPixelType(int);
+  int pixelType() const;
+  // whether each frame starts from the data of the previous one
+  bool accumulatesFrames() const;
 private:
   static int static_allocator_cb(void* priv, void** buf);
   int allocator_cb(void** buf);
@@ -49,10 +76,23 @@ private:
   int pipe_desc_ = -1;
   bool change_request_ = false;
   bool accumulate_ = false;
+  bool publishing_ = true;
   data_consumer_t data_consumer_;
   std::unique_ptr<sc_pipe_dld_image_xy_params_t> params_;
   std::unique_ptr<sc_pipe_dld_image_xy_params_t> next_params_;
-  std::vector<unsigned> data_;
+  FramePool pool_;
+  FramePool::Buffer filling_; // passed to scTDC at the start of a measurement
+  FramePool::Buffer done_;    // of the last measurement, for publish_frame
+  unsigned window_ = 0;
+  RollingSum rolling_;        // only used in publish()
+  bool wide_ = false;
+  std::vector<unsigned long long> wide_sum_; // only used in publish()
+  PixelType pixel_type_ = PIXEL_INT32;
+  // the clipped counts sent out, only the one of pixel_type_ is used
+  std::vector<unsigned> wide_out_;
+  std::vector<int> out_int_;
+  std::vector<unsigned short> out_ushort_;
+  std::vector<unsigned char> out_uchar_;
 };
 
 #endif // PIPEIMAGEXY_HPP
@@ -0,0 +1,245 @@
+/* Copyright 2022 Surface Concept GmbH */
+#include "PipeImageXYT.hpp"
+
+#include <algorithm>
+#include <scTDC.h>
+#include <scTDC_types.h>
+#include "TimeBin.hpp"
+#include "HistoConvert.hpp"
+#include "PipeImageXY.hpp"
+#include "PipeTimeHisto.hpp"
+
+namespace {
+  bool same_params(const sc_pipe_dld_image_3d_params_t& a,
+                   const sc_pipe_dld_image_3d_params_t& b)
+  {
+    return a.binning.x == b.binning.x && a.binning.y == b.binning.y
+      && a.binning.time == b.binning.time
+      && a.roi.offset.x == b.roi.offset.x && a.roi.offset.y == b.roi.offset.y
+      && a.roi.offset.time == b.roi.offset.time
+      && a.roi.size.x == b.roi.size.x && a.roi.size.y == b.roi.size.y
+      && a.roi.size.time == b.roi.size.time;
+  }
+}
+
+PipeImageXYT::PipeImageXYT(
+  TimeBin& time_bin, const PipeImageXY& imagexy,
+  const PipeTimeHisto& timehisto)
+  : time_bin_(time_bin), imagexy_(imagexy), timehisto_(timehisto)
+{
+  params_.reset(new sc_pipe_dld_image_3d_params_t);
+  auto& p = *params_; // short alias
+  p.depth = BS32;
+  p.channel = -1;
+  p.modulo = 0;
+  p.binning.x = 1;
+  p.binning.y = 1;
+  p.binning.time = 1;
+  p.roi.offset.x = 0;
+  p.roi.offset.y = 0;
+  p.roi.offset.time = 0;
+  p.roi.size.x = 0;
+  p.roi.size.y = 0;
+  p.roi.size.time = 0;
+  p.accumulation_ms = 0xFFFFFFFFu;
+  p.allocator_owner = this;
+  p.allocator_cb = static_allocator_cb;
+}
+
+PipeImageXYT::~PipeImageXYT()
+{
+
+}
+
+int PipeImageXYT::create(int dev_desc)
+{
+  dev_desc_ = dev_desc;
+  pipe_desc_ = -1; // opened at the first measurement with the cube enabled
+  return 0;
+}
+
+void PipeImageXYT::start_of_measurement(int time_ms)
+{
+  if (!enabled_ || !publishing_) {
+    close_pipe();
+    return;
+  }
+  sc_pipe_dld_image_3d_params_t p = *params_;
+  double slice_ns = 0.0;
+  next_params(p, &slice_ns);
+  if (pipe_desc_ >= 0 && same_params(p, *params_)) {
+    return;
+  }
+  close_pipe();
+  if (p.roi.size.time == 0) {
+    return; // a single time slice exceeds the memory limit
+  }
+  *params_ = p;
+  slice_ns_ = slice_ns;
+  pool_.setLength(static_cast<std::size_t>(
+    p.roi.size.x * p.roi.size.y * p.roi.size.time));
+  filling_ = pool_.take();
+  pipe_desc_ = sc_pipe_open2(dev_desc_, DLD_IMAGE_3D, params_.get());
+}
+
+void PipeImageXYT::end_of_measurement()
+{
+  if (pipe_desc_ < 0) {
+    return;
+  }
+  void* dummy;
+  sc_pipe_read2(dev_desc_, pipe_desc_, &dummy, 100);
+  // same double buffering as in PipeImageXY, without accumulation
+  done_ = filling_;
+  filling_ = pool_.take();
+  if (!publishing_) {
+    pool_.recycle(done_);
+    done_.reset();
+  }
+}
+
+void PipeImageXYT::publish_frame()
+{
+  if (!done_) {
+    return;
+  }
+  FramePool::Buffer b;
+  b.swap(done_);
+  if (b->size() == pool_.length()) {
+    // saturate the counts in place, the buffer is zeroed before its reuse
+    int* out = reinterpret_cast<int*>(b->data());
+    histo_convert::to_int(b->data(), out, b->size());
+    data_consumer_(
+      b->size(),
+      static_cast<std::size_t>(params_->roi.size.x),
+      static_cast<std::size_t>(params_->roi.size.y),
+      out);
+  }
+  pool_.recycle(b); // the consumer has made its copy
+}
+
+void PipeImageXYT::setDataConsumer(PipeImageXYT::data_consumer_t v)
+{
+  data_consumer_ = v;
+}
+
+void PipeImageXYT::setPublishing(bool v)
+{
+  publishing_ = v;
+}
+
+// the setters take effect at the next start_of_measurement
+void PipeImageXYT::setEnabled(int v)
+{
+  enabled_ = v > 0;
+}
+
+void PipeImageXYT::setBinX(int v)
+{
+  bin_x_ = std::max(0, std::min(15, v));
+}
+
+void PipeImageXYT::setBinY(int v)
+{
+  bin_y_ = std::max(0, std::min(15, v));
+}
+
+void PipeImageXYT::setSizeT(int v)
+{
+  size_t_ = std::max(1, v);
+}
+
+void PipeImageXYT::setMaxMiB(int v)
+{
+  max_mib_ = std::max(1, std::min(256, v));
+}
+
+int PipeImageXYT::enabled() const
+{
+  return enabled_ ? 1 : 0;
+}
+
+int PipeImageXYT::binX() const
+{
+  return bin_x_;
+}
+
+int PipeImageXYT::binY() const
+{
+  return bin_y_;
+}
+
+int PipeImageXYT::sizeT() const
+{
+  return size_t_;
+}
+
+int PipeImageXYT::maxMiB() const
+{
+  return max_mib_;
+}
+
+double PipeImageXYT::sliceNs() const
+{
+  return pipe_desc_ >= 0 ? slice_ns_ : 0.0;
+}
+
+int PipeImageXYT::static_allocator_cb(void* priv, void** buf)
+{
+  return static_cast<PipeImageXYT*>(priv)->allocator_cb(buf);
+}
+
+int PipeImageXYT::allocator_cb(void** buf)
+{
+  *buf = filling_->data(); // zeroed
+  return 0;
+}
+
+void PipeImageXYT::next_params(
+  sc_pipe_dld_image_3d_params_t& p, double* slice_ns) const
+{
+  // the detector area of the XY image, in unbinned coordinates
+  const unsigned long long x0 =
+    static_cast<unsigned long long>(std::max(0, imagexy_.minX()))
+    << imagexy_.binX();
+  const unsigned long long y0 =
+    static_cast<unsigned long long>(std::max(0, imagexy_.minY()))
+    << imagexy_.binY();
+  const unsigned long long w =
+    static_cast<unsigned long long>(imagexy_.sizeX()) << imagexy_.binX();
+  const unsigned long long h =
+    static_cast<unsigned long long>(imagexy_.sizeY()) << imagexy_.binY();
+  p.binning.x = 1ull << bin_x_;
+  p.binning.y = 1ull << bin_y_;
+  p.roi.offset.x = static_cast<long long>(x0 >> bin_x_);
+  p.roi.offset.y = static_cast<long long>(y0 >> bin_y_);
+  p.roi.size.x = std::max(1ull, w >> bin_x_);
+  p.roi.size.y = std::max(1ull, h >> bin_y_);
+  // fewer (wider) time slices if the cube does not fit into the memory limit
+  const unsigned long long max_elements =
+    (static_cast<unsigned long long>(max_mib_) << 20) / sizeof(unsigned);
+  const unsigned long long max_slices =
+    max_elements / (p.roi.size.x * p.roi.size.y);
+  if (max_slices == 0) {
+    p.roi.size.time = 0;
+    *slice_ns = 0.0;
+    return;
+  }
+  const unsigned long long slices =
+    std::min(static_cast<unsigned long long>(size_t_), max_slices);
+  TimeBin::Result r = time_bin_.autobins(
+    timehisto_.minTSI(), timehisto_.sizeTSI(), slices);
+  p.binning.time = 1ull << r.binpow;
+  p.roi.offset.time = static_cast<long long>(r.offset);
+  p.roi.size.time = r.size;
+  *slice_ns = r.tsize_ns / static_cast<double>(r.size);
+}
+
+void PipeImageXYT::close_pipe()
+{
+  if (pipe_desc_ >= 0) {
+    sc_pipe_close2(dev_desc_, pipe_desc_);
+    pipe_desc_ = -1;
+  }
+  filling_.reset();
+}
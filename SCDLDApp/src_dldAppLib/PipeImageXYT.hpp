@@ -0,0 +1,86 @@
+#ifndef PIPEIMAGEXYT_HPP
+#define PIPEIMAGEXYT_HPP
+
+/* Copyright 2022 Surface Concept GmbH */
+
+#include "iCreatedAtInit.hpp"
+#include "iStartOfMeasListener.hpp"
+#include "iEndOfMeasListener.hpp"
+#include "iFramePublisher.hpp"
+#include "FramePool.hpp"
+#include <functional>
+#include <memory>
+
+struct sc_pipe_dld_image_3d_params_t;
+class TimeBin;
+class PipeImageXY;
+class PipeTimeHisto;
+
+/**
+ * @brief The PipeImageXYT class acquires an (x, y, t) cube with a DLD_IMAGE_3D
+ * pipe. The cube covers the detector area of the PipeImageXY ROI and the time
+ * range of the PipeTimeHisto, with its own binning in x and y and its own
+ * number of time slices. The number of time slices is reduced (with
+ * correspondingly wider slices) if the cube would exceed the memory limit.
+ * The pipe is only open while the cube is enabled and published, so not
+ * during gapless acquisitions.
+ */
+class PipeImageXYT
+  : public iCreatedAtInit,
+    public iStartOfMeasListener,
+    public iEndOfMeasListener,
+    public iFramePublisher
+{
+public:
+  // data_consumer_t args are nr_elements, width, height of a time slice, data
+  // (x varies fastest, then y, then t)
+  typedef std::function<void(size_t, size_t, size_t, int*)> data_consumer_t;
+  PipeImageXYT(TimeBin&, const PipeImageXY&, const PipeTimeHisto&);
+  virtual ~PipeImageXYT();
+  virtual int create(int dev_desc);
+  virtual void start_of_measurement(int time_ms);
+  virtual void end_of_measurement();
+  virtual void publish_frame();
+  void setDataConsumer(data_consumer_t);
+  // whether end_of_measurement sends out the cube of the hardware pipe,
+  // applied at the next start_of_measurement
+  void setPublishing(bool);
+  void setEnabled(int);
+  void setBinX(int);
+  void setBinY(int);
+  void setSizeT(int);
+  void setMaxMiB(int);
+  int enabled() const;
+  int binX() const;
+  int binY() const;
+  int sizeT() const;
+  int maxMiB() const;
+  // width of a time slice of the active pipe in ns
+  double sliceNs() const;
+private:
+  static int static_allocator_cb(void* priv, void** buf);
+  int allocator_cb(void** buf);
+  void next_params(sc_pipe_dld_image_3d_params_t&, double* slice_ns) const;
+  void close_pipe();
+
+  TimeBin& time_bin_;
+  const PipeImageXY& imagexy_;
+  const PipeTimeHisto& timehisto_;
+  int dev_desc_ = -1;
+  int pipe_desc_ = -1;
+  bool enabled_ = false;
+  bool publishing_ = true;
+  int bin_x_ = 3; // log2
+  int bin_y_ = 3;
+  int size_t_ = 64;
+  int max_mib_ = 64;
+  double slice_ns_ = 0.0;
+  data_consumer_t data_consumer_;
+  std::unique_ptr<sc_pipe_dld_image_3d_params_t> params_;
+  // one spare buffer at most, the cube may be large
+  FramePool pool_{1};
+  FramePool::Buffer filling_; // passed to scTDC at the start of a measurement
+  FramePool::Buffer done_;    // of the last measurement, for publish_frame
+};
+
+#endif // PIPEIMAGEXYT_HPP
@@ -1,10 +1,12 @@
 /* Copyright 2022 Surface Concept GmbH */
 #include "PipeTimeHisto.hpp"
 
+#include <algorithm>
 #include <cstring>
 #include <scTDC.h>
 #include <scTDC_types.h>
 #include "TimeBin.hpp"
+#include "HistoConvert.hpp"
 
 #include <iostream>
 
@@ -58,18 +60,71 @@ void PipeTimeHisto::end_of_measurement()
 {
   void* dummy;
   sc_pipe_read2(dev_desc_, pipe_desc_, &dummy, 100);
+  // same double buffering as in PipeImageXY
+  done_ = filling_;
+  filling_ = pool_.take();
+  if (accumulatesFrames() && done_) {
+    std::copy(done_->begin(), done_->end(), filling_->begin());
+  }
+  if (!publishing_) {
+    pool_.recycle(done_);
+    done_.reset();
+  }
+}
+
+void PipeTimeHisto::publish_frame()
+{
+  if (!done_) {
+    return;
+  }
+  FramePool::Buffer b;
+  b.swap(done_);
+  publish(b->data(), b->size());
+  pool_.recycle(b);
+}
+
+void PipeTimeHisto::publish(const unsigned* data, std::size_t length)
+{
+  if (length != xaxis_.size()) {
+    return; // from before a change of the time range
+  }
+  if (accumulate_ && window_ > 0) {
+    rolling_.setup(length, window_);
+    data = rolling_.add(data);
+  }
+  else if (rolling_.length() > 0) {
+    rolling_.setup(0, 1); // release the ring
+  }
   // compute x axis
-  auto nrsteps = data_.size() > 1u ? data_.size() - 1u : 1u;
+  auto nrsteps = length > 1u ? length - 1u : 1u;
   auto tstep = actual_tsize_ns_ / nrsteps;
   for (std::size_t i = 0; i < xaxis_.size(); i++) {
     xaxis_[i] = actual_tstart_ns_ + i * tstep;
   }
   // convert histogram values to double
-  for (std::size_t i = 0; i < data_.size(); i++) {
-    yaxis_[i] = static_cast<double>(data_[i]);
+  if (accumulate_ && window_ == 0 && wide_) {
+    if (wide_sum_.size() != length) {
+      wide_sum_.assign(length, 0ull);
+    }
+    histo_convert::add(wide_sum_.data(), data, length);
+    histo_convert::to_double(wide_sum_.data(), yaxis_.data(), length);
+  }
+  else {
+    std::vector<unsigned long long>().swap(wide_sum_);
+    histo_convert::to_double(data, yaxis_.data(), length);
   }
   // send out x and y values
-  data_consumer_(data_.size(), xaxis_.data(), yaxis_.data());
+  data_consumer_(length, xaxis_.data(), yaxis_.data());
+}
+
+void PipeTimeHisto::setPublishing(bool v)
+{
+  publishing_ = v;
+}
+
+const sc_pipe_dld_sum_histo_params_t& PipeTimeHisto::activeParams() const
+{
+  return *params_;
 }
 
 void PipeTimeHisto::setDataConsumer(PipeTimeHisto::data_consumer_t v)
@@ -128,6 +183,31 @@ int PipeTimeHisto::accumulate() const
   return accumulate_ ? 1 : 0;
 }
 
+void PipeTimeHisto::setWindow(int v)
+{
+  window_ = static_cast<unsigned>(std::max(0, v));
+}
+
+int PipeTimeHisto::window() const
+{
+  return static_cast<int>(window_);
+}
+
+void PipeTimeHisto::setAccumDepth(int v)
+{
+  wide_ = v > 0;
+}
+
+int PipeTimeHisto::accumDepth() const
+{
+  return wide_ ? 1 : 0;
+}
+
+bool PipeTimeHisto::accumulatesFrames() const
+{
+  return accumulate_ && window_ == 0 && !wide_; // as in PipeImageXY
+}
+
 
 int PipeTimeHisto::static_allocator_cb(void *priv, void **buf)
 {
@@ -136,18 +216,15 @@ int PipeTimeHisto::static_allocator_cb(void *priv, void **buf)
 
 int PipeTimeHisto::allocator_cb(void **buf)
 {
-  if (!accumulate_) {
-    std::fill(data_.begin(), data_.end(), 0u); // reset to all zeros
-  }
-  *buf = data_.data();
+  *buf = filling_->data(); // zeroed, or a copy of the previous histogram
   return 0;
 }
 
 void PipeTimeHisto::resize_data()
 {
   auto s = static_cast<std::size_t>(params_->roi.size.time);
-  data_.resize(s);
-  std::fill(data_.begin(), data_.end(), 0u);
+  pool_.setLength(s);
+  filling_ = pool_.take();
   xaxis_.resize(s);
   yaxis_.resize(s);
 }
@@ -6,8 +6,12 @@
 #include "iCreatedAtInit.hpp"
 #include "iStartOfMeasListener.hpp"
 #include "iEndOfMeasListener.hpp"
+#include "iFramePublisher.hpp"
+#include "FramePool.hpp"
+#include "RollingSum.hpp"
 #include <functional>
 #include <memory>
+#include <vector>
 
 struct sc_pipe_dld_sum_histo_params_t;
 class TimeBin;
@@ -15,7 +19,8 @@ class TimeBin;
 class PipeTimeHisto
   : public iCreatedAtInit,
     public iStartOfMeasListener,
-    public iEndOfMeasListener
+    public iEndOfMeasListener,
+    public iFramePublisher
 {
 public:
   // data_consumer_t args are nr_elements, xaxis values, yaxis values
@@ -25,7 +30,14 @@ public:
   virtual int create(int dev_desc);
   virtual void start_of_measurement(int time_ms);
   virtual void end_of_measurement();
+  virtual void publish_frame();
   void setDataConsumer(data_consumer_t);
+  // send a histogram of the active time range, e.g. built by PipeFrameSlicer
+  void publish(const unsigned* data, std::size_t length);
+  // whether end_of_measurement sends out the histogram of the hardware pipe
+  void setPublishing(bool);
+  // parameters of the pipe since the last start_of_measurement
+  const sc_pipe_dld_sum_histo_params_t& activeParams() const;
   void setSizeT(int);
   void setMinTSI(double);
   void setSizeTSI(double);
@@ -34,6 +46,15 @@ public:
   double sizeTSI() const;
   void setAccumulate(int);
   int accumulate() const;
+  // with accumulation, the number of frames summed up, 0 for all
+  void setWindow(int);
+  int window() const;
+  // with accumulation of all frames, 0: 32 bit counts in the scTDC buffers,
+  // 1: 64 bit counts, to which each frame is added when published
+  void setAccumDepth(int);
+  int accumDepth() const;
+  // whether each frame starts from the data of the previous one
+  bool accumulatesFrames() const;
 private:
   static int static_allocator_cb(void* priv, void** buf);
   int allocator_cb(void** buf);
@@ -47,7 +68,13 @@ private:
   data_consumer_t data_consumer_;
   std::unique_ptr<sc_pipe_dld_sum_histo_params_t> params_;
   std::unique_ptr<sc_pipe_dld_sum_histo_params_t> next_params_;
-  std::vector<unsigned> data_;
+  FramePool pool_;
+  FramePool::Buffer filling_; // passed to scTDC at the start of a measurement
+  FramePool::Buffer done_;    // of the last measurement, for publish_frame
+  unsigned window_ = 0;
+  RollingSum rolling_;        // only used in publish()
+  bool wide_ = false;
+  std::vector<unsigned long long> wide_sum_; // only used in publish()
   std::vector<double> xaxis_;
   std::vector<double> yaxis_;
   double user_tstart_ns_;
@@ -55,6 +82,7 @@ private:
   double actual_tstart_ns_;
   double actual_tsize_ns_;
   bool accumulate_;
+  bool publishing_ = true;
 };
 
 #endif // PIPETIMEHISTO_HPP
@@ -0,0 +1,79 @@
+/* Copyright 2022 Surface Concept GmbH */
+#include "RollingSum.hpp"
+
+#include <algorithm>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#include "HistoConvert.hpp"
+
+namespace {
+  // sum[i] += frame[i] - old[i]; old[i] = frame[i]
+  void replace_frame(unsigned long long* sum, unsigned* old,
+                     const unsigned* frame, std::size_t n)
+  {
+    // the 64 bit sum holds at least old[i], so the subtraction cannot wrap
+    std::size_t i = 0;
+#ifdef __SSE2__
+    const __m128i zero = _mm_setzero_si128();
+    for (; i + 4 <= n; i += 4) {
+      const __m128i f =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(frame + i));
+      const __m128i o =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(old + i));
+      // zero-extended to 64 bits, the difference wraps modulo 2^64 like
+      // the scalar expression
+      const __m128i dlo = _mm_sub_epi64(_mm_unpacklo_epi32(f, zero),
+                                        _mm_unpacklo_epi32(o, zero));
+      const __m128i dhi = _mm_sub_epi64(_mm_unpackhi_epi32(f, zero),
+                                        _mm_unpackhi_epi32(o, zero));
+      __m128i* s = reinterpret_cast<__m128i*>(sum + i);
+      _mm_storeu_si128(s, _mm_add_epi64(_mm_loadu_si128(s), dlo));
+      _mm_storeu_si128(s + 1, _mm_add_epi64(_mm_loadu_si128(s + 1), dhi));
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(old + i), f);
+    }
+#endif
+    for (; i < n; i++) {
+      sum[i] = sum[i] + frame[i] - old[i];
+      old[i] = frame[i];
+    }
+  }
+}
+
+void RollingSum::setup(std::size_t length, unsigned nframes)
+{
+  nframes = std::max(1u, nframes);
+  if (length == length_ && nframes == nframes_)
+    return;
+  length_ = length;
+  nframes_ = nframes;
+  clear();
+}
+
+void RollingSum::clear()
+{
+  ring_.clear();
+  oldest_ = 0;
+  sum_.assign(length_, 0ull);
+  out_.assign(length_, 0u);
+}
+
+unsigned* RollingSum::add(const unsigned* frame)
+{
+  if (ring_.size() < nframes_) {
+    // the slot starts from zero, so the same pass only adds the frame
+    ring_.emplace_back(length_, 0u);
+    replace_frame(sum_.data(), ring_.back().data(), frame, length_);
+  }
+  else {
+    replace_frame(sum_.data(), ring_[oldest_].data(), frame, length_);
+    oldest_ = (oldest_ + 1) % ring_.size();
+  }
+  histo_convert::to_unsigned(sum_.data(), out_.data(), length_);
+  return out_.data();
+}
+
+std::size_t RollingSum::length() const
+{
+  return length_;
+}
@@ -0,0 +1,37 @@
+#ifndef ROLLINGSUM_HPP
+#define ROLLINGSUM_HPP
+
+/* Copyright 2022 Surface Concept GmbH */
+
+#include <cstddef>
+#include <vector>
+
+/**
+ * @brief The RollingSum class sums the histograms of the last n frames. It
+ * keeps a copy of each frame in a ring. A new frame is added to the sum and
+ * the frame from n frames ago is subtracted, in one pass over the data, so
+ * the cost per frame does not depend on n. The sum is kept with 64 bits,
+ * so it is exact, and handed out saturated at the maximum of unsigned.
+ */
+class RollingSum
+{
+public:
+  /** set the histogram length and the number of frames, clears the sum if
+   * either has changed */
+  void setup(std::size_t length, unsigned nframes);
+  void clear();
+  /** add a frame of length() elements, returns the sum of the last
+   * nframes frames (fewer after clear()) */
+  unsigned* add(const unsigned* frame);
+  std::size_t length() const;
+
+private:
+  std::size_t length_ = 0;
+  unsigned nframes_ = 0;
+  std::vector<std::vector<unsigned>> ring_; // grows up to nframes_ entries
+  std::size_t oldest_ = 0;                  // next slot to overwrite
+  std::vector<unsigned long long> sum_;
+  std::vector<unsigned> out_;               // sum_, saturated
+};
+
+#endif // ROLLINGSUM_HPP
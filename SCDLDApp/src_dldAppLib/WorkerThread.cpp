@@ -1,87 +1,257 @@
 /* Copyright 2022 Surface Concept GmbH */
 #include "WorkerThread.hpp"
-#include <thread>
-#include <queue>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <deque>
 #include <mutex>
-#include <memory>
-#include <iostream>
+#include <queue>
+#include <thread>
+#include <vector>
 #include "sema.h"
 
 struct WorkerThread::Priv {
   /* ---------------------------------------- */
   /*                data                      */
   /* ---------------------------------------- */
-  enum MessageType {
-    EMPTY_MESSAGE = 0,
-    ADD_TASK = 1,
-    TERMINATE = 2
+  // an entry of the queue, see the bounded MPMC queue by D. Vyukov:
+  // seq == pos: free for the producer of position pos,
+  // seq == pos + 1: holds the task of position pos for the consumer
+  struct Cell {
+    // first, so that a pointer to it is a pointer to the cell
+    alignas(std::max_align_t) unsigned char storage[TASK_STORAGE];
+    std::atomic<std::size_t> seq;
+    std::size_t pos;
+    TaskFn run;     // null for the terminate message
+    TaskFn destroy;
+    Clock::time_point posted;
+    bool heap = false; // in the overflow list, not in cells_
   };
-  struct Message {
-    Message() : mtype(EMPTY_MESSAGE) {}
-    Message(MessageType mt) : mtype(mt) {}
-    Message(MessageType mt, std::function<void()> t) : mtype(mt), task(t) {}
-    MessageType mtype;
+  static_assert((CAPACITY & (CAPACITY - 1)) == 0, "CAPACITY: power of two");
+  struct Timer {
+    Clock::time_point at;
+    unsigned long long seq; // equal deadlines run in the order of addTaskAt
     std::function<void()> task;
   };
-  std::queue< Message > messages_;
-  std::mutex messages_mutex_;
+  struct Later {
+    bool operator()(const Timer& a, const Timer& b) const {
+      return a.at > b.at || (a.at == b.at && a.seq > b.seq);
+    }
+  };
+
+  std::unique_ptr<Cell[]> cells_;
+  std::atomic<std::size_t> enqueue_pos_;
+  std::atomic<std::size_t> dequeue_pos_; // written by the worker thread only
+  // tasks that did not fit into cells_, they run after those in cells_
+  std::deque<std::unique_ptr<Cell> > overflow_;
+  std::mutex overflow_mutex_;
+  std::atomic<std::size_t> overflow_size_;
+  std::atomic<unsigned long long> overflowed_;
   std::unique_ptr<std::thread> thread_;
-  Semaphore sema_message_;
+  // spins briefly before sleeping, signalling costs no system call while the
+  // worker thread is busy
+  LightweightSemaphore sema_message_;
+  std::atomic<std::size_t> max_depth_;
+  std::atomic<unsigned long long> tasks_;
+  std::atomic<unsigned long long> latency_sum_ns_;
+  std::atomic<unsigned long long> latency_max_ns_;
+  // only accessed by the worker thread
+  std::priority_queue<Timer, std::vector<Timer>, Later> timers_;
+  unsigned long long timer_seq_;
+  ErrorHandler error_handler_;
 
   /* ---------------------------------------- */
   /*                functions                 */
   /* ---------------------------------------- */
-  Priv() { thread_.reset(new std::thread( [this](){ job(); } )); }
-  ~Priv() { terminate(); }
+  Priv()
+    : cells_(new Cell[CAPACITY]), enqueue_pos_(0), dequeue_pos_(0),
+      overflow_size_(0), overflowed_(0), max_depth_(0), tasks_(0), latency_sum_ns_(0), latency_max_ns_(0),
+      timer_seq_(0)
+  {
+    for (std::size_t i = 0; i < CAPACITY; i++) {
+      cells_[i].seq.store(i, std::memory_order_relaxed);
+    }
+    thread_.reset(new std::thread( [this](){ job(); } ));
+  }
+  ~Priv() {
+    terminate();
+    drain(); // tasks added while terminate() was running
+  }
   bool alive() const { return thread_.operator bool(); }
 
-  void addTask(std::function<void ()> t) {
-    if (!alive()) return;
-    {
-      std::lock_guard<std::mutex> l(messages_mutex_);
-      messages_.emplace(ADD_TASK, t);
+  Cell* claim() {
+    // while the overflow list is not empty, later tasks must not overtake
+    // the tasks in it
+    std::size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+    while (overflow_size_.load(std::memory_order_acquire) == 0) {
+      Cell& c = cells_[pos & (CAPACITY - 1)];
+      const std::size_t seq = c.seq.load(std::memory_order_acquire);
+      const std::ptrdiff_t dif = static_cast<std::ptrdiff_t>(seq - pos);
+      if (dif == 0) {
+        if (enqueue_pos_.compare_exchange_weak(
+              pos, pos + 1, std::memory_order_relaxed))
+        {
+          c.pos = pos;
+          update_max(max_depth_,
+                     pos + 1 - dequeue_pos_.load(std::memory_order_relaxed));
+          return &c;
+        }
+      }
+      else if (dif < 0) {
+        break; // full
+      }
+      else {
+        pos = enqueue_pos_.load(std::memory_order_relaxed);
+      }
+    }
+    overflowed_.fetch_add(1, std::memory_order_relaxed);
+    Cell* c = new Cell;
+    c->heap = true;
+    return c;
+  }
+
+  void commit(Cell& c, TaskFn run, TaskFn destroy) {
+    c.run = run;
+    c.destroy = destroy;
+    c.posted = Clock::now();
+    if (c.heap) {
+      std::lock_guard<std::mutex> l(overflow_mutex_);
+      overflow_.emplace_back(&c);
+      overflow_size_.fetch_add(1, std::memory_order_release);
+    }
+    else {
+      c.seq.store(c.pos + 1, std::memory_order_release);
     }
     sema_message_.signal();
   }
 
   void terminate() {
     if (!alive()) return;
-    {
-      std::lock_guard<std::mutex> l(messages_mutex_);
-      messages_.emplace(TERMINATE);
-    }
-    sema_message_.signal();
+    commit(*claim(), nullptr, nullptr);
     thread_->join();
     thread_.reset();
+    drain();
+    timers_ = decltype(timers_)();
+  }
+
+  // destroy the tasks behind the terminate message, without running them;
+  // only while the worker thread is not running
+  void drain() {
+    std::size_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+    while (enqueue_pos_.load(std::memory_order_acquire) != pos) {
+      Cell& c = cells_[pos & (CAPACITY - 1)];
+      while (c.seq.load(std::memory_order_acquire) != pos + 1) {
+        std::this_thread::yield(); // still in the hands of its producer
+      }
+      if (c.destroy) c.destroy(c.storage);
+      c.seq.store(pos + CAPACITY, std::memory_order_release);
+      dequeue_pos_.store(++pos, std::memory_order_relaxed);
+    }
+    std::deque<std::unique_ptr<Cell> > rest;
+    {
+      std::lock_guard<std::mutex> l(overflow_mutex_);
+      rest.swap(overflow_);
+      overflow_size_.store(0, std::memory_order_release);
+    }
+    for (std::unique_ptr<Cell>& c : rest) {
+      if (c->destroy) c->destroy(c->storage);
+    }
+  }
+
+  static void update_max(std::atomic<std::size_t>& m, std::size_t v) {
+    std::size_t cur = m.load(std::memory_order_relaxed);
+    while (v > cur && !m.compare_exchange_weak(
+             cur, v, std::memory_order_relaxed)) {}
+  }
+
+  void run_task(TaskFn run, void* storage) {
+    try {
+      run(storage);
+    } catch (const std::exception& e) {
+      report(e.what());
+    } catch (...) {
+      report("unknown exception");
+    }
+  }
+
+  void report(const char* msg) {
+    if (!error_handler_) return; // the owner did not ask for the errors
+    try {
+      error_handler_(msg);
+    } catch (...) {}
+  }
+
+  static void call(void* f) {
+    (*static_cast<std::function<void()>*>(f))();
+  }
+
+  // wait for the next entry, run the timers that are due meanwhile
+  void wait_for_message() {
+    while (!timers_.empty()) {
+      const Clock::time_point now = Clock::now();
+      if (timers_.top().at <= now) {
+        std::function<void()> f = timers_.top().task;
+        timers_.pop();
+        run_task(call, &f);
+        continue;
+      }
+      // rounded up, so that the timer is due when the wait times out
+      const auto us = std::chrono::duration_cast<std::chrono::microseconds>(
+        timers_.top().at - now + std::chrono::microseconds(1) -
+        Clock::duration(1));
+      if (sema_message_.wait(static_cast<std::int64_t>(us.count()))) {
+        return;
+      }
+    }
+    sema_message_.wait();
   }
 
   void job() {
     bool terminate = false;
     while (!terminate) {
-      sema_message_.wait();
-      Message entry;
-      {
-        std::lock_guard<std::mutex> l(messages_mutex_);
-        if (messages_.empty()) continue;
-        entry = messages_.front();
-        messages_.pop();
-      }
-      switch (entry.mtype)
-      {
-      case EMPTY_MESSAGE:
-        break;
-      case ADD_TASK:
-        try {
-          entry.task();
-        } catch (const std::exception& e) {
-          std::cerr << "WorkerThread: Exception " << e.what() << std::endl;
+      // one signal per committed entry; the entry at the head may still be
+      // in the hands of its producer if a later one was committed first
+      wait_for_message();
+      const std::size_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+      if (enqueue_pos_.load(std::memory_order_acquire) == pos) {
+        // nothing in cells_, so the entry is in the overflow list
+        std::unique_ptr<Cell> c;
+        {
+          std::lock_guard<std::mutex> l(overflow_mutex_);
+          if (overflow_.empty()) continue;
+          c = std::move(overflow_.front());
+          overflow_.pop_front();
+          overflow_size_.fetch_sub(1, std::memory_order_release);
         }
-        break;
-      case TERMINATE:
-        terminate = true;
-        break;
+        terminate = !run_cell(*c);
+        continue;
+      }
+      Cell& c = cells_[pos & (CAPACITY - 1)];
+      while (c.seq.load(std::memory_order_acquire) != pos + 1) {
+        std::this_thread::yield();
+      }
+      terminate = !run_cell(c);
+      c.seq.store(pos + CAPACITY, std::memory_order_release);
+      dequeue_pos_.store(pos + 1, std::memory_order_relaxed);
+    }
+  }
+
+  // false for the terminate message
+  bool run_cell(Cell& c) {
+    if (c.run) {
+      const unsigned long long ns = static_cast<unsigned long long>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+          Clock::now() - c.posted).count());
+      tasks_.fetch_add(1, std::memory_order_relaxed);
+      latency_sum_ns_.fetch_add(ns, std::memory_order_relaxed);
+      if (ns > latency_max_ns_.load(std::memory_order_relaxed)) {
+        latency_max_ns_.store(ns, std::memory_order_relaxed);
       }
+      run_task(c.run, c.storage);
+      c.destroy(c.storage);
+      return true;
     }
+    return false;
   }
 };
 
@@ -95,17 +265,56 @@ WorkerThread::~WorkerThread()
   terminate();
 }
 
-void WorkerThread::addTask(std::function<void ()> task)
+void WorkerThread::terminate()
 {
-  p_->addTask(task);
+  p_->terminate();
 }
 
-void WorkerThread::terminate()
+void WorkerThread::addTaskAt(
+  WorkerThread::Clock::time_point tp, std::function<void()> task)
 {
-  p_->terminate();
+  Priv* p = p_.get();
+  addTask([p, tp, task]() {
+    Priv::Timer t = {tp, p->timer_seq_++, task};
+    p->timers_.push(t);
+  });
+}
+
+void WorkerThread::setErrorHandler(WorkerThread::ErrorHandler handler)
+{
+  Priv* p = p_.get();
+  addTask([p, handler]() { p->error_handler_ = handler; });
 }
 
 bool WorkerThread::alive() const
 {
   return p_->alive();
 }
+
+WorkerThread::Stats WorkerThread::stats() const
+{
+  Stats s;
+  const std::size_t enq = p_->enqueue_pos_.load(std::memory_order_relaxed);
+  const std::size_t deq = p_->dequeue_pos_.load(std::memory_order_relaxed);
+  s.depth = enq - std::min(enq, deq)
+    + p_->overflow_size_.load(std::memory_order_relaxed);
+  s.max_depth = p_->max_depth_.load(std::memory_order_relaxed);
+  s.overflowed = p_->overflowed_.load(std::memory_order_relaxed);
+  s.tasks = p_->tasks_.load(std::memory_order_relaxed);
+  const unsigned long long sum =
+    p_->latency_sum_ns_.load(std::memory_order_relaxed);
+  s.mean_latency_us = s.tasks > 0 ? sum * 1e-3 / s.tasks : 0.0;
+  s.max_latency_us =
+    p_->latency_max_ns_.load(std::memory_order_relaxed) * 1e-3;
+  return s;
+}
+
+void* WorkerThread::claim()
+{
+  return p_->claim()->storage;
+}
+
+void WorkerThread::commit(void* storage, TaskFn run, TaskFn destroy)
+{
+  p_->commit(*static_cast<Priv::Cell*>(storage), run, destroy);
+}
@@ -75,6 +75,13 @@ int scdldapp_read_enum(int user_id, size_t pidx, int *value)
   return user_call(user_id, &Glue<DLD>::read_enum, pidx, value);
 }
 
+int scdldapp_write_arr1d(int user_id, size_t pidx, size_t arr_len_in_bytes,
+                         const void *data)
+{
+  return user_call(user_id, &Glue<DLD>::write_arr1d, pidx, arr_len_in_bytes,
+                   data);
+}
+
 int scdldapp_set_callback_int32(int user_id, void* priv, scdldapp_cb_int32 cb)
 {
   return user_call(user_id, &Glue<DLD>::set_callback_int32, priv, cb);
@@ -105,6 +112,17 @@ int scdldapp_set_callback_arr2d(int user_id, void* priv, scdldapp_cb_arr2d cb)
   return user_call(user_id, &Glue<DLD>::set_callback_arr2d, priv, cb);
 }
 
+int scdldapp_set_callback_arr3d(int user_id, void* priv, scdldapp_cb_arr3d cb)
+{
+  return user_call(user_id, &Glue<DLD>::set_callback_arr3d, priv, cb);
+}
+
+int scdldapp_set_callback_arr2d_typed(int user_id, void* priv,
+                                      scdldapp_cb_arr2d_typed cb)
+{
+  return user_call(user_id, &Glue<DLD>::set_callback_arr2d_typed, priv, cb);
+}
+
 int scdldapp_create_user()
 {
   static const int MAX_USERS = 100;
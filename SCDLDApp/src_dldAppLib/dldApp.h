@@ -21,7 +21,7 @@ extern "C"
 #endif // __cplusplus
 
 #define SC_DLD_APP_LIB_VER_MAJ 0
-#define SC_DLD_APP_LIB_VER_MIN 1
+#define SC_DLD_APP_LIB_VER_MIN 4
 #define SC_DLD_APP_LIB_VER_PAT 0
 
 /* ---------------   runtime interactions   ---------------------------- */
@@ -32,6 +32,19 @@ typedef void (*scdldapp_cb_enum)(void*, size_t, int);
 typedef void (*scdldapp_cb_arr1d)(void*, size_t, size_t arr_len_in_bytes, void* data);
 typedef void (*scdldapp_cb_arr2d)(void*, size_t, size_t arr_len_in_bytes,
                                   size_t width, void* data);
+/* 3d arrays: width and height of one slice, the slices follow each other */
+typedef void (*scdldapp_cb_arr3d)(void*, size_t, size_t arr_len_in_bytes,
+                                  size_t width, size_t height, void* data);
+/* 2d arrays sent with another element type than the one in the parameter
+ * configuration, e.g. the live image with a pixel type other than Int32.
+ * elemtype is one of the SCDLDAPP_ELEMTYPE_ constants. */
+typedef void (*scdldapp_cb_arr2d_typed)(void*, size_t, int elemtype,
+                                        size_t arr_len_in_bytes,
+                                        size_t width, void* data);
+#define SCDLDAPP_ELEMTYPE_U8  0x01
+#define SCDLDAPP_ELEMTYPE_U16 0x02
+#define SCDLDAPP_ELEMTYPE_U32 0x03
+#define SCDLDAPP_ELEMTYPE_I32 0x13
 
 /**
  * @brief create a user which is required in all other functions
@@ -61,6 +74,16 @@ LIBDLDAPP_PUBLIC int scdldapp_write_string(int user_id, size_t pidx, const char*
 LIBDLDAPP_PUBLIC int scdldapp_read_string(int user_id, size_t pidx, size_t* len, char* value);
 LIBDLDAPP_PUBLIC int scdldapp_write_enum(int user_id, size_t pidx, int value);
 LIBDLDAPP_PUBLIC int scdldapp_read_enum(int user_id, size_t pidx, int* value);
+/**
+ * @brief scdldapp_write_arr1d write a (not read-only) 1d array parameter,
+ * the new value is read back through the arr1d callback
+ * @param arr_len_in_bytes number of elements times the element size
+ * @param data elements of the type given in the parameter configuration
+ * @return 0 if successful, else negative
+ */
+LIBDLDAPP_PUBLIC int scdldapp_write_arr1d(int user_id, size_t pidx,
+                                          size_t arr_len_in_bytes,
+                                          const void* data);
 
 LIBDLDAPP_PUBLIC int scdldapp_set_callback_int32(int user_id, void* priv, scdldapp_cb_int32 cb);
 LIBDLDAPP_PUBLIC int scdldapp_set_callback_float64(int user_id, void* priv, scdldapp_cb_float64 cb);
@@ -68,6 +91,10 @@ LIBDLDAPP_PUBLIC int scdldapp_set_callback_string(int user_id, void* priv, scdld
 LIBDLDAPP_PUBLIC int scdldapp_set_callback_enum(int user_id, void* priv, scdldapp_cb_enum cb);
 LIBDLDAPP_PUBLIC int scdldapp_set_callback_arr1d(int user_id, void* priv, scdldapp_cb_arr1d cb);
 LIBDLDAPP_PUBLIC int scdldapp_set_callback_arr2d(int user_id, void* priv, scdldapp_cb_arr2d cb);
+LIBDLDAPP_PUBLIC int scdldapp_set_callback_arr3d(int user_id, void* priv, scdldapp_cb_arr3d cb);
+/* without this callback, updates of 2d arrays with another element type than
+ * configured are not passed on */
+LIBDLDAPP_PUBLIC int scdldapp_set_callback_arr2d_typed(int user_id, void* priv, scdldapp_cb_arr2d_typed cb);
 
 LIBDLDAPP_PUBLIC const char* scdldapp_get_param_config_json();
 LIBDLDAPP_PUBLIC void scdldapp_get_version(int* ver_maj, int* ver_min, int* ver_pat);
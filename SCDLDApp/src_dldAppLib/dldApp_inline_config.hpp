@@ -188,6 +188,42 @@ const char* param_config_data =
   "  },\n"
   "  {\n"
   "    \"node\":\"parameter\",\n"
+  "    \"name\":\"GaplessFrames\",\n"
+  "    \"display name\":\"gapless frames\",\n"
+  "    \"description\":\"frames cut from event stream\",\n"
+  "    \"data type\":\"enum\",\n"
+  "    \"read-only\":false,\n"
+  "    \"default\":\"OFF\",\n"
+  "    \"persistent\":true,\n"
+  "    \"unit\":\"\",\n"
+  "    \"options\":{\n"
+  "      \"OFF\":0,\n"
+  "      \"ON\":1\n"
+  "    },\n"
+  "    \"epicsprops\":{\n"
+  "      \"asynportname\":\"DLD_GAPLESS\"\n"
+  "    }\n"
+  "  },\n"
+  "  {\n"
+  "    \"node\":\"parameter\",\n"
+  "    \"name\":\"HistoThreads\",\n"
+  "    \"display name\":\"histogram threads\",\n"
+  "    \"description\":\"histo threads, 0: automatic\",\n"
+  "    \"data type\":\"int32\",\n"
+  "    \"read-only\":false,\n"
+  "    \"default\":0,\n"
+  "    \"persistent\":true,\n"
+  "    \"unit\":\"\",\n"
+  "    \"range\":{\n"
+  "      \"min\":0,\n"
+  "      \"max\":64\n"
+  "    },\n"
+  "    \"epicsprops\":{\n"
+  "      \"asynportname\":\"DLD_HISTO_THREADS\"\n"
+  "    }\n"
+  "  },\n"
+  "  {\n"
+  "    \"node\":\"parameter\",\n"
   "    \"name\":\"BinX\",\n"
   "    \"display name\":\"Binning X\",\n"
   "    \"description\":\"log_2 of binning in x direction\",\n"
@@ -418,6 +454,62 @@ const char* param_config_data =
   "  },\n"
   "  {\n"
   "    \"node\":\"parameter\",\n"
+  "    \"name\":\"LiveImageXYWindow\",\n"
+  "    \"display name\":\"accumulation window live image XY\",\n"
+  "    \"description\":\"frames summed up, 0: all\",\n"
+  "    \"data type\":\"int32\",\n"
+  "    \"read-only\":false,\n"
+  "    \"default\":0,\n"
+  "    \"persistent\":true,\n"
+  "    \"unit\":\"\",\n"
+  "    \"range\":{\n"
+  "      \"min\":0,\n"
+  "      \"max\":256\n"
+  "    },\n"
+  "    \"epicsprops\":{\n"
+  "      \"asynportname\":\"LIVE_XY_WINDOW\"\n"
+  "    }\n"
+  "  },\n"
+  "  {\n"
+  "    \"node\":\"parameter\",\n"
+  "    \"name\":\"LiveImageXYAccumDepth\",\n"
+  "    \"display name\":\"accumulation depth live image XY\",\n"
+  "    \"description\":\"counts when summing all\",\n"
+  "    \"data type\":\"enum\",\n"
+  "    \"read-only\":false,\n"
+  "    \"default\":\"32 bit\",\n"
+  "    \"persistent\":true,\n"
+  "    \"unit\":\"\",\n"
+  "    \"options\":{\n"
+  "      \"32 bit\":0,\n"
+  "      \"64 bit\":1\n"
+  "    },\n"
+  "    \"epicsprops\":{\n"
+  "      \"asynportname\":\"LIVE_XY_ACCUM_DEPTH\"\n"
+  "    }\n"
+  "  },\n"
+  "  {\n"
+  "    \"node\":\"parameter\",\n"
+  "    \"name\":\"LiveImageXYPixelType\",\n"
+  "    \"display name\":\"pixel type live image XY\",\n"
+  "    \"description\":\"counts clipped at max value\",\n"
+  "    \"data type\":\"enum\",\n"
+  "    \"read-only\":false,\n"
+  "    \"default\":\"Int32\",\n"
+  "    \"persistent\":true,\n"
+  "    \"unit\":\"\",\n"
+  "    \"options\":{\n"
+  "      \"Int32\":0,\n"
+  "      \"UInt32\":1,\n"
+  "      \"UInt16\":2,\n"
+  "      \"UInt8\":3\n"
+  "    },\n"
+  "    \"epicsprops\":{\n"
+  "      \"asynportname\":\"LIVE_XY_PIXEL_TYPE\"\n"
+  "    }\n"
+  "  },\n"
+  "  {\n"
+  "    \"node\":\"parameter\",\n"
   "    \"name\":\"TimeHistoDataX\",\n"
   "    \"display name\":\"time histogram, x values\",\n"
   "    \"description\":\"\",\n"
@@ -466,6 +558,230 @@ const char* param_config_data =
   "  },\n"
   "  {\n"
   "    \"node\":\"parameter\",\n"
+  "    \"name\":\"TimeHistoWindow\",\n"
+  "    \"display name\":\"accumulation window time histogram\",\n"
+  "    \"description\":\"frames summed up, 0: all\",\n"
+  "    \"data type\":\"int32\",\n"
+  "    \"read-only\":false,\n"
+  "    \"default\":0,\n"
+  "    \"persistent\":true,\n"
+  "    \"unit\":\"\",\n"
+  "    \"range\":{\n"
+  "      \"min\":0,\n"
+  "      \"max\":256\n"
+  "    },\n"
+  "    \"epicsprops\":{\n"
+  "      \"asynportname\":\"TIME_HISTO_WINDOW\"\n"
+  "    }\n"
+  "  },\n"
+  "  {\n"
+  "    \"node\":\"parameter\",\n"
+  "    \"name\":\"TimeHistoAccumDepth\",\n"
+  "    \"display name\":\"accumulation depth time histogram\",\n"
+  "    \"description\":\"counts when summing all\",\n"
+  "    \"data type\":\"enum\",\n"
+  "    \"read-only\":false,\n"
+  "    \"default\":\"32 bit\",\n"
+  "    \"persistent\":true,\n"
+  "    \"unit\":\"\",\n"
+  "    \"options\":{\n"
+  "      \"32 bit\":0,\n"
+  "      \"64 bit\":1\n"
+  "    },\n"
+  "    \"epicsprops\":{\n"
+  "      \"asynportname\":\"TIME_HISTO_ACCUM_DEPTH\"\n"
+  "    }\n"
+  "  },\n"
+  "  {\n"
+  "    \"node\":\"parameter\",\n"
+  "    \"name\":\"GatedImagesTSI\",\n"
+  "    \"display name\":\"time gates of XY images\",\n"
+  "    \"description\":\"start, length per gate\",\n"
+  "    \"data type\":\"array1d\",\n"
+  "    \"element data type\":\"f64\",\n"
+  "    \"maxlen\":8,\n"
+  "    \"read-only\":false,\n"
+  "    \"persistent\":true,\n"
+  "    \"default\":\"\",\n"
+  "    \"unit\":\"ns\",\n"
+  "    \"epicsprops\":{\n"
+  "      \"asynportname\":\"DLD_GATED_IMAGES_TSI\"\n"
+  "    }\n"
+  "  },\n"
+  "  {\n"
+  "    \"node\":\"parameter\",\n"
+  "    \"name\":\"GatedImagesXY\",\n"
+  "    \"display name\":\"time gated XY images\",\n"
+  "    \"description\":\"images of the time gates, stacked in y\",\n"
+  "    \"data type\":\"array2d\",\n"
+  "    \"element data type\":\"i32\",\n"
+  "    \"maxlen\":16000000,\n"
+  "    \"read-only\":true,\n"
+  "    \"default\":\"\",\n"
+  "    \"unit\":\"\",\n"
+  "    \"epicsprops\":{\n"
+  "      \"asynportname\":\"\",\n"
+  "      \"address\":1\n"
+  "    }\n"
+  "  },\n"
+  "  {\n"
+  "    \"node\":\"parameter\",\n"
+  "    \"name\":\"GatedHistosXY\",\n"
+  "    \"display name\":\"XY gates of time histograms\",\n"
+  "    \"description\":\"x, y, width, height per gate\",\n"
+  "    \"data type\":\"array1d\",\n"
+  "    \"element data type\":\"i32\",\n"
+  "    \"maxlen\":16,\n"
+  "    \"read-only\":false,\n"
+  "    \"persistent\":true,\n"
+  "    \"default\":\"\",\n"
+  "    \"unit\":\"\",\n"
+  "    \"epicsprops\":{\n"
+  "      \"asynportname\":\"DLD_GATED_HISTOS_XY\"\n"
+  "    }\n"
+  "  },\n"
+  "  {\n"
+  "    \"node\":\"parameter\",\n"
+  "    \"name\":\"GatedTimeHistos\",\n"
+  "    \"display name\":\"XY gated time histograms\",\n"
+  "    \"description\":\"histograms of the XY gates\",\n"
+  "    \"data type\":\"array1d\",\n"
+  "    \"element data type\":\"f64\",\n"
+  "    \"maxlen\":16000000,\n"
+  "    \"read-only\":true,\n"
+  "    \"default\":\"\",\n"
+  "    \"unit\":\"\",\n"
+  "    \"epicsprops\":{\n"
+  "      \"asynportname\":\"DLD_GATED_TIME_HISTOS\"\n"
+  "    }\n"
+  "  },\n"
+  "  {\n"
+  "    \"node\":\"parameter\",\n"
+  "    \"name\":\"XYTCube\",\n"
+  "    \"display name\":\"XYT cube\",\n"
+  "    \"description\":\"acquire the XYT cube\",\n"
+  "    \"data type\":\"enum\",\n"
+  "    \"read-only\":false,\n"
+  "    \"default\":\"OFF\",\n"
+  "    \"persistent\":true,\n"
+  "    \"unit\":\"\",\n"
+  "    \"options\":{\n"
+  "      \"OFF\":0,\n"
+  "      \"ON\":1\n"
+  "    },\n"
+  "    \"epicsprops\":{\n"
+  "      \"asynportname\":\"DLD_XYT_CUBE\"\n"
+  "    }\n"
+  "  },\n"
+  "  {\n"
+  "    \"node\":\"parameter\",\n"
+  "    \"name\":\"XYTBinX\",\n"
+  "    \"display name\":\"XYT cube binning x\",\n"
+  "    \"description\":\"x binning (2^n) of the cube\",\n"
+  "    \"data type\":\"int32\",\n"
+  "    \"read-only\":false,\n"
+  "    \"default\":3,\n"
+  "    \"persistent\":true,\n"
+  "    \"unit\":\"\",\n"
+  "    \"range\":{\n"
+  "      \"min\":0,\n"
+  "      \"max\":15\n"
+  "    },\n"
+  "    \"epicsprops\":{\n"
+  "      \"asynportname\":\"DLD_XYT_BIN_X\"\n"
+  "    }\n"
+  "  },\n"
+  "  {\n"
+  "    \"node\":\"parameter\",\n"
+  "    \"name\":\"XYTBinY\",\n"
+  "    \"display name\":\"XYT cube binning y\",\n"
+  "    \"description\":\"y binning (2^n) of the cube\",\n"
+  "    \"data type\":\"int32\",\n"
+  "    \"read-only\":false,\n"
+  "    \"default\":3,\n"
+  "    \"persistent\":true,\n"
+  "    \"unit\":\"\",\n"
+  "    \"range\":{\n"
+  "      \"min\":0,\n"
+  "      \"max\":15\n"
+  "    },\n"
+  "    \"epicsprops\":{\n"
+  "      \"asynportname\":\"DLD_XYT_BIN_Y\"\n"
+  "    }\n"
+  "  },\n"
+  "  {\n"
+  "    \"node\":\"parameter\",\n"
+  "    \"name\":\"XYTSizeT\",\n"
+  "    \"display name\":\"XYT cube time slices\",\n"
+  "    \"description\":\"time slices of the cube\",\n"
+  "    \"data type\":\"int32\",\n"
+  "    \"read-only\":false,\n"
+  "    \"default\":64,\n"
+  "    \"persistent\":true,\n"
+  "    \"unit\":\"\",\n"
+  "    \"range\":{\n"
+  "      \"min\":1,\n"
+  "      \"max\":65536\n"
+  "    },\n"
+  "    \"epicsprops\":{\n"
+  "      \"asynportname\":\"DLD_XYT_SIZE_T\"\n"
+  "    }\n"
+  "  },\n"
+  "  {\n"
+  "    \"node\":\"parameter\",\n"
+  "    \"name\":\"XYTMaxMiB\",\n"
+  "    \"display name\":\"XYT cube memory limit\",\n"
+  "    \"description\":\"memory limit of the cube\",\n"
+  "    \"data type\":\"int32\",\n"
+  "    \"read-only\":false,\n"
+  "    \"default\":64,\n"
+  "    \"persistent\":true,\n"
+  "    \"unit\":\"MiB\",\n"
+  "    \"range\":{\n"
+  "      \"min\":1,\n"
+  "      \"max\":256\n"
+  "    },\n"
+  "    \"epicsprops\":{\n"
+  "      \"asynportname\":\"DLD_XYT_MAX_MIB\"\n"
+  "    }\n"
+  "  },\n"
+  "  {\n"
+  "    \"node\":\"parameter\",\n"
+  "    \"name\":\"XYTSliceNs\",\n"
+  "    \"display name\":\"XYT cube time slice width\",\n"
+  "    \"description\":\"width of one time slice\",\n"
+  "    \"data type\":\"float64\",\n"
+  "    \"read-only\":true,\n"
+  "    \"persistent\":false,\n"
+  "    \"default\":0.0,\n"
+  "    \"unit\":\"ns\",\n"
+  "    \"range\":{\n"
+  "      \"min\":0.0,\n"
+  "      \"max\":1e9\n"
+  "    },\n"
+  "    \"precision\":3,\n"
+  "    \"epicsprops\":{\n"
+  "      \"asynportname\":\"DLD_XYT_SLICE_NS\"\n"
+  "    }\n"
+  "  },\n"
+  "  {\n"
+  "    \"node\":\"parameter\",\n"
+  "    \"name\":\"XYTCubeData\",\n"
+  "    \"display name\":\"XYT cube\",\n"
+  "    \"description\":\"XY slices, one per time bin\",\n"
+  "    \"data type\":\"array3d\",\n"
+  "    \"element data type\":\"i32\",\n"
+  "    \"maxlen\":67108864,\n"
+  "    \"read-only\":true,\n"
+  "    \"default\":\"\",\n"
+  "    \"unit\":\"\",\n"
+  "    \"epicsprops\":{\n"
+  "      \"asynportname\":\"\",\n"
+  "      \"address\":2\n"
+  "    }\n"
+  "  },\n"
+  "  {\n"
+  "    \"node\":\"parameter\",\n"
   "    \"name\":\"H5EventsFilePath\",\n"
   "    \"display name\":\"HDF5 events file path\",\n"
   "    \"description\":\"\",\n"
@@ -529,5 +845,301 @@ const char* param_config_data =
   "    \"epicsprops\":{\n"
   "      \"asynportname\":\"DLD_H5EVENTS_FILEERROR\"\n"
   "    }\n"
+  "  },\n"
+  "  {\n"
+  "    \"node\":\"parameter\",\n"
+  "    \"name\":\"H5EventsPageSize\",\n"
+  "    \"display name\":\"HDF5 events page size\",\n"
+  "    \"description\":\"events per buffer page (one HDF5 append per page)\",\n"
+  "    \"data type\":\"int32\",\n"
+  "    \"read-only\":false,\n"
+  "    \"persistent\":true,\n"
+  "    \"default\":262144,\n"
+  "    \"unit\":\"events\",\n"
+  "    \"range\":{\n"
+  "      \"min\":1,\n"
+  "      \"max\":16777216\n"
+  "    },\n"
+  "    \"epicsprops\":{\n"
+  "      \"asynportname\":\"DLD_H5EVENTS_PAGESIZE\"\n"
+  "    }\n"
+  "  },\n"
+  "  {\n"
+  "    \"node\":\"parameter\",\n"
+  "    \"name\":\"H5EventsChunkSize\",\n"
+  "    \"display name\":\"HDF5 events chunk size\",\n"
+  "    \"description\":\"events per HDF5 chunk, 0: automatic from event rate\",\n"
+  "    \"data type\":\"int32\",\n"
+  "    \"read-only\":false,\n"
+  "    \"persistent\":true,\n"
+  "    \"default\":0,\n"
+  "    \"unit\":\"events\",\n"
+  "    \"range\":{\n"
+  "      \"min\":0,\n"
+  "      \"max\":16777216\n"
+  "    },\n"
+  "    \"epicsprops\":{\n"
+  "      \"asynportname\":\"DLD_H5EVENTS_CHUNKSIZE\"\n"
+  "    }\n"
+  "  },\n"
+  "  {\n"
+  "    \"node\":\"parameter\",\n"
+  "    \"name\":\"H5EventsChunkCache\",\n"
+  "    \"display name\":\"HDF5 events chunk cache\",\n"
+  "    \"description\":\"chunk cache per dataset, 0: automatic (two chunks)\",\n"
+  "    \"data type\":\"int32\",\n"
+  "    \"read-only\":false,\n"
+  "    \"persistent\":true,\n"
+  "    \"default\":0,\n"
+  "    \"unit\":\"MiB\",\n"
+  "    \"range\":{\n"
+  "      \"min\":0,\n"
+  "      \"max\":4096\n"
+  "    },\n"
+  "    \"epicsprops\":{\n"
+  "      \"asynportname\":\"DLD_H5EVENTS_CHUNKCACHE\"\n"
+  "    }\n"
+  "  },\n"
+  "  {\n"
+  "    \"node\":\"parameter\",\n"
+  "    \"name\":\"H5EventsCompression\",\n"
+  "    \"display name\":\"HDF5 events compression\",\n"
+  "    \"description\":\"codec of the event datasets\",\n"
+  "    \"data type\":\"enum\",\n"
+  "    \"read-only\":false,\n"
+  "    \"persistent\":true,\n"
+  "    \"default\":\"None\",\n"
+  "    \"unit\":\"\",\n"
+  "    \"options\":{\n"
+  "      \"None\":0,\n"
+  "      \"Deflate\":1,\n"
+  "      \"LZ4\":2,\n"
+  "      \"Zstd\":3\n"
+  "    },\n"
+  "    \"epicsprops\":{\n"
+  "      \"asynportname\":\"DLD_H5EVENTS_COMPRESSION\"\n"
+  "    }\n"
+  "  },\n"
+  "  {\n"
+  "    \"node\":\"parameter\",\n"
+  "    \"name\":\"H5EventsPackLevel\",\n"
+  "    \"display name\":\"HDF5 events pack level\",\n"
+  "    \"description\":\"codec level, 0: default\",\n"
+  "    \"data type\":\"int32\",\n"
+  "    \"read-only\":false,\n"
+  "    \"persistent\":true,\n"
+  "    \"default\":0,\n"
+  "    \"unit\":\"\",\n"
+  "    \"range\":{\n"
+  "      \"min\":0,\n"
+  "      \"max\":22\n"
+  "    },\n"
+  "    \"epicsprops\":{\n"
+  "      \"asynportname\":\"DLD_H5EVENTS_PACKLEVEL\"\n"
+  "    }\n"
+  "  },\n"
+  "  {\n"
+  "    \"node\":\"parameter\",\n"
+  "    \"name\":\"H5EventsRawCapture\",\n"
+  "    \"display name\":\"HDF5 events raw capture\",\n"
+  "    \"description\":\"raw capture to <path>.raw\",\n"
+  "    \"data type\":\"enum\",\n"
+  "    \"read-only\":false,\n"
+  "    \"persistent\":true,\n"
+  "    \"default\":\"OFF\",\n"
+  "    \"unit\":\"\",\n"
+  "    \"options\":{\n"
+  "      \"OFF\":0,\n"
+  "      \"ON\":1\n"
+  "    },\n"
+  "    \"epicsprops\":{\n"
+  "      \"asynportname\":\"DLD_H5EVENTS_RAWCAPTURE\"\n"
+  "    }\n"
+  "  },\n"
+  "  {\n"
+  "    \"node\":\"parameter\",\n"
+  "    \"name\":\"H5EventsRotateMiB\",\n"
+  "    \"display name\":\"HDF5 events rotate size\",\n"
+  "    \"description\":\"new file after MiB, 0: off\",\n"
+  "    \"data type\":\"int32\",\n"
+  "    \"read-only\":false,\n"
+  "    \"persistent\":true,\n"
+  "    \"default\":0,\n"
+  "    \"unit\":\"MiB\",\n"
+  "    \"range\":{\n"
+  "      \"min\":0,\n"
+  "      \"max\":16777216\n"
+  "    },\n"
+  "    \"epicsprops\":{\n"
+  "      \"asynportname\":\"DLD_H5EVENTS_ROTATEMIB\"\n"
+  "    }\n"
+  "  },\n"
+  "  {\n"
+  "    \"node\":\"parameter\",\n"
+  "    \"name\":\"H5EventsRotateSeconds\",\n"
+  "    \"display name\":\"HDF5 events rotate time\",\n"
+  "    \"description\":\"new file after s, 0: off\",\n"
+  "    \"data type\":\"int32\",\n"
+  "    \"read-only\":false,\n"
+  "    \"persistent\":true,\n"
+  "    \"default\":0,\n"
+  "    \"unit\":\"s\",\n"
+  "    \"range\":{\n"
+  "      \"min\":0,\n"
+  "      \"max\":604800\n"
+  "    },\n"
+  "    \"epicsprops\":{\n"
+  "      \"asynportname\":\"DLD_H5EVENTS_ROTATESECONDS\"\n"
+  "    }\n"
+  "  },\n"
+  "  {\n"
+  "    \"node\":\"parameter\",\n"
+  "    \"name\":\"H5EventsVDSMaster\",\n"
+  "    \"display name\":\"HDF5 events VDS master file\",\n"
+  "    \"description\":\"master file of all parts\",\n"
+  "    \"data type\":\"enum\",\n"
+  "    \"read-only\":false,\n"
+  "    \"persistent\":true,\n"
+  "    \"default\":\"OFF\",\n"
+  "    \"unit\":\"\",\n"
+  "    \"options\":{\n"
+  "      \"OFF\":0,\n"
+  "      \"ON\":1\n"
+  "    },\n"
+  "    \"epicsprops\":{\n"
+  "      \"asynportname\":\"DLD_H5EVENTS_VDSMASTER\"\n"
+  "    }\n"
+  "  },\n"
+  "  {\n"
+  "    \"node\":\"parameter\",\n"
+  "    \"name\":\"H5EventsReceived\",\n"
+  "    \"display name\":\"HDF5 events received\",\n"
+  "    \"description\":\"events passed to the writer\",\n"
+  "    \"data type\":\"float64\",\n"
+  "    \"read-only\":true,\n"
+  "    \"persistent\":false,\n"
+  "    \"default\":0.0,\n"
+  "    \"unit\":\"events\",\n"
+  "    \"range\":{\n"
+  "      \"min\":0.0,\n"
+  "      \"max\":1e18\n"
+  "    },\n"
+  "    \"precision\":0,\n"
+  "    \"epicsprops\":{\n"
+  "      \"asynportname\":\"DLD_H5EVENTS_RECEIVED\"\n"
+  "    }\n"
+  "  },\n"
+  "  {\n"
+  "    \"node\":\"parameter\",\n"
+  "    \"name\":\"H5EventsWritten\",\n"
+  "    \"display name\":\"HDF5 events written\",\n"
+  "    \"description\":\"events written to the file\",\n"
+  "    \"data type\":\"float64\",\n"
+  "    \"read-only\":true,\n"
+  "    \"persistent\":false,\n"
+  "    \"default\":0.0,\n"
+  "    \"unit\":\"events\",\n"
+  "    \"range\":{\n"
+  "      \"min\":0.0,\n"
+  "      \"max\":1e18\n"
+  "    },\n"
+  "    \"precision\":0,\n"
+  "    \"epicsprops\":{\n"
+  "      \"asynportname\":\"DLD_H5EVENTS_WRITTEN\"\n"
+  "    }\n"
+  "  },\n"
+  "  {\n"
+  "    \"node\":\"parameter\",\n"
+  "    \"name\":\"H5EventsDropped\",\n"
+  "    \"display name\":\"HDF5 events dropped\",\n"
+  "    \"description\":\"events lost, ring full\",\n"
+  "    \"data type\":\"float64\",\n"
+  "    \"read-only\":true,\n"
+  "    \"persistent\":false,\n"
+  "    \"default\":0.0,\n"
+  "    \"unit\":\"events\",\n"
+  "    \"range\":{\n"
+  "      \"min\":0.0,\n"
+  "      \"max\":1e18\n"
+  "    },\n"
+  "    \"precision\":0,\n"
+  "    \"epicsprops\":{\n"
+  "      \"asynportname\":\"DLD_H5EVENTS_DROPPED\"\n"
+  "    }\n"
+  "  },\n"
+  "  {\n"
+  "    \"node\":\"parameter\",\n"
+  "    \"name\":\"H5EventsWriteRate\",\n"
+  "    \"display name\":\"HDF5 events write rate\",\n"
+  "    \"description\":\"data written per second\",\n"
+  "    \"data type\":\"float64\",\n"
+  "    \"read-only\":true,\n"
+  "    \"persistent\":false,\n"
+  "    \"default\":0.0,\n"
+  "    \"unit\":\"MB/s\",\n"
+  "    \"range\":{\n"
+  "      \"min\":0.0,\n"
+  "      \"max\":1e6\n"
+  "    },\n"
+  "    \"precision\":1,\n"
+  "    \"epicsprops\":{\n"
+  "      \"asynportname\":\"DLD_H5EVENTS_WRITERATE\"\n"
+  "    }\n"
+  "  },\n"
+  "  {\n"
+  "    \"node\":\"parameter\",\n"
+  "    \"name\":\"H5EventsRingFill\",\n"
+  "    \"display name\":\"HDF5 events ring fill level\",\n"
+  "    \"description\":\"full pages waiting for disk\",\n"
+  "    \"data type\":\"int32\",\n"
+  "    \"read-only\":true,\n"
+  "    \"default\":\"0\",\n"
+  "    \"persistent\":false,\n"
+  "    \"unit\":\"pages\",\n"
+  "    \"range\":{\n"
+  "      \"min\":0,\n"
+  "      \"max\":65536\n"
+  "    },\n"
+  "    \"epicsprops\":{\n"
+  "      \"asynportname\":\"DLD_H5EVENTS_RINGFILL\"\n"
+  "    }\n"
+  "  },\n"
+  "  {\n"
+  "    \"node\":\"parameter\",\n"
+  "    \"name\":\"H5EventsPushTime\",\n"
+  "    \"display name\":\"HDF5 events push time\",\n"
+  "    \"description\":\"readout thread time in push\",\n"
+  "    \"data type\":\"float64\",\n"
+  "    \"read-only\":true,\n"
+  "    \"persistent\":false,\n"
+  "    \"default\":0.0,\n"
+  "    \"unit\":\"s\",\n"
+  "    \"range\":{\n"
+  "      \"min\":0.0,\n"
+  "      \"max\":1e9\n"
+  "    },\n"
+  "    \"precision\":3,\n"
+  "    \"epicsprops\":{\n"
+  "      \"asynportname\":\"DLD_H5EVENTS_PUSHTIME\"\n"
+  "    }\n"
+  "  },\n"
+  "  {\n"
+  "    \"node\":\"parameter\",\n"
+  "    \"name\":\"H5EventsMaxAppend\",\n"
+  "    \"display name\":\"HDF5 events max append time\",\n"
+  "    \"description\":\"longest file write\",\n"
+  "    \"data type\":\"float64\",\n"
+  "    \"read-only\":true,\n"
+  "    \"persistent\":false,\n"
+  "    \"default\":0.0,\n"
+  "    \"unit\":\"ms\",\n"
+  "    \"range\":{\n"
+  "      \"min\":0.0,\n"
+  "      \"max\":1e9\n"
+  "    },\n"
+  "    \"precision\":3,\n"
+  "    \"epicsprops\":{\n"
+  "      \"asynportname\":\"DLD_H5EVENTS_MAXAPPEND\"\n"
+  "    }\n"
   "  }\n"
   "]\n";
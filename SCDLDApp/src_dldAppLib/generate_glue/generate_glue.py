@@ -62,6 +62,17 @@ def upd_fun_arr1d(elem_datatype):
     return s.replace('<PIDX>', str(pidx)).replace('<NAME>', name)
   return upd
 
+# --- write functions, 1d arrays ---------------------------------------------
+# the library class implements int write_<NAME>(size_t nr_elem, const C_TYPE*),
+# the new value is read back through the update function of the array
+def reg_wr_arr1d(elem_datatype, pidx, name):
+  c_type = element_data_type_to_ctype[elem_datatype]
+  s = '    write_arr1d_funs.insert({<PIDX>, [](T* t, size_t n, const void* d) {\n' \
+      '      return t->write_<NAME>(n / sizeof(<C_TYPE>), ' \
+      'static_cast<const <C_TYPE>*>(d)); }});\n'
+  return s.replace('<PIDX>', str(pidx)).replace('<NAME>', name).replace(
+    '<C_TYPE>', c_type)
+
 # --- update function 2d array ------------------------------------------------
 
 # example
@@ -78,6 +89,42 @@ def upd_fun_arr2d(elem_datatype):
     return s.replace('<PIDX>', str(pidx)).replace('<NAME>', name)
   return upd
 
+# example of the overload for other element types than configured
+#  template <typename E>
+#  void update_LiveImageXY(size_t nr_elem, size_t width, E* data) {
+#    if (cb_arr2d_typed.cb) cb_arr2d_typed.cb(cb_arr2d_typed.priv, 9,
+#      elemtype(data), nr_elem*sizeof(E), width, data); }
+# (the callback is optional, clients of older library versions don't set it)
+
+def upd_fun_arr2d_typed():
+  s = '  template <typename E>\n' \
+      '  void update_<NAME>(size_t nr_elem, size_t width, E* data) {\n    ' \
+      'if (cb_arr2d_typed.cb) cb_arr2d_typed.cb(cb_arr2d_typed.priv, <PIDX>, ' \
+      'elemtype(data), nr_elem*sizeof(E), width, data); }\n'
+  def upd(pidx, name):
+    return s.replace('<PIDX>', str(pidx)).replace('<NAME>', name)
+  return upd
+
+# --- update function 3d array ------------------------------------------------
+
+# example
+#  void update_XYTCubeData(size_t nr_elem, size_t width, size_t height,
+#                          int* data) {
+#    if (cb_arr3d.cb) cb_arr3d.cb(cb_arr3d.priv, 33, nr_elem*sizeof(int),
+#                                 width, height, data); }
+# (the callback is optional, clients of older library versions don't set it)
+
+def upd_fun_arr3d(elem_datatype):
+  c_type = element_data_type_to_ctype[elem_datatype]
+  s = '  void update_<NAME>(size_t nr_elem, size_t width, size_t height, ' \
+      '<C_TYPE>* data) {\n    ' \
+      'if (cb_arr3d.cb) cb_arr3d.cb(cb_arr3d.priv, <PIDX>, ' \
+      'nr_elem*sizeof(<C_TYPE>), width, height, data); }\n'
+  s = s.replace('<C_TYPE>', c_type)
+  def upd(pidx, name):
+    return s.replace('<PIDX>', str(pidx)).replace('<NAME>', name)
+  return upd
+
 # -----------------------------------------------------------------------------
 def generate_glue(infile, outfile):
   with open(infile, "r") as f_in:
@@ -91,8 +138,13 @@ def generate_glue(infile, outfile):
         if param['node'] != 'parameter':
           continue
         pidx += 1
-        if param['data type'] in ('array1d', 'array2d'):
-          continue # no read/write funcs for arrays, yet.
+        if param['data type'] == 'array1d':
+          if not param['read-only']:
+            f_out.write(reg_wr_arr1d(param['element data type'], pidx,
+                                     param['name']))
+          continue # arrays are read back through their update functions
+        if param['data type'] in ('array2d', 'array3d'):
+          continue # no read/write funcs for 2d/3d arrays, yet.
         if not param['read-only']:
           f_out.write(reg_wr[param['data type']](pidx, param['name']))
         f_out.write(reg_rd[param['data type']](pidx, param['name']))
@@ -108,6 +160,9 @@ def generate_glue(infile, outfile):
           f_out.write(upd_fun_arr1d(param['element data type'])(pidx, param['name']))
         elif param['data type'] == 'array2d':
           f_out.write(upd_fun_arr2d(param['element data type'])(pidx, param['name']))
+          f_out.write(upd_fun_arr2d_typed()(pidx, param['name']))
+        elif param['data type'] == 'array3d':
+          f_out.write(upd_fun_arr3d(param['element data type'])(pidx, param['name']))
         else:
           f_out.write(upd[param['data type']](pidx, param['name']))
       # -----------
@@ -30,6 +30,11 @@ class Glue
   typedef void (*cb_arr1d_t)(void*, size_t, size_t arr_len_in_bytes, void* data);
   typedef void (*cb_arr2d_t)(void*, size_t, size_t arr_len_in_bytes,
                                     size_t width, void* data);
+  typedef void (*cb_arr3d_t)(void*, size_t, size_t arr_len_in_bytes,
+                                    size_t width, size_t height, void* data);
+  typedef void (*cb_arr2d_typed_t)(void*, size_t, int elemtype,
+                                   size_t arr_len_in_bytes, size_t width,
+                                   void* data);
   template <typename CBType>
   struct RegCallback
   {
@@ -45,6 +50,13 @@ class Glue
   RegCallback<cb_enum_t> cb_enum;
   RegCallback<cb_arr1d_t> cb_arr1d;
   RegCallback<cb_arr2d_t> cb_arr2d;
+  RegCallback<cb_arr3d_t> cb_arr3d;
+  RegCallback<cb_arr2d_typed_t> cb_arr2d_typed;
+  // element types for cb_arr2d_typed, as in the parameter configuration
+  static constexpr int elemtype(const unsigned char*) { return 0x01; }
+  static constexpr int elemtype(const unsigned short*) { return 0x02; }
+  static constexpr int elemtype(const unsigned int*) { return 0x03; }
+  static constexpr int elemtype(const int*) { return 0x13; }
   // define member function signatures for the T class
   typedef int (T::*write_int_member_fun_t) (int);
   typedef int (T::*write_float64_member_fun_t) (double);
@@ -52,6 +64,8 @@ class Glue
   typedef int (T::*read_int_member_fun_t) (int*);
   typedef int (T::*read_float64_member_fun_t) (double*);
   typedef int (T::*read_string_member_fun_t) (std::string&);
+  // 1d arrays: the registered function converts the byte length and pointer
+  typedef int (*write_arr1d_fun_t) (T*, size_t arr_len_in_bytes, const void*);
   std::unordered_map<size_t, write_int_member_fun_t> write_int_funs;
   std::unordered_map<size_t, write_int_member_fun_t> write_enum_funs;
   std::unordered_map<size_t, write_float64_member_fun_t> write_float64_funs;
@@ -60,6 +74,7 @@ class Glue
   std::unordered_map<size_t, read_int_member_fun_t> read_enum_funs;
   std::unordered_map<size_t, read_float64_member_fun_t> read_float64_funs;
   std::unordered_map<size_t, read_string_member_fun_t> read_string_funs;
+  std::unordered_map<size_t, write_arr1d_fun_t> write_arr1d_funs;
 
 public:
   Glue(T* parent) : parent_(parent) {
@@ -102,6 +117,13 @@ code2 = \
       return GLUE_ERR_OUT_OF_RANGE;
     }
   }
+  int write_arr1d(size_t pidx, size_t arr_len_in_bytes, const void* data) {
+    try {
+      return write_arr1d_funs.at(pidx)(parent_, arr_len_in_bytes, data);
+    } catch (const std::out_of_range&) {
+      return GLUE_ERR_OUT_OF_RANGE;
+    }
+  }
   int read_int(size_t pidx, int* dest) {
     try {
       return std::invoke(read_int_funs.at(pidx), parent_, dest);
@@ -146,6 +168,8 @@ code2 = \
   int set_callback_enum(void* priv, cb_enum_t cb) { cb_enum.set(priv, cb); return 0; }
   int set_callback_arr1d(void* priv, cb_arr1d_t cb) { cb_arr1d.set(priv, cb); return 0; }
   int set_callback_arr2d(void* priv, cb_arr2d_t cb) { cb_arr2d.set(priv, cb); return 0; }
+  int set_callback_arr3d(void* priv, cb_arr3d_t cb) { cb_arr3d.set(priv, cb); return 0; }
+  int set_callback_arr2d_typed(void* priv, cb_arr2d_typed_t cb) { cb_arr2d_typed.set(priv, cb); return 0; }
 """
 
 code3 = \
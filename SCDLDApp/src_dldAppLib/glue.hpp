@@ -24,6 +24,11 @@ class Glue
   typedef void (*cb_arr1d_t)(void*, size_t, size_t arr_len_in_bytes, void* data);
   typedef void (*cb_arr2d_t)(void*, size_t, size_t arr_len_in_bytes,
                                     size_t width, void* data);
+  typedef void (*cb_arr3d_t)(void*, size_t, size_t arr_len_in_bytes,
+                                    size_t width, size_t height, void* data);
+  typedef void (*cb_arr2d_typed_t)(void*, size_t, int elemtype,
+                                   size_t arr_len_in_bytes, size_t width,
+                                   void* data);
   template <typename CBType>
   struct RegCallback
   {
@@ -39,6 +44,13 @@ class Glue
   RegCallback<cb_enum_t> cb_enum;
   RegCallback<cb_arr1d_t> cb_arr1d;
   RegCallback<cb_arr2d_t> cb_arr2d;
+  RegCallback<cb_arr3d_t> cb_arr3d;
+  RegCallback<cb_arr2d_typed_t> cb_arr2d_typed;
+  // element types for cb_arr2d_typed, as in the parameter configuration
+  static constexpr int elemtype(const unsigned char*) { return 0x01; }
+  static constexpr int elemtype(const unsigned short*) { return 0x02; }
+  static constexpr int elemtype(const unsigned int*) { return 0x03; }
+  static constexpr int elemtype(const int*) { return 0x13; }
   // define member function signatures for the T class
   typedef int (T::*write_int_member_fun_t) (int);
   typedef int (T::*write_float64_member_fun_t) (double);
@@ -46,6 +58,8 @@ class Glue
   typedef int (T::*read_int_member_fun_t) (int*);
   typedef int (T::*read_float64_member_fun_t) (double*);
   typedef int (T::*read_string_member_fun_t) (std::string&);
+  // 1d arrays: the registered function converts the byte length and pointer
+  typedef int (*write_arr1d_fun_t) (T*, size_t arr_len_in_bytes, const void*);
   std::unordered_map<size_t, write_int_member_fun_t> write_int_funs;
   std::unordered_map<size_t, write_int_member_fun_t> write_enum_funs;
   std::unordered_map<size_t, write_float64_member_fun_t> write_float64_funs;
@@ -54,6 +68,7 @@ class Glue
   std::unordered_map<size_t, read_int_member_fun_t> read_enum_funs;
   std::unordered_map<size_t, read_float64_member_fun_t> read_float64_funs;
   std::unordered_map<size_t, read_string_member_fun_t> read_string_funs;
+  std::unordered_map<size_t, write_arr1d_fun_t> write_arr1d_funs;
 
 public:
   Glue(T* parent) : parent_(parent) {
@@ -79,36 +94,90 @@ public:
     write_int_funs.insert({8, &T::write_NumImages});
     read_int_funs.insert({8, &T::read_NumImages});
     read_int_funs.insert({9, &T::read_NumImagesCounter});
-    write_int_funs.insert({10, &T::write_BinX});
-    read_int_funs.insert({10, &T::read_BinX});
-    write_int_funs.insert({11, &T::write_BinY});
-    read_int_funs.insert({11, &T::read_BinY});
-    write_int_funs.insert({12, &T::write_MinX});
-    read_int_funs.insert({12, &T::read_MinX});
-    write_int_funs.insert({13, &T::write_MinY});
-    read_int_funs.insert({13, &T::read_MinY});
-    write_int_funs.insert({14, &T::write_SizeX});
-    read_int_funs.insert({14, &T::read_SizeX});
-    write_int_funs.insert({15, &T::write_SizeY});
-    read_int_funs.insert({15, &T::read_SizeY});
-    write_int_funs.insert({16, &T::write_SizeT});
-    read_int_funs.insert({16, &T::read_SizeT});
-    write_float64_funs.insert({17, &T::write_MinTSI});
-    read_float64_funs.insert({17, &T::read_MinTSI});
-    write_float64_funs.insert({18, &T::write_SizeTSI});
-    read_float64_funs.insert({18, &T::read_SizeTSI});
-    read_int_funs.insert({20, &T::read_RatemeterMax});
-    write_enum_funs.insert({22, &T::write_LiveImageXYAccum});
-    read_enum_funs.insert({22, &T::read_LiveImageXYAccum});
-    write_enum_funs.insert({25, &T::write_TimeHistoAccum});
-    read_enum_funs.insert({25, &T::read_TimeHistoAccum});
-    write_string_funs.insert({26, &T::write_H5EventsFilePath});
-    read_string_funs.insert({26, &T::read_H5EventsFilePath});
-    write_string_funs.insert({27, &T::write_H5EventsComment});
-    read_string_funs.insert({27, &T::read_H5EventsComment});
-    write_enum_funs.insert({28, &T::write_H5EventsActive});
-    read_enum_funs.insert({28, &T::read_H5EventsActive});
-    read_int_funs.insert({29, &T::read_H5EventsFileError});
+    write_enum_funs.insert({10, &T::write_GaplessFrames});
+    read_enum_funs.insert({10, &T::read_GaplessFrames});
+    write_int_funs.insert({11, &T::write_HistoThreads});
+    read_int_funs.insert({11, &T::read_HistoThreads});
+    write_int_funs.insert({12, &T::write_BinX});
+    read_int_funs.insert({12, &T::read_BinX});
+    write_int_funs.insert({13, &T::write_BinY});
+    read_int_funs.insert({13, &T::read_BinY});
+    write_int_funs.insert({14, &T::write_MinX});
+    read_int_funs.insert({14, &T::read_MinX});
+    write_int_funs.insert({15, &T::write_MinY});
+    read_int_funs.insert({15, &T::read_MinY});
+    write_int_funs.insert({16, &T::write_SizeX});
+    read_int_funs.insert({16, &T::read_SizeX});
+    write_int_funs.insert({17, &T::write_SizeY});
+    read_int_funs.insert({17, &T::read_SizeY});
+    write_int_funs.insert({18, &T::write_SizeT});
+    read_int_funs.insert({18, &T::read_SizeT});
+    write_float64_funs.insert({19, &T::write_MinTSI});
+    read_float64_funs.insert({19, &T::read_MinTSI});
+    write_float64_funs.insert({20, &T::write_SizeTSI});
+    read_float64_funs.insert({20, &T::read_SizeTSI});
+    read_int_funs.insert({22, &T::read_RatemeterMax});
+    write_enum_funs.insert({24, &T::write_LiveImageXYAccum});
+    read_enum_funs.insert({24, &T::read_LiveImageXYAccum});
+    write_int_funs.insert({25, &T::write_LiveImageXYWindow});
+    read_int_funs.insert({25, &T::read_LiveImageXYWindow});
+    write_enum_funs.insert({26, &T::write_LiveImageXYAccumDepth});
+    read_enum_funs.insert({26, &T::read_LiveImageXYAccumDepth});
+    write_enum_funs.insert({27, &T::write_LiveImageXYPixelType});
+    read_enum_funs.insert({27, &T::read_LiveImageXYPixelType});
+    write_enum_funs.insert({30, &T::write_TimeHistoAccum});
+    read_enum_funs.insert({30, &T::read_TimeHistoAccum});
+    write_int_funs.insert({31, &T::write_TimeHistoWindow});
+    read_int_funs.insert({31, &T::read_TimeHistoWindow});
+    write_enum_funs.insert({32, &T::write_TimeHistoAccumDepth});
+    read_enum_funs.insert({32, &T::read_TimeHistoAccumDepth});
+    write_arr1d_funs.insert({33, [](T* t, size_t n, const void* d) {
+      return t->write_GatedImagesTSI(n / sizeof(double), static_cast<const double*>(d)); }});
+    write_arr1d_funs.insert({35, [](T* t, size_t n, const void* d) {
+      return t->write_GatedHistosXY(n / sizeof(int), static_cast<const int*>(d)); }});
+    write_enum_funs.insert({37, &T::write_XYTCube});
+    read_enum_funs.insert({37, &T::read_XYTCube});
+    write_int_funs.insert({38, &T::write_XYTBinX});
+    read_int_funs.insert({38, &T::read_XYTBinX});
+    write_int_funs.insert({39, &T::write_XYTBinY});
+    read_int_funs.insert({39, &T::read_XYTBinY});
+    write_int_funs.insert({40, &T::write_XYTSizeT});
+    read_int_funs.insert({40, &T::read_XYTSizeT});
+    write_int_funs.insert({41, &T::write_XYTMaxMiB});
+    read_int_funs.insert({41, &T::read_XYTMaxMiB});
+    read_float64_funs.insert({42, &T::read_XYTSliceNs});
+    write_string_funs.insert({44, &T::write_H5EventsFilePath});
+    read_string_funs.insert({44, &T::read_H5EventsFilePath});
+    write_string_funs.insert({45, &T::write_H5EventsComment});
+    read_string_funs.insert({45, &T::read_H5EventsComment});
+    write_enum_funs.insert({46, &T::write_H5EventsActive});
+    read_enum_funs.insert({46, &T::read_H5EventsActive});
+    read_int_funs.insert({47, &T::read_H5EventsFileError});
+    write_int_funs.insert({48, &T::write_H5EventsPageSize});
+    read_int_funs.insert({48, &T::read_H5EventsPageSize});
+    write_int_funs.insert({49, &T::write_H5EventsChunkSize});
+    read_int_funs.insert({49, &T::read_H5EventsChunkSize});
+    write_int_funs.insert({50, &T::write_H5EventsChunkCache});
+    read_int_funs.insert({50, &T::read_H5EventsChunkCache});
+    write_enum_funs.insert({51, &T::write_H5EventsCompression});
+    read_enum_funs.insert({51, &T::read_H5EventsCompression});
+    write_int_funs.insert({52, &T::write_H5EventsPackLevel});
+    read_int_funs.insert({52, &T::read_H5EventsPackLevel});
+    write_enum_funs.insert({53, &T::write_H5EventsRawCapture});
+    read_enum_funs.insert({53, &T::read_H5EventsRawCapture});
+    write_int_funs.insert({54, &T::write_H5EventsRotateMiB});
+    read_int_funs.insert({54, &T::read_H5EventsRotateMiB});
+    write_int_funs.insert({55, &T::write_H5EventsRotateSeconds});
+    read_int_funs.insert({55, &T::read_H5EventsRotateSeconds});
+    write_enum_funs.insert({56, &T::write_H5EventsVDSMaster});
+    read_enum_funs.insert({56, &T::read_H5EventsVDSMaster});
+    read_float64_funs.insert({57, &T::read_H5EventsReceived});
+    read_float64_funs.insert({58, &T::read_H5EventsWritten});
+    read_float64_funs.insert({59, &T::read_H5EventsDropped});
+    read_float64_funs.insert({60, &T::read_H5EventsWriteRate});
+    read_int_funs.insert({61, &T::read_H5EventsRingFill});
+    read_float64_funs.insert({62, &T::read_H5EventsPushTime});
+    read_float64_funs.insert({63, &T::read_H5EventsMaxAppend});
   }
 
   int write_int(size_t pidx, int value) {
@@ -139,6 +208,13 @@ public:
       return GLUE_ERR_OUT_OF_RANGE;
     }
   }
+  int write_arr1d(size_t pidx, size_t arr_len_in_bytes, const void* data) {
+    try {
+      return write_arr1d_funs.at(pidx)(parent_, arr_len_in_bytes, data);
+    } catch (const std::out_of_range&) {
+      return GLUE_ERR_OUT_OF_RANGE;
+    }
+  }
   int read_int(size_t pidx, int* dest) {
     try {
       return std::invoke(read_int_funs.at(pidx), parent_, dest);
@@ -183,6 +259,8 @@ public:
   int set_callback_enum(void* priv, cb_enum_t cb) { cb_enum.set(priv, cb); return 0; }
   int set_callback_arr1d(void* priv, cb_arr1d_t cb) { cb_arr1d.set(priv, cb); return 0; }
   int set_callback_arr2d(void* priv, cb_arr2d_t cb) { cb_arr2d.set(priv, cb); return 0; }
+  int set_callback_arr3d(void* priv, cb_arr3d_t cb) { cb_arr3d.set(priv, cb); return 0; }
+  int set_callback_arr2d_typed(void* priv, cb_arr2d_typed_t cb) { cb_arr2d_typed.set(priv, cb); return 0; }
   void update_Initialize(int v) { cb_enum.cb(cb_enum.priv, 0, v); }
   void update_ConfigFile(const std::string& v) { cb_string.cb(cb_string.priv, 1, v.c_str()); }
   void update_StatusMessage(const std::string& v) { cb_string.cb(cb_string.priv, 2, v.c_str()); }
@@ -193,29 +271,74 @@ public:
   void update_ImageMode(int v) { cb_enum.cb(cb_enum.priv, 7, v); }
   void update_NumImages(int v) { cb_int32.cb(cb_int32.priv, 8, v); }
   void update_NumImagesCounter(int v) { cb_int32.cb(cb_int32.priv, 9, v); }
-  void update_BinX(int v) { cb_int32.cb(cb_int32.priv, 10, v); }
-  void update_BinY(int v) { cb_int32.cb(cb_int32.priv, 11, v); }
-  void update_MinX(int v) { cb_int32.cb(cb_int32.priv, 12, v); }
-  void update_MinY(int v) { cb_int32.cb(cb_int32.priv, 13, v); }
-  void update_SizeX(int v) { cb_int32.cb(cb_int32.priv, 14, v); }
-  void update_SizeY(int v) { cb_int32.cb(cb_int32.priv, 15, v); }
-  void update_SizeT(int v) { cb_int32.cb(cb_int32.priv, 16, v); }
-  void update_MinTSI(double v) { cb_float64.cb(cb_float64.priv, 17, v); }
-  void update_SizeTSI(double v) { cb_float64.cb(cb_float64.priv, 18, v); }
+  void update_GaplessFrames(int v) { cb_enum.cb(cb_enum.priv, 10, v); }
+  void update_HistoThreads(int v) { cb_int32.cb(cb_int32.priv, 11, v); }
+  void update_BinX(int v) { cb_int32.cb(cb_int32.priv, 12, v); }
+  void update_BinY(int v) { cb_int32.cb(cb_int32.priv, 13, v); }
+  void update_MinX(int v) { cb_int32.cb(cb_int32.priv, 14, v); }
+  void update_MinY(int v) { cb_int32.cb(cb_int32.priv, 15, v); }
+  void update_SizeX(int v) { cb_int32.cb(cb_int32.priv, 16, v); }
+  void update_SizeY(int v) { cb_int32.cb(cb_int32.priv, 17, v); }
+  void update_SizeT(int v) { cb_int32.cb(cb_int32.priv, 18, v); }
+  void update_MinTSI(double v) { cb_float64.cb(cb_float64.priv, 19, v); }
+  void update_SizeTSI(double v) { cb_float64.cb(cb_float64.priv, 20, v); }
   void update_Ratemeter(size_t nr_elem, int* data) { 
-    cb_arr1d.cb(cb_arr1d.priv, 19, nr_elem*sizeof(int), data); }
-  void update_RatemeterMax(int v) { cb_int32.cb(cb_int32.priv, 20, v); }
+    cb_arr1d.cb(cb_arr1d.priv, 21, nr_elem*sizeof(int), data); }
+  void update_RatemeterMax(int v) { cb_int32.cb(cb_int32.priv, 22, v); }
   void update_LiveImageXY(size_t nr_elem, size_t width, int* data) {
-    cb_arr2d.cb(cb_arr2d.priv, 21, nr_elem*sizeof(int), width, data); }
-  void update_LiveImageXYAccum(int v) { cb_enum.cb(cb_enum.priv, 22, v); }
+    cb_arr2d.cb(cb_arr2d.priv, 23, nr_elem*sizeof(int), width, data); }
+  template <typename E>
+  void update_LiveImageXY(size_t nr_elem, size_t width, E* data) {
+    if (cb_arr2d_typed.cb) cb_arr2d_typed.cb(cb_arr2d_typed.priv, 23, elemtype(data), nr_elem*sizeof(E), width, data); }
+  void update_LiveImageXYAccum(int v) { cb_enum.cb(cb_enum.priv, 24, v); }
+  void update_LiveImageXYWindow(int v) { cb_int32.cb(cb_int32.priv, 25, v); }
+  void update_LiveImageXYAccumDepth(int v) { cb_enum.cb(cb_enum.priv, 26, v); }
+  void update_LiveImageXYPixelType(int v) { cb_enum.cb(cb_enum.priv, 27, v); }
   void update_TimeHistoDataX(size_t nr_elem, double* data) { 
-    cb_arr1d.cb(cb_arr1d.priv, 23, nr_elem*sizeof(double), data); }
+    cb_arr1d.cb(cb_arr1d.priv, 28, nr_elem*sizeof(double), data); }
   void update_TimeHistoDataY(size_t nr_elem, double* data) { 
-    cb_arr1d.cb(cb_arr1d.priv, 24, nr_elem*sizeof(double), data); }
-  void update_TimeHistoAccum(int v) { cb_enum.cb(cb_enum.priv, 25, v); }
-  void update_H5EventsFilePath(const std::string& v) { cb_string.cb(cb_string.priv, 26, v.c_str()); }
-  void update_H5EventsComment(const std::string& v) { cb_string.cb(cb_string.priv, 27, v.c_str()); }
-  void update_H5EventsActive(int v) { cb_enum.cb(cb_enum.priv, 28, v); }
-  void update_H5EventsFileError(int v) { cb_int32.cb(cb_int32.priv, 29, v); }
+    cb_arr1d.cb(cb_arr1d.priv, 29, nr_elem*sizeof(double), data); }
+  void update_TimeHistoAccum(int v) { cb_enum.cb(cb_enum.priv, 30, v); }
+  void update_TimeHistoWindow(int v) { cb_int32.cb(cb_int32.priv, 31, v); }
+  void update_TimeHistoAccumDepth(int v) { cb_enum.cb(cb_enum.priv, 32, v); }
+  void update_GatedImagesTSI(size_t nr_elem, double* data) { 
+    cb_arr1d.cb(cb_arr1d.priv, 33, nr_elem*sizeof(double), data); }
+  void update_GatedImagesXY(size_t nr_elem, size_t width, int* data) {
+    cb_arr2d.cb(cb_arr2d.priv, 34, nr_elem*sizeof(int), width, data); }
+  template <typename E>
+  void update_GatedImagesXY(size_t nr_elem, size_t width, E* data) {
+    if (cb_arr2d_typed.cb) cb_arr2d_typed.cb(cb_arr2d_typed.priv, 34, elemtype(data), nr_elem*sizeof(E), width, data); }
+  void update_GatedHistosXY(size_t nr_elem, int* data) { 
+    cb_arr1d.cb(cb_arr1d.priv, 35, nr_elem*sizeof(int), data); }
+  void update_GatedTimeHistos(size_t nr_elem, double* data) { 
+    cb_arr1d.cb(cb_arr1d.priv, 36, nr_elem*sizeof(double), data); }
+  void update_XYTCube(int v) { cb_enum.cb(cb_enum.priv, 37, v); }
+  void update_XYTBinX(int v) { cb_int32.cb(cb_int32.priv, 38, v); }
+  void update_XYTBinY(int v) { cb_int32.cb(cb_int32.priv, 39, v); }
+  void update_XYTSizeT(int v) { cb_int32.cb(cb_int32.priv, 40, v); }
+  void update_XYTMaxMiB(int v) { cb_int32.cb(cb_int32.priv, 41, v); }
+  void update_XYTSliceNs(double v) { cb_float64.cb(cb_float64.priv, 42, v); }
+  void update_XYTCubeData(size_t nr_elem, size_t width, size_t height, int* data) {
+    if (cb_arr3d.cb) cb_arr3d.cb(cb_arr3d.priv, 43, nr_elem*sizeof(int), width, height, data); }
+  void update_H5EventsFilePath(const std::string& v) { cb_string.cb(cb_string.priv, 44, v.c_str()); }
+  void update_H5EventsComment(const std::string& v) { cb_string.cb(cb_string.priv, 45, v.c_str()); }
+  void update_H5EventsActive(int v) { cb_enum.cb(cb_enum.priv, 46, v); }
+  void update_H5EventsFileError(int v) { cb_int32.cb(cb_int32.priv, 47, v); }
+  void update_H5EventsPageSize(int v) { cb_int32.cb(cb_int32.priv, 48, v); }
+  void update_H5EventsChunkSize(int v) { cb_int32.cb(cb_int32.priv, 49, v); }
+  void update_H5EventsChunkCache(int v) { cb_int32.cb(cb_int32.priv, 50, v); }
+  void update_H5EventsCompression(int v) { cb_enum.cb(cb_enum.priv, 51, v); }
+  void update_H5EventsPackLevel(int v) { cb_int32.cb(cb_int32.priv, 52, v); }
+  void update_H5EventsRawCapture(int v) { cb_enum.cb(cb_enum.priv, 53, v); }
+  void update_H5EventsRotateMiB(int v) { cb_int32.cb(cb_int32.priv, 54, v); }
+  void update_H5EventsRotateSeconds(int v) { cb_int32.cb(cb_int32.priv, 55, v); }
+  void update_H5EventsVDSMaster(int v) { cb_enum.cb(cb_enum.priv, 56, v); }
+  void update_H5EventsReceived(double v) { cb_float64.cb(cb_float64.priv, 57, v); }
+  void update_H5EventsWritten(double v) { cb_float64.cb(cb_float64.priv, 58, v); }
+  void update_H5EventsDropped(double v) { cb_float64.cb(cb_float64.priv, 59, v); }
+  void update_H5EventsWriteRate(double v) { cb_float64.cb(cb_float64.priv, 60, v); }
+  void update_H5EventsRingFill(int v) { cb_int32.cb(cb_int32.priv, 61, v); }
+  void update_H5EventsPushTime(double v) { cb_float64.cb(cb_float64.priv, 62, v); }
+  void update_H5EventsMaxAppend(double v) { cb_float64.cb(cb_float64.priv, 63, v); }
 
 };
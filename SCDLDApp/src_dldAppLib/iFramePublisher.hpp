@@ -0,0 +1,11 @@
+#pragma once
+
+/* Copyright 2022 Surface Concept GmbH */
+
+class iFramePublisher {
+public:
+  // send out the data of the last measurement (after end_of_measurement),
+  // possibly while the next measurement is already running
+  virtual void publish_frame() = 0;
+  virtual ~iFramePublisher() {}
+};
@@ -0,0 +1,85 @@
+/*
+ * Copyright (C) 2020 Surface Concept GmbH
+*/
+#include "ChunkCompressor.hpp"
+#include "HDF5PreFilters.hpp"
+#include "HDF5Codecs.hpp"
+
+ChunkCompressor::ChunkCompressor(unsigned nr_threads, unsigned codec,
+                                 int level)
+  : codec_(codec), level_(level)
+{
+  if (nr_threads == 0) {
+    unsigned hw = std::thread::hardware_concurrency();
+    nr_threads = (hw > 3) ? hw - 2 : 1;
+  }
+  for (unsigned i = 0; i < nr_threads; i++)
+    threads_.emplace_back(&ChunkCompressor::worker_, this);
+}
+
+ChunkCompressor::~ChunkCompressor()
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    quit_ = true;
+  }
+  cv_work_.notify_all();
+  for (auto& t : threads_)
+    t.join();
+}
+
+void ChunkCompressor::submit(Job* j)
+{
+  j->done = false;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    queue_.push_back(j);
+  }
+  cv_work_.notify_one();
+}
+
+void ChunkCompressor::wait(Job* j)
+{
+  std::unique_lock<std::mutex> lock(mutex_);
+  cv_done_.wait(lock, [j]() { return j->done; });
+}
+
+void ChunkCompressor::worker_()
+{
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (true) {
+    cv_work_.wait(lock, [this]() { return quit_ || !queue_.empty(); });
+    if (queue_.empty()) // quit_ is set and no more work
+      return;
+    Job* j = queue_.front();
+    queue_.pop_front();
+    lock.unlock();
+    compress_(*j);
+    lock.lock();
+    j->done = true;
+    cv_done_.notify_all();
+  }
+}
+
+void ChunkCompressor::compress_(Job& j) const
+{
+  const void* p = j.src;
+  if (j.prefilters & PreFilter::DELTA) {
+    j.scratch[0].resize(j.nbytes);
+    DeltaZigzagEncode(p, j.scratch[0].data(), j.nbytes, j.elsize);
+    p = j.scratch[0].data();
+  }
+  if (j.prefilters & PreFilter::SHUFFLE) {
+    j.scratch[1].resize(j.nbytes);
+    ByteShuffle(p, j.scratch[1].data(), j.nbytes, j.elsize);
+    p = j.scratch[1].data();
+  }
+  std::size_t bound = CodecCompressBound(codec_, j.nbytes);
+  if (j.out.size() < bound)
+    j.out.resize(bound);
+  std::size_t destlen = CodecCompress(codec_, level_, p, j.nbytes,
+                                      j.out.data());
+  j.compressed = (destlen > 0 && destlen < j.nbytes);
+  j.stored = j.compressed ? j.out.data() : p;
+  j.outlen = j.compressed ? destlen : j.nbytes;
+}
@@ -0,0 +1,71 @@
+#ifndef CHUNKCOMPRESSOR_HPP
+#define CHUNKCOMPRESSOR_HPP
+
+/*
+ * Copyright (C) 2020 Surface Concept GmbH
+*/
+
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+/**
+ * @brief The ChunkCompressor class is a pool of worker threads that compress
+ * HDF5 chunks (deflate, LZ4 or Zstd, see HDF5Codecs.hpp), such that the HDF5
+ * writer thread only has to commit the compressed chunks by direct chunk
+ * writes. The output is identical in format to what the HDF5 filter pipeline
+ * (delta, shuffle, codec) produces, so the files can be read by any HDF5 reader (that has the
+ * delta filter plugin, if the delta pre-filter is used).
+ * The submitting thread owns the Job objects. A job must not be modified or
+ * destroyed between submit() and the return of wait().
+ */
+class ChunkCompressor
+{
+public:
+  struct Job {
+    const void* src = nullptr;      // uncompressed chunk
+    std::size_t nbytes = 0;         // size of the uncompressed chunk
+    std::size_t elsize = 1;         // element size in bytes
+    unsigned prefilters = 0;        // PreFilter::DELTA and / or SHUFFLE
+    std::vector<unsigned char> out; // compressed chunk (reused across jobs)
+    std::vector<unsigned char> scratch[2]; // for the pre-filters
+    const void* stored = nullptr;   // the data to be written to the file
+    std::size_t outlen = 0;         // valid bytes in stored
+    bool compressed = false; // false: compression failed or did not reduce
+                             // the size, stored points to the pre-filtered
+                             // chunk (the codec is to be skipped)
+    bool done = false;
+  };
+
+  /**
+   * @param nr_threads number of worker threads, 0 selects the number of
+   * hardware threads minus two (for the producer and the writer thread)
+   * @param codec one of the CompressionCodec values except NONE
+   * @param level compression level of the codec (see ClampCodecLevel)
+   */
+  ChunkCompressor(unsigned nr_threads, unsigned codec, int level);
+  ~ChunkCompressor();
+
+  ChunkCompressor(const ChunkCompressor&) = delete;
+  ChunkCompressor& operator=(const ChunkCompressor&) = delete;
+
+  void submit(Job* j);
+  void wait(Job* j); // blocks until the job is done
+
+private:
+  void worker_();
+  void compress_(Job& j) const;
+
+  unsigned codec_;
+  int level_;
+  std::mutex mutex_;
+  std::condition_variable cv_work_;
+  std::condition_variable cv_done_;
+  std::deque<Job*> queue_;
+  bool quit_ = false;
+  std::vector<std::thread> threads_;
+};
+
+#endif // CHUNKCOMPRESSOR_HPP
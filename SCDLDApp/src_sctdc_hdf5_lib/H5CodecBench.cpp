@@ -0,0 +1,166 @@
+/*
+ * Copyright (C) 2020 Surface Concept GmbH
+*/
+
+// Throughput benchmark of the compression codecs for the HDF5 event streaming
+// on synthetic sc_DldEvent streams. The events are split into columns by the
+// same kernel as in HDF5EventBuf, then compressed chunk-wise on one thread,
+// with and without pre-filters (delta on the time columns, shuffle on all).
+//
+// usage: sctdc_h5codec_bench [nr_events [chunk_events [rate]]]
+//   nr_events     number of synthetic events (default 10000000)
+//   chunk_events  events per chunk (default 65536)
+//   rate          mean event rate in events/s (default 1e7), determines the
+//                 time tag increments
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include <chrono>
+#include <random>
+#include "HDF5EventTranspose.hpp"
+#include "HDF5PreFilters.hpp"
+#include "HDF5Codecs.hpp"
+
+namespace {
+
+struct Column {
+  std::size_t elsize;
+  bool monotonic; // candidates for the delta pre-filter
+  std::vector<unsigned char> data;
+};
+
+// same order as the HDF5EventBuf buffer ids (StartCtr, TimeTag, Subdevice,
+// Channel, t, x, y, MasterResetCtr, ADC, SignalBit)
+Column columns[] = {
+  {8, true, {}}, {8, true, {}}, {4, false, {}}, {4, false, {}},
+  {8, false, {}}, {2, false, {}}, {2, false, {}}, {4, false, {}},
+  {2, false, {}}, {2, false, {}}
+};
+const unsigned NR_COLUMNS = sizeof(columns) / sizeof(columns[0]);
+
+void make_events(std::vector<sc_DldEvent>& ev, double rate)
+{
+  std::mt19937_64 rng(12345);
+  // time tag in units of 1 ns, start counter period 100 us (10 kHz start)
+  std::exponential_distribution<double> dt(rate * 1e-9);
+  std::normal_distribution<double> pos(2048.0, 500.0);
+  std::uniform_int_distribution<unsigned> tof(0, 99999); // ps within start
+  std::uniform_int_distribution<unsigned> adc(0, 4095);
+  double t = 0.0;
+  for (std::size_t i = 0; i < ev.size(); i++) {
+    sc_DldEvent& e = ev[i];
+    memset(&e, 0, sizeof(e));
+    t += dt(rng);
+    e.time_tag = static_cast<unsigned long long>(t);
+    e.start_counter = e.time_tag / 100000;
+    e.sum = tof(rng) * 1000ull;
+    double x = pos(rng);
+    double y = pos(rng);
+    e.dif1 = static_cast<unsigned short>(x < 0 ? 0 : (x > 4095 ? 4095 : x));
+    e.dif2 = static_cast<unsigned short>(y < 0 ? 0 : (y > 4095 ? 4095 : y));
+    e.adc = static_cast<unsigned short>(adc(rng));
+  }
+}
+
+struct Result {
+  double seconds = 0.0;
+  std::size_t in_bytes = 0;
+  std::size_t out_bytes = 0;
+};
+
+Result run(unsigned codec, int level, bool prefilters, std::size_t nevents,
+           std::size_t chunk)
+{
+  Result r;
+  std::vector<unsigned char> scratch[2];
+  std::vector<unsigned char> out;
+  auto t0 = std::chrono::steady_clock::now();
+  for (unsigned c = 0; c < NR_COLUMNS; c++) {
+    const Column& col = columns[c];
+    for (std::size_t first = 0; first < nevents; first += chunk) {
+      std::size_t n = (nevents - first < chunk) ? nevents - first : chunk;
+      std::size_t nbytes = n * col.elsize;
+      const void* p = col.data.data() + first * col.elsize;
+      if (prefilters) {
+        scratch[0].resize(nbytes);
+        scratch[1].resize(nbytes);
+        if (col.monotonic) {
+          DeltaZigzagEncode(p, scratch[0].data(), nbytes, col.elsize);
+          p = scratch[0].data();
+        }
+        ByteShuffle(p, scratch[1].data(), nbytes, col.elsize);
+        p = scratch[1].data();
+      }
+      std::size_t outlen = nbytes;
+      if (codec != CompressionCodec::NONE) {
+        out.resize(CodecCompressBound(codec, nbytes));
+        std::size_t l = CodecCompress(codec, level, p, nbytes, out.data());
+        if (l > 0 && l < nbytes)
+          outlen = l;
+      }
+      r.in_bytes += nbytes;
+      r.out_bytes += outlen;
+    }
+  }
+  auto t1 = std::chrono::steady_clock::now();
+  r.seconds = std::chrono::duration<double>(t1 - t0).count();
+  return r;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+  std::size_t nevents = (argc > 1) ? std::strtoull(argv[1], nullptr, 10)
+                                   : 10000000;
+  std::size_t chunk = (argc > 2) ? std::strtoull(argv[2], nullptr, 10)
+                                 : 65536;
+  double rate = (argc > 3) ? std::strtod(argv[3], nullptr) : 1e7;
+  if (nevents == 0 || chunk == 0 || rate <= 0.0) {
+    std::fprintf(stderr,
+      "usage: %s [nr_events [chunk_events [rate]]]\n", argv[0]);
+    return 1;
+  }
+
+  std::vector<sc_DldEvent> ev(nevents);
+  make_events(ev, rate);
+  void* dst[NR_COLUMNS];
+  for (unsigned c = 0; c < NR_COLUMNS; c++) {
+    columns[c].data.resize(nevents * columns[c].elsize);
+    dst[c] = columns[c].data.data();
+  }
+  SelectEventTransposeFn(EventDataFieldSelection::ALL_DLD)(
+    EventDataFieldSelection::ALL_DLD, ev.data(), nevents, dst);
+
+  struct Setting { const char* name; unsigned codec; int level; };
+  const Setting settings[] = {
+    {"none", CompressionCodec::NONE, 0},
+    {"lz4", CompressionCodec::LZ4, 0},
+    {"zstd-1", CompressionCodec::ZSTD, 1},
+    {"zstd-3", CompressionCodec::ZSTD, 3},
+    {"zstd-9", CompressionCodec::ZSTD, 9},
+    {"deflate-1", CompressionCodec::DEFLATE, 1},
+    {"deflate-6", CompressionCodec::DEFLATE, 6}
+  };
+  std::printf("%zu events, %zu events per chunk, rate %g events/s, "
+              "single thread\n", nevents, chunk, rate);
+  std::printf("%-10s %-10s %12s %12s %8s\n",
+              "codec", "prefilter", "MB/s", "Mevents/s", "ratio");
+  for (const Setting& s : settings) {
+    if (!CodecAvailable(s.codec)) {
+      std::printf("%-10s (not available in this build)\n", s.name);
+      continue;
+    }
+    // "none" only measures the cost of the pre-filters
+    for (int pf = (s.codec == CompressionCodec::NONE); pf < 2; pf++) {
+      Result r = run(s.codec, s.level, pf != 0, nevents, chunk);
+      std::printf("%-10s %-10s %12.1f %12.2f %8.2f\n", s.name,
+                  pf ? "delta+shuf" : "-",
+                  r.in_bytes / r.seconds * 1e-6, nevents / r.seconds * 1e-6,
+                  static_cast<double>(r.in_bytes) / r.out_bytes);
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,20 @@
+/*
+ * Copyright (C) 2020 Surface Concept GmbH
+*/
+
+// entry points of the sctdc_h5zdelta filter plugin library. Readers of HDF5
+// files with delta / zig-zag encoded datasets need this library in a directory
+// listed in the HDF5_PLUGIN_PATH environment variable.
+
+#include <H5PLextern.h>
+#include "HDF5PreFilters.hpp"
+
+H5PL_type_t H5PLget_plugin_type(void)
+{
+  return H5PL_TYPE_FILTER;
+}
+
+const void* H5PLget_plugin_info(void)
+{
+  return H5Z_SCTDC_DELTA;
+}
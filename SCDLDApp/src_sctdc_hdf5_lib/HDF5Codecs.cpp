@@ -0,0 +1,351 @@
+/*
+ * Copyright (C) 2020 Surface Concept GmbH
+*/
+#include "HDF5Codecs.hpp"
+#include <cstring>
+#include <zlib.h>
+#ifdef SCTDC_HDF5_WITH_LZ4
+#include <lz4.h>
+#endif
+#ifdef SCTDC_HDF5_WITH_ZSTD
+#include <zstd.h>
+#endif
+
+namespace {
+
+const int DEFAULT_DEFLATE_LEVEL = 6;
+const int DEFAULT_ZSTD_LEVEL = 3;
+const int MAX_ZSTD_LEVEL = 22;
+
+#ifdef SCTDC_HDF5_WITH_LZ4
+// chunk format of the LZ4 filter 32004: 8 bytes uncompressed size, 4 bytes
+// block size, then per block 4 bytes compressed block size followed by the
+// block data. A block whose compressed size equals the block size is stored
+// uncompressed. All integers are big-endian.
+const std::size_t LZ4_HEADER_SIZE = 12;
+const std::size_t LZ4_DEFAULT_BLOCK_SIZE = 1u << 30; // same as the plugin
+
+void put_be(unsigned char* p, unsigned long long v, unsigned nbytes)
+{
+  for (unsigned i = 0; i < nbytes; i++)
+    p[i] = static_cast<unsigned char>(v >> (8 * (nbytes - 1 - i)));
+}
+
+unsigned long long get_be(const unsigned char* p, unsigned nbytes)
+{
+  unsigned long long v = 0;
+  for (unsigned i = 0; i < nbytes; i++)
+    v = (v << 8) | p[i];
+  return v;
+}
+
+std::size_t lz4_block_size(std::size_t nbytes, std::size_t block_size)
+{
+  if (block_size == 0 || block_size > LZ4_DEFAULT_BLOCK_SIZE)
+    block_size = LZ4_DEFAULT_BLOCK_SIZE;
+  return (nbytes < block_size) ? nbytes : block_size;
+}
+
+std::size_t lz4_bound(std::size_t nbytes, std::size_t block_size)
+{
+  block_size = lz4_block_size(nbytes, block_size);
+  std::size_t nblocks = (block_size > 0) ? (nbytes - 1) / block_size + 1 : 0;
+  return LZ4_HEADER_SIZE + nblocks *
+    (4 + static_cast<std::size_t>(LZ4_compressBound(
+           static_cast<int>(block_size))));
+}
+
+std::size_t lz4_compress(const void* src, std::size_t nbytes, void* dst,
+                         std::size_t block_size)
+{
+  block_size = lz4_block_size(nbytes, block_size);
+  const char* r = static_cast<const char*>(src);
+  unsigned char* w = static_cast<unsigned char*>(dst);
+  put_be(w, nbytes, 8);
+  put_be(w + 8, block_size, 4);
+  std::size_t outlen = LZ4_HEADER_SIZE;
+  std::size_t done = 0;
+  while (done < nbytes) {
+    std::size_t bs = (nbytes - done < block_size) ? nbytes - done
+                                                  : block_size;
+    unsigned char* wb = w + outlen + 4;
+    int c = LZ4_compress_default(r + done, reinterpret_cast<char*>(wb),
+      static_cast<int>(bs), LZ4_compressBound(static_cast<int>(bs)));
+    if (c <= 0)
+      return 0;
+    std::size_t cs = static_cast<std::size_t>(c);
+    if (cs >= bs) { // incompressible block
+      memcpy(wb, r + done, bs);
+      cs = bs;
+    }
+    put_be(w + outlen, cs, 4);
+    outlen += 4 + cs;
+    done += bs;
+  }
+  return outlen;
+}
+
+std::size_t lz4_decompress(const void* src, std::size_t srclen, void* dst,
+                           std::size_t dstlen)
+{
+  const unsigned char* r = static_cast<const unsigned char*>(src);
+  const unsigned char* end = r + srclen;
+  std::size_t block_size = static_cast<std::size_t>(get_be(r + 8, 4));
+  if (block_size > dstlen)
+    block_size = dstlen;
+  r += LZ4_HEADER_SIZE;
+  char* w = static_cast<char*>(dst);
+  std::size_t done = 0;
+  while (done < dstlen) {
+    std::size_t bs = (dstlen - done < block_size) ? dstlen - done
+                                                  : block_size;
+    if (bs == 0 || r + 4 > end)
+      return 0;
+    std::size_t cs = static_cast<std::size_t>(get_be(r, 4));
+    r += 4;
+    if (r + cs > end)
+      return 0;
+    if (cs == bs)
+      memcpy(w + done, r, bs);
+    else if (LZ4_decompress_safe(reinterpret_cast<const char*>(r), w + done,
+               static_cast<int>(cs), static_cast<int>(bs))
+             != static_cast<int>(bs))
+      return 0;
+    r += cs;
+    done += bs;
+  }
+  return done;
+}
+
+size_t H5Z_filter_sctdc_lz4(unsigned flags, size_t cd_nelmts,
+  const unsigned cd_values[], size_t nbytes, size_t* buf_size, void** buf)
+{
+  void* out;
+  size_t outlen;
+  if (flags & H5Z_FLAG_REVERSE) {
+    if (nbytes < LZ4_HEADER_SIZE)
+      return 0;
+    outlen = static_cast<size_t>(
+      get_be(static_cast<const unsigned char*>(*buf), 8));
+    out = H5allocate_memory(outlen, false);
+    if (!out)
+      return 0;
+    if (lz4_decompress(*buf, nbytes, out, outlen) != outlen) {
+      H5free_memory(out);
+      return 0;
+    }
+  }
+  else {
+    std::size_t block_size = (cd_nelmts > 0) ? cd_values[0] : 0;
+    out = H5allocate_memory(lz4_bound(nbytes, block_size), false);
+    if (!out)
+      return 0;
+    outlen = lz4_compress(*buf, nbytes, out, block_size);
+    if (outlen == 0) {
+      H5free_memory(out);
+      return 0;
+    }
+  }
+  H5free_memory(*buf);
+  *buf = out;
+  *buf_size = outlen;
+  return outlen;
+}
+
+const H5Z_class2_t H5Z_SCTDC_LZ4[1] = {{
+  H5Z_CLASS_T_VERS,
+  static_cast<H5Z_filter_t>(SCTDC_H5Z_FILTER_LZ4),
+  1, // encoder present
+  1, // decoder present
+  "lz4 (sctdc)",
+  nullptr, // can_apply
+  nullptr, // set_local
+  H5Z_filter_sctdc_lz4
+}};
+#endif // SCTDC_HDF5_WITH_LZ4
+
+#ifdef SCTDC_HDF5_WITH_ZSTD
+// chunk format of the Zstd filter 32015: one Zstd frame (including the
+// content size), cd_values[0] is the compression level
+size_t H5Z_filter_sctdc_zstd(unsigned flags, size_t cd_nelmts,
+  const unsigned cd_values[], size_t nbytes, size_t* buf_size, void** buf)
+{
+  void* out;
+  size_t outlen;
+  if (flags & H5Z_FLAG_REVERSE) {
+    unsigned long long n = ZSTD_getFrameContentSize(*buf, nbytes);
+    if (n == ZSTD_CONTENTSIZE_UNKNOWN || n == ZSTD_CONTENTSIZE_ERROR)
+      return 0;
+    out = H5allocate_memory(static_cast<size_t>(n), false);
+    if (!out)
+      return 0;
+    outlen = ZSTD_decompress(out, static_cast<size_t>(n), *buf, nbytes);
+    if (ZSTD_isError(outlen)) {
+      H5free_memory(out);
+      return 0;
+    }
+  }
+  else {
+    int level = (cd_nelmts > 0) ? static_cast<int>(cd_values[0])
+                                : DEFAULT_ZSTD_LEVEL;
+    size_t bound = ZSTD_compressBound(nbytes);
+    out = H5allocate_memory(bound, false);
+    if (!out)
+      return 0;
+    outlen = ZSTD_compress(out, bound, *buf, nbytes, level);
+    if (ZSTD_isError(outlen)) {
+      H5free_memory(out);
+      return 0;
+    }
+  }
+  H5free_memory(*buf);
+  *buf = out;
+  *buf_size = outlen;
+  return outlen;
+}
+
+const H5Z_class2_t H5Z_SCTDC_ZSTD[1] = {{
+  H5Z_CLASS_T_VERS,
+  static_cast<H5Z_filter_t>(SCTDC_H5Z_FILTER_ZSTD),
+  1, // encoder present
+  1, // decoder present
+  "zstd (sctdc)",
+  nullptr, // can_apply
+  nullptr, // set_local
+  H5Z_filter_sctdc_zstd
+}};
+#endif // SCTDC_HDF5_WITH_ZSTD
+
+} // namespace
+
+
+bool CodecAvailable(unsigned codec)
+{
+  switch (codec) {
+  case CompressionCodec::NONE:
+  case CompressionCodec::DEFLATE:
+    return true;
+#ifdef SCTDC_HDF5_WITH_LZ4
+  case CompressionCodec::LZ4:
+    return true;
+#endif
+#ifdef SCTDC_HDF5_WITH_ZSTD
+  case CompressionCodec::ZSTD:
+    return true;
+#endif
+  default:
+    return false;
+  }
+}
+
+int ClampCodecLevel(unsigned codec, int level)
+{
+  switch (codec) {
+  case CompressionCodec::DEFLATE:
+    if (level <= 0)
+      return DEFAULT_DEFLATE_LEVEL;
+    return (level > 9) ? 9 : level;
+  case CompressionCodec::ZSTD:
+    if (level <= 0)
+      return DEFAULT_ZSTD_LEVEL;
+    return (level > MAX_ZSTD_LEVEL) ? MAX_ZSTD_LEVEL : level;
+  default:
+    return 0;
+  }
+}
+
+bool RegisterH5ZCodecFilter(unsigned codec)
+{
+  switch (codec) {
+  case CompressionCodec::NONE:
+  case CompressionCodec::DEFLATE:
+    return true;
+#ifdef SCTDC_HDF5_WITH_LZ4
+  case CompressionCodec::LZ4:
+    // prefer a filter plugin found in HDF5_PLUGIN_PATH
+    if (H5Zfilter_avail(SCTDC_H5Z_FILTER_LZ4) > 0)
+      return true;
+    return H5Zregister(H5Z_SCTDC_LZ4) >= 0;
+#endif
+#ifdef SCTDC_HDF5_WITH_ZSTD
+  case CompressionCodec::ZSTD:
+    if (H5Zfilter_avail(SCTDC_H5Z_FILTER_ZSTD) > 0)
+      return true;
+    return H5Zregister(H5Z_SCTDC_ZSTD) >= 0;
+#endif
+  default:
+    return false;
+  }
+}
+
+bool SetCodecFilter(hid_t dcpl, unsigned codec, int level)
+{
+  level = ClampCodecLevel(codec, level);
+  switch (codec) {
+  case CompressionCodec::NONE:
+    return true;
+  case CompressionCodec::DEFLATE:
+    return H5Pset_deflate(dcpl, static_cast<unsigned>(level)) >= 0;
+  case CompressionCodec::LZ4: {
+    if (!RegisterH5ZCodecFilter(codec))
+      return false;
+    const unsigned cd[1] = {0}; // default block size
+    return H5Pset_filter(dcpl, SCTDC_H5Z_FILTER_LZ4, H5Z_FLAG_OPTIONAL,
+                         1, cd) >= 0;
+  }
+  case CompressionCodec::ZSTD: {
+    if (!RegisterH5ZCodecFilter(codec))
+      return false;
+    const unsigned cd[1] = {static_cast<unsigned>(level)};
+    return H5Pset_filter(dcpl, SCTDC_H5Z_FILTER_ZSTD, H5Z_FLAG_OPTIONAL,
+                         1, cd) >= 0;
+  }
+  default:
+    return false;
+  }
+}
+
+std::size_t CodecCompressBound(unsigned codec, std::size_t nbytes)
+{
+  switch (codec) {
+  case CompressionCodec::DEFLATE:
+    return compressBound(static_cast<uLong>(nbytes));
+#ifdef SCTDC_HDF5_WITH_LZ4
+  case CompressionCodec::LZ4:
+    return lz4_bound(nbytes, 0);
+#endif
+#ifdef SCTDC_HDF5_WITH_ZSTD
+  case CompressionCodec::ZSTD:
+    return ZSTD_compressBound(nbytes);
+#endif
+  default:
+    return nbytes;
+  }
+}
+
+std::size_t CodecCompress(unsigned codec, int level, const void* src,
+                          std::size_t nbytes, void* dst)
+{
+  level = ClampCodecLevel(codec, level);
+  switch (codec) {
+  case CompressionCodec::DEFLATE: {
+    uLongf destlen = compressBound(static_cast<uLong>(nbytes));
+    int ret = compress2(static_cast<Bytef*>(dst), &destlen,
+      static_cast<const Bytef*>(src), static_cast<uLong>(nbytes), level);
+    return (ret == Z_OK) ? destlen : 0;
+  }
+#ifdef SCTDC_HDF5_WITH_LZ4
+  case CompressionCodec::LZ4:
+    return lz4_compress(src, nbytes, dst, 0);
+#endif
+#ifdef SCTDC_HDF5_WITH_ZSTD
+  case CompressionCodec::ZSTD: {
+    std::size_t r = ZSTD_compress(dst, ZSTD_compressBound(nbytes), src,
+                                  nbytes, level);
+    return ZSTD_isError(r) ? 0 : r;
+  }
+#endif
+  default:
+    return 0;
+  }
+}
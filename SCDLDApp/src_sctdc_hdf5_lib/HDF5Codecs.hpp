@@ -0,0 +1,67 @@
+#ifndef HDF5CODECS_HPP
+#define HDF5CODECS_HPP
+
+/*
+ * Copyright (C) 2020 Surface Concept GmbH
+*/
+
+// compression codecs for the event datasets: deflate (HDF5 built-in), LZ4 and
+// Zstandard. LZ4 and Zstd use the filter IDs registered with The HDF Group
+// and the same chunk format as the widely used filter plugins (e.g. those
+// shipped with the hdf5plugin Python package), so that any reader having
+// these plugins can decode the files. The library registers its own
+// implementation of the filters in-process, if no plugin is found.
+// LZ4 / Zstd support is compiled in if SCTDC_HDF5_WITH_LZ4 /
+// SCTDC_HDF5_WITH_ZSTD is defined (see configure/CONFIG_SCTDC).
+
+#include <cstddef>
+#include <hdf5.h>
+
+#define SCTDC_H5Z_FILTER_LZ4 32004
+#define SCTDC_H5Z_FILTER_ZSTD 32015
+
+/** compression codec values (same as enum sc_tdc_hdf5_codec) */
+struct CompressionCodec
+{
+  static const unsigned NONE = 0;
+  static const unsigned DEFLATE = 1; // zlib, levels 1..9
+  static const unsigned LZ4 = 2;     // level without effect
+  static const unsigned ZSTD = 3;    // levels 1..22
+};
+
+/** @return true if the codec is compiled into this library */
+bool CodecAvailable(unsigned codec);
+
+/**
+ * @brief ClampCodecLevel map the user-specified level into the valid range of
+ * the codec (0 selects the default level of the codec)
+ */
+int ClampCodecLevel(unsigned codec, int level);
+
+/**
+ * @brief RegisterH5ZCodecFilter make the HDF5 filter of the codec available
+ * to this process (once). Does nothing for NONE and DEFLATE.
+ * @return true on success
+ */
+bool RegisterH5ZCodecFilter(unsigned codec);
+
+/**
+ * @brief SetCodecFilter append the filter of the codec to the dataset creation
+ * property list
+ * @return true on success
+ */
+bool SetCodecFilter(hid_t dcpl, unsigned codec, int level);
+
+/** @return the size of the output buffer required by CodecCompress */
+std::size_t CodecCompressBound(unsigned codec, std::size_t nbytes);
+
+/**
+ * @brief CodecCompress compress one chunk into the format that the HDF5
+ * filter of the codec would produce
+ * @param dst output buffer of at least CodecCompressBound(codec, nbytes) bytes
+ * @return the compressed size, or 0 on failure
+ */
+std::size_t CodecCompress(unsigned codec, int level, const void* src,
+                          std::size_t nbytes, void* dst);
+
+#endif // HDF5CODECS_HPP
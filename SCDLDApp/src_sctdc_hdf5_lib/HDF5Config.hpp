@@ -35,6 +35,42 @@ struct HDF5Config {
   std::string user_comment;
   EventDataFieldSelection datasel;
   bool overwrite; // (without effect)
+  unsigned nr_bufpages; // number of pages in the event ring buffer
+  unsigned long long page_size; // number of events per buffer page
+  unsigned long long chunk_size; // number of events per HDF5 chunk, 0: auto
+  unsigned long long chunk_cache; // chunk cache bytes per dataset, 0: auto
+  unsigned codec; // CompressionCodec value (see HDF5Codecs.hpp), 0: none
+  unsigned pack_level; // compression level of the codec
+  unsigned compress_threads; // compression worker threads (0: auto)
+  double rate_hint; // expected event rate in events/s (for auto chunk size)
+  // data fields that get the respective pre-filter before compression
+  EventDataFieldSelection delta_sel;
+  EventDataFieldSelection shuffle_sel;
+  EventDataFieldSelection bitshuffle_sel;
+  // raw capture mode: the events are written unchanged to <base_path>.raw
+  // (see RawCaptureFile.hpp) instead of the HDF5 file
+  bool raw_capture;
+  unsigned long long raw_prealloc; // bytes reserved for the raw capture file
+  // file rotation (HDF5 mode only): the events are written to a series of
+  // files <stem>_NNNNN<ext>, a new file is started when one of the limits is
+  // reached (0: no limit; rotation is off if all limits are 0)
+  unsigned long long rotate_bytes; // file size
+  unsigned long long rotate_events; // number of events per file
+  double rotate_seconds; // wall time per file
+  bool vds_master; // write a master file with virtual datasets at base_path
+  unsigned long long marker_queue_size; // initial size of the marker queue
+  unsigned marker_overflow; // MarkerOverflow value (see MarkerRing.hpp)
+
+  HDF5Config()
+    : overwrite(false), nr_bufpages(8), page_size(1<<18), chunk_size(0),
+      chunk_cache(0), codec(0), pack_level(0), compress_threads(0),
+      rate_hint(0.0), raw_capture(false), raw_prealloc(1ull<<30),
+      rotate_bytes(0), rotate_events(0), rotate_seconds(0.0),
+      vds_master(false), marker_queue_size(1<<16), marker_overflow(0) {}
+
+  bool rotation() const {
+    return rotate_bytes > 0 || rotate_events > 0 || rotate_seconds > 0.0;
+  }
 };
 
 #endif
@@ -5,11 +5,14 @@
 #include "HDF5DataFile.hpp"
 
 #include <time.h>
+#include <utility>
 #include <H5Cpp.h>
 #include <H5DOpublic.h>
 #include <H5Exception.h>
 #include "HDF5Utilities.h"
 #include "HDF5Config.hpp"
+#include "HDF5PreFilters.hpp"
+#include "HDF5Codecs.hpp"
 
 class H5P_Owner { // raii wrapper for HDF5 property list resource
   hid_t p_id_;
@@ -30,11 +33,12 @@ HDF5DataFile::HDF5DataFile()
 void HDF5DataFile::open(const std::string& fpath)
 {
   close(); // close if we still have an open file
+  filter_error_ = false;
   // ----------------------------------------------------------------------
   {
     H5P_Owner fapl(H5Pcreate(H5P_FILE_ACCESS)); // create property list
     //H5Pset_libver_bounds(fapl.id(), H5F_LIBVER_LATEST, H5F_LIBVER_LATEST);
-    H5Pset_cache(fapl.id(), 0, 0, 0, 0);
+    // (the chunk cache is set per dataset, see addDataSetRaw)
     try {
       f_.reset(
         new H5::H5File(fpath.c_str(), H5F_ACC_TRUNC, H5P_DEFAULT, fapl.id()));
@@ -69,6 +73,38 @@ HDF5DataFile::~HDF5DataFile()
   close();
 }
 
+void HDF5DataFile::swap(HDF5DataFile& other)
+{
+  std::swap(chunk_elements_, other.chunk_elements_);
+  std::swap(chunk_cache_bytes_, other.chunk_cache_bytes_);
+  std::swap(codec_, other.codec_);
+  std::swap(level_, other.level_);
+  std::swap(filter_error_, other.filter_error_);
+  f_.swap(other.f_);
+  datasets_.swap(other.datasets_);
+  ds_sizes_.swap(other.ds_sizes_);
+}
+
+unsigned long long HDF5DataFile::fileSize() const
+{
+  if (!f_)
+    return 0;
+  hsize_t size = 0;
+  if (H5Fget_filesize(f_->getId(), &size) < 0)
+    return 0;
+  return size;
+}
+
+void HDF5DataFile::setLayout(unsigned long long chunk_elements,
+  unsigned codec, int level, unsigned long long chunk_cache_bytes)
+{
+  chunk_elements_ = (chunk_elements > 0) ? chunk_elements
+                                         : DEFAULT_EVENTS_PER_CHUNK;
+  codec_ = codec;
+  level_ = level;
+  chunk_cache_bytes_ = chunk_cache_bytes;
+}
+
 void HDF5DataFile::closeDataSets()
 {
   for (std::size_t i = 0; i < datasets_.size(); i++) {
@@ -76,10 +112,19 @@ void HDF5DataFile::closeDataSets()
       datasets_[i]->close();
   }
   datasets_.clear();
+  ds_sizes_.clear();
 }
 
-std::size_t HDF5DataFile::addDataSetRaw(const char *name_arg, hid_t h5type)
+std::size_t HDF5DataFile::addDataSetRaw(const char *name_arg, hid_t h5type,
+                                        unsigned long long chunk_elements,
+                                        unsigned prefilters)
 {
+  if (chunk_elements == 0)
+    chunk_elements = chunk_elements_;
+  unsigned long long cache_bytes = chunk_cache_bytes_;
+  if (cache_bytes == 0)
+    cache_bytes = 2 * chunk_elements * H5Tget_size(h5type);
+
   hsize_t dims[RANK];
   hsize_t maxdims[RANK];
 
@@ -88,16 +133,36 @@ std::size_t HDF5DataFile::addDataSetRaw(const char *name_arg, hid_t h5type)
   H5::DataSpace dataSpace = H5::DataSpace(RANK, dims, maxdims);
 
   H5P_Owner dapl(H5Pcreate(H5P_DATASET_ACCESS)); // property list
-  H5Pset_chunk_cache(dapl.id(), 0, 0, H5D_CHUNK_CACHE_W0_DEFAULT);
+  // w0 = 1: fully written chunks are evicted first (we only ever append)
+  H5Pset_chunk_cache(dapl.id(), H5D_CHUNK_CACHE_NSLOTS_DEFAULT,
+                     static_cast<size_t>(cache_bytes), 1.0);
   H5P_Owner lcpl(H5Pcreate(H5P_LINK_CREATE)); // property list
   // we don't set any properties in lcpl, but it is required by H5Dcreate
   // ------------------------
   H5::DSetCreatPropList prop;
   hsize_t chunkdims[RANK];
-  chunkdims[0] = EVENTS_PER_CHUNK;
+  chunkdims[0] = chunk_elements;
   prop.setChunk(RANK, chunkdims);
-  if (PACKLEVEL>0)
-    prop.setDeflate(PACKLEVEL);
+  // filter order: delta, (bit) shuffle, codec
+  if (prefilters & PreFilter::DELTA) {
+    RegisterH5ZDeltaFilter();
+    unsigned elsize = static_cast<unsigned>(H5Tget_size(h5type));
+    if (H5Pset_filter(prop.getId(), SCTDC_H5Z_FILTER_DELTA,
+                      H5Z_FLAG_MANDATORY, 1, &elsize) < 0)
+      filter_error_ = true;
+  }
+  if (prefilters & PreFilter::BITSHUFFLE) {
+    // block size 0: automatic, compression 0: none (the codec follows)
+    const unsigned bshuf_cd[2] = {0, 0};
+    if (H5Pset_filter(prop.getId(), SCTDC_H5Z_FILTER_BITSHUFFLE,
+                      H5Z_FLAG_OPTIONAL, 2, bshuf_cd) < 0)
+      filter_error_ = true;
+  }
+  else if (prefilters & PreFilter::SHUFFLE) {
+    prop.setShuffle();
+  }
+  if (!SetCodecFilter(prop.getId(), codec_, level_))
+    filter_error_ = true;
   // ------------------------
 
   hid_t datasetc = H5Dcreate(
@@ -105,22 +170,26 @@ std::size_t HDF5DataFile::addDataSetRaw(const char *name_arg, hid_t h5type)
     lcpl.id(), prop.getId(), dapl.id());
   // copy and convert to C++
   datasets_.push_back(std::make_shared<H5::DataSet>(datasetc));
+  ds_sizes_.push_back(0);
   H5Dclose(datasetc);
   return datasets_.size()-1;
 }
 
 template <typename T>
-std::size_t HDF5DataFile::addDataSet(const char* name_arg)
+std::size_t HDF5DataFile::addDataSet(const char* name_arg,
+                                     unsigned long long chunk_elements)
 {
-  return addDataSetRaw(name_arg, GetH5DataType(T()).getId());
+  return addDataSetRaw(name_arg, GetH5DataType(T()).getId(), chunk_elements);
 }
 
 // explicit template instantiations
 template
-std::size_t HDF5DataFile::addDataSet<unsigned short>(const char* name_arg);
+std::size_t HDF5DataFile::addDataSet<unsigned short>(
+  const char* name_arg, unsigned long long chunk_elements);
 
 template
-std::size_t HDF5DataFile::addDataSet<unsigned long long>(const char* name_arg);
+std::size_t HDF5DataFile::addDataSet<unsigned long long>(
+  const char* name_arg, unsigned long long chunk_elements);
 
 
 // -----------------------------------------------------------------------------
@@ -150,6 +219,65 @@ void HDF5DataFile::appendToDataSetRaw(std::size_t DSindex, void* buf,
 
 // -----------------------------------------------------------------------------
 
+void HDF5DataFile::appendChunkRaw(std::size_t DSindex, const void* buf,
+  std::size_t nbytes, std::size_t elements, unsigned filter_mask)
+{
+  hid_t ds = datasets_[DSindex]->getId();
+  hsize_t offset[RANK];
+  hsize_t newsize[RANK];
+  offset[0] = ds_sizes_[DSindex];
+  newsize[0] = ds_sizes_[DSindex] + elements;
+  H5Dset_extent(ds, newsize);
+#if H5_VERSION_GE(1,10,3)
+  H5Dwrite_chunk(ds, H5P_DEFAULT, filter_mask, offset, nbytes, buf);
+#else
+  H5DOwrite_chunk(ds, H5P_DEFAULT, filter_mask, offset, nbytes, buf);
+#endif
+  ds_sizes_[DSindex] = newsize[0];
+}
+
+// -----------------------------------------------------------------------------
+
+unsigned long long HDF5DataFile::dataSetSize(std::size_t DSindex) const
+{
+  H5::DataSpace space = datasets_[DSindex]->getSpace();
+  hsize_t dims[RANK];
+  space.getSimpleExtentDims(dims);
+  return dims[0];
+}
+
+void HDF5DataFile::addVirtualDataSet(const char* name_arg, hid_t h5type,
+  const std::vector<std::string>& files,
+  const std::vector<unsigned long long>& sizes)
+{
+  hsize_t dims[RANK];
+  dims[0] = 0;
+  for (std::size_t i = 0; i < sizes.size(); i++)
+    dims[0] += sizes[i];
+  H5::DataSpace vspace(RANK, dims);
+  H5P_Owner dcpl(H5Pcreate(H5P_DATASET_CREATE));
+  hsize_t start[RANK];
+  hsize_t count[RANK];
+  start[0] = 0;
+  for (std::size_t i = 0; i < files.size(); i++) {
+    if (sizes[i] == 0)
+      continue;
+    count[0] = sizes[i];
+    H5::DataSpace srcspace(RANK, count);
+    vspace.selectHyperslab(H5S_SELECT_SET, count, start);
+    H5Pset_virtual(dcpl.id(), vspace.getId(), files[i].c_str(), name_arg,
+                   srcspace.getId());
+    start[0] += sizes[i];
+  }
+  vspace.selectAll();
+  hid_t ds = H5Dcreate(f_->getId(), name_arg, h5type, vspace.getId(),
+                       H5P_DEFAULT, dcpl.id(), H5P_DEFAULT);
+  if (ds >= 0)
+    H5Dclose(ds);
+}
+
+// -----------------------------------------------------------------------------
+
 std::string HDF5DataFile::format_time()
 {
   char date[32];
@@ -172,3 +300,6 @@ void HDF5DataFile::addRootAttrib(const char *name_arg, const T& val)
 // explicit template instantiations
 template
 void HDF5DataFile::addRootAttrib<std::string>(const char*, const std::string&);
+template
+void HDF5DataFile::addRootAttrib<unsigned long long>(
+  const char*, const unsigned long long&);
@@ -23,11 +23,17 @@ namespace H5 { class DataSet; }
 class HDF5DataFile
 {
   static const unsigned RANK = 1;
-  static const unsigned EVENTS_PER_CHUNK = 50000;
-  static const unsigned PACKLEVEL = 0;
+  static const unsigned DEFAULT_EVENTS_PER_CHUNK = 50000;
+
+  unsigned long long chunk_elements_ = DEFAULT_EVENTS_PER_CHUNK;
+  unsigned long long chunk_cache_bytes_ = 0;
+  unsigned codec_ = 0; // CompressionCodec value
+  int level_ = 0;
+  bool filter_error_ = false; // a filter of some dataset could not be set
 
   std::unique_ptr<H5::H5File> f_;
   std::vector<std::shared_ptr<H5::DataSet>> datasets_;
+  std::vector<unsigned long long> ds_sizes_; // for appendChunkRaw
 
 public:
   HDF5DataFile();
@@ -36,13 +42,46 @@ public:
   void close();
   bool isOpen() const;
 
+  /**
+   * true if the filter pipeline of a dataset added since open() could not be
+   * set up as requested (e.g. the codec is not available). The datasets then
+   * do not match the chunks that the caller compresses itself, so the file
+   * should not be used.
+   */
+  bool filterError() const { return filter_error_; }
+
+  /** exchange the files, datasets and layouts of two objects */
+  void swap(HDF5DataFile& other);
+
+  /** current size of the file in bytes (0 if not open) */
+  unsigned long long fileSize() const;
+
   void closeDataSets();
 
+  /**
+   * @brief setLayout set the storage parameters for subsequently added
+   * datasets
+   * @param chunk_elements default number of elements per chunk
+   * @param codec compression codec, one of the CompressionCodec values
+   * @param level compression level of the codec
+   * @param chunk_cache_bytes size of the chunk cache per dataset. If 0, the
+   * cache is sized to hold two chunks, such that appending never has to read
+   * back a partially written chunk from the file
+   */
+  void setLayout(unsigned long long chunk_elements, unsigned codec, int level,
+                 unsigned long long chunk_cache_bytes);
+
   // addDataSet returns index of the newly created dataset in datasets_ vector
   template <typename T>
-  std::size_t addDataSet(const char* name_arg);
+  std::size_t addDataSet(const char* name_arg,
+                         unsigned long long chunk_elements = 0);
 
-  std::size_t addDataSetRaw(const char* name_arg, hid_t h5type);
+  // chunk_elements == 0 selects the chunk size set by setLayout.
+  // prefilters is a combination of PreFilter flags (see HDF5PreFilters.hpp),
+  // already resolved by ResolvePreFilters
+  std::size_t addDataSetRaw(const char* name_arg, hid_t h5type,
+                            unsigned long long chunk_elements = 0,
+                            unsigned prefilters = 0);
 
   template <typename T>
   void appendToDataSet(std::size_t DSindex, T* buf, size_t elements);
@@ -50,6 +89,33 @@ public:
   void appendToDataSetRaw(std::size_t DSindex, void* buf, size_t elements,
                           hid_t h5type);
 
+  /**
+   * @brief appendChunkRaw append one chunk by a direct chunk write, bypassing
+   * the HDF5 filter pipeline. The dataset must have been filled only by this
+   * function and only with full chunks, before (the last chunk may be partial,
+   * but must still have the full chunk size before compression).
+   * @param buf chunk data as it would be produced by the filter pipeline
+   * @param nbytes size of buf in bytes
+   * @param elements number of valid elements in the chunk
+   * @param filter_mask bit i set means that filter i was skipped for this
+   * chunk (0 if the chunk passed all filters)
+   */
+  void appendChunkRaw(std::size_t DSindex, const void* buf, std::size_t nbytes,
+                      std::size_t elements, unsigned filter_mask);
+
+  /** current number of elements in the dataset */
+  unsigned long long dataSetSize(std::size_t DSindex) const;
+
+  /**
+   * @brief addVirtualDataSet add a dataset that is the concatenation of the
+   * datasets of the same name in other files (HDF5 virtual dataset)
+   * @param files source file names, relative to the directory of this file
+   * @param sizes number of elements of the source dataset in each file
+   */
+  void addVirtualDataSet(const char* name_arg, hid_t h5type,
+                         const std::vector<std::string>& files,
+                         const std::vector<unsigned long long>& sizes);
+
   template <typename T>
   void addRootAttrib(const char* name_arg, const T& val);
 
@@ -2,56 +2,69 @@
  * Copyright (C) 2020 Surface Concept GmbH
 */
 #include "HDF5EventBuf.hpp"
-#include <thread>
-#include <chrono>
+#include <cstdlib>
+#include <new>
 //#include <iostream>
 
+HDF5EventBuf::HDF5EventBuf(const HDF5EventBufConfig& c)
+  : cfg_(c), head_(0), tail_(0), high_water_(0), dropped_(0), partial_len_(0),
+    events_pushed_(0), overflow_(false), activebuf_len_(0),
+    transpose_(SelectEventTransposeFn(c.datasel.value))
+{
+  if (cfg_.size < 1)
+    cfg_.size = 1;
+  if (cfg_.nr_pages < 2)
+    cfg_.nr_pages = 2;
+  initbufs();
+  fill_h5types();
+  fill_names();
+}
+
 void HDF5EventBuf::release_partial_page()
 {
   activebuf_len_ = 0;
+  partial_len_.store(0, std::memory_order_release);
   _reset_buffer_ptrs();
 }
 
 void HDF5EventBuf::_reset_buffer_ptrs()
 {
+  const std::size_t slot = page_slot(head_.load(std::memory_order_relaxed));
   for (unsigned i = 0; i < NR_OF_BUFS; i++) {
     if (cfg_.datasel.value & mask_from_bufid[i]) {
-      buf_el_ptrs_[i] = buffers_[i+(activebuf_ * NR_OF_BUFS)];
+      buf_el_ptrs_[i] = buffers_[i + slot];
     }
     else {
-      buf_el_ptrs_[i] = &datadummy_;
+      buf_el_ptrs_[i] = nullptr;
     }
   }
 }
 
-void HDF5EventBuf::switchbuf(bool init)
+void HDF5EventBuf::publish_page()
 {
-  // update activebuf_, buf0full_, buf1full_
-   if ((activebuf_ == 0) && !init) {
-     buf0full_.store(true);
-     while (buf1full_.load()) // have to wait until hdf5 thread clears the buf
-       std::this_thread::sleep_for(std::chrono::milliseconds(1));
-     //if (buf1full_.load()) throw HDF5EventBufFull();
-     activebuf_ = 1;
-   }
-   else {
-     buf1full_.store(!init);
-     while (buf0full_.load()) // have to wait until hdf5 thread clears the buf
-       std::this_thread::sleep_for(std::chrono::milliseconds(1));
-     //if (buf0full_.load()) throw HDF5EventBufFull();
-     activebuf_ = 0;
-   }
-   _reset_buffer_ptrs();
-   activebuf_len_ = 0;
+  // the release store makes the page content visible to the consumer, before
+  // the consumer sees the incremented head_
+  auto h = head_.load(std::memory_order_relaxed) + 1;
+  head_.store(h, std::memory_order_release);
+  activebuf_len_ = 0;
+  auto level = static_cast<unsigned>(
+    h - tail_.load(std::memory_order_relaxed));
+  if (level > high_water_.load(std::memory_order_relaxed))
+    high_water_.store(level, std::memory_order_relaxed);
 }
 
 
 void HDF5EventBuf::initbufs()
 {
-  for (unsigned j = 0; j < 2; j++) {
+  buffers_.resize(static_cast<std::size_t>(cfg_.nr_pages) * NR_OF_BUFS);
+  for (unsigned j = 0; j < cfg_.nr_pages; j++) {
     for (unsigned i = 0; i < NR_OF_BUFS; i++) {
       if (cfg_.datasel.value & mask_from_bufid[i]) {
         buffers_[i+(j*NR_OF_BUFS)] = malloc(cfg_.size*element_sizes[i]);
+        if (buffers_[i+(j*NR_OF_BUFS)] == nullptr) {
+          deletebufs();
+          throw std::bad_alloc();
+        }
       }
       else {
         buffers_[i+(j*NR_OF_BUFS)] = nullptr;
@@ -59,15 +72,14 @@ void HDF5EventBuf::initbufs()
       }
     }
   }
-  switchbuf(true);
+  _reset_buffer_ptrs();
 }
 
 void HDF5EventBuf::deletebufs()
 {
-  for (unsigned j = 0; j < 2; j++)
-    for (unsigned i = 0; i < NR_OF_BUFS; i++)
-      if (cfg_.datasel.value & mask_from_bufid[i])
-        free(buffers_[i+(j*NR_OF_BUFS)]);
+  for (std::size_t i = 0; i < buffers_.size(); i++)
+    free(buffers_[i]);
+  buffers_.clear();
 }
 
 template <typename T>
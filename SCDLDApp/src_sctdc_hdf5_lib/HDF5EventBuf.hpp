@@ -10,39 +10,39 @@
 
 #include <vector>
 #include <string>
-#include <mutex>
 #include <atomic>
 #include "HDF5Config.hpp"
 #include "HDF5Utilities.h"
+#include "HDF5EventTranspose.hpp"
 #include <scTDC_types.h>
 //#include <iostream>
 
 struct HDF5EventBufConfig {
   EventDataFieldSelection datasel;
-  unsigned long long size;
-  HDF5EventBufConfig() : size(10) { }
+  unsigned long long size; // number of events per buffer page
+  unsigned nr_pages;       // number of buffer pages in the ring
+  HDF5EventBufConfig() : size(10), nr_pages(2) { }
   HDF5EventBufConfig(
     const EventDataFieldSelection& datasel_arg,
-    unsigned long long size_arg)
-    : datasel(datasel_arg), size(size_arg) {}
-};
-
-struct HDF5EventBufFull : public std::exception
-{
-  const char * what () const throw () {
-    return "HDF5 event buffer is full";
-  }
+    unsigned long long size_arg,
+    unsigned nr_pages_arg)
+    : datasel(datasel_arg), size(size_arg), nr_pages(nr_pages_arg) {}
 };
 
 /**
  * @brief The HDF5EventBuf class inter-thread event data exchange for HDF5
- * writing. Accomplishes two things: (1) double buffers (two "buffer pages") for
- * letting the consumer read the data without mutex locking most of the time
- * (except for getting the final remainder of data at the end). (2) casting the
- * incoming events into 1D arrays (sc_DldEvent* is an array of structs, for
- * the HDF5 we want a struct of arrays --- calling the HDF5 function for
- * appending data has considerable overhead, so one cannot append single
- * events).
+ * writing. Accomplishes two things: (1) a ring of N buffer pages with a single
+ * producer and a single consumer, synchronized only by atomic head / tail page
+ * counters, such that neither side ever needs to lock a mutex and the producer
+ * (the scTDC USER_CALLBACKS thread) never needs to wait for the consumer.
+ * (2) casting the incoming events into 1D arrays (sc_DldEvent* is an array of
+ * structs, for the HDF5 we want a struct of arrays --- calling the HDF5
+ * function for appending data has considerable overhead, so one cannot append
+ * single events). The transposition is done by a kernel that is specialized
+ * for the data field selection and only touches the selected columns (see
+ * HDF5EventTranspose.hpp).
+ * If the consumer falls behind such that all pages are full, incoming events
+ * are dropped and counted, instead of stalling the TDC readout.
  */
 class HDF5EventBuf
 {
@@ -63,14 +63,7 @@ public:
   static const unsigned NR_OF_BUFS = 10; // one larger than the highest index
   // -----------------------
 
-  HDF5EventBuf(const HDF5EventBufConfig& c)
-    : cfg_(c), buf_el_idx_(0), buf0full_(false), buf1full_(false),
-      activebuf_(0)
-  {
-    initbufs();
-    fill_h5types();
-    fill_names();
-  }
+  HDF5EventBuf(const HDF5EventBufConfig& c);
 
   ~HDF5EventBuf()
   {
@@ -79,43 +72,58 @@ public:
 
   /**
    * @brief push add DLD event data to the event buffer. The return value is
-   * useful to decide whether to wake up a consumer thread. Locks a mutex which
-   * should be almost always unlocked (negligible performance cost).
-   * This mutex will only be taken by a consumer, if the consumer tries
-   * to get the latest data from a partially filled buffer page.
+   * useful to decide whether to wake up a consumer thread. Must only be called
+   * from a single producer thread. Does not lock any mutex and does not wait:
+   * if all buffer pages are full, the events that do not fit are dropped and
+   * counted (see dropped_events()).
    * @param e DLD event array
    * @param len length of the DLD event array
-   * @return true if a buffer page became full
+   * @return true if at least one buffer page became full
    */
   bool push(const sc_DldEvent *const e, std::size_t len)
   {
-    std::unique_lock<std::mutex> lock(mutex_);
+    if (overflow_) {
+      if (!next_page_free()) {
+        dropped_.store(dropped_.load(std::memory_order_relaxed) + len,
+                       std::memory_order_relaxed);
+        return false;
+      }
+      overflow_ = false;
+      _reset_buffer_ptrs();
+    }
     bool bufpage_became_full = false;
-    for (std::size_t eidx = 0; eidx < len; eidx++) {
-      const sc_DldEvent& ev = e[eidx];
-      push_val(BSTARTCTR, ev.start_counter);
-      push_val(BTIMETAG, ev.time_tag);
-      push_val(BSUBDEV, ev.subdevice);
-      push_val(BCHANNEL, ev.channel);
-      push_val(BSUM, ev.sum);
-      push_val(BDIF1, ev.dif1);
-      push_val(BDIF2, ev.dif2);
-      push_val(BMRC, ev.master_rst_counter);
-      push_val(BADC, ev.adc);
-      push_val(BSIGBIT, ev.signal1bit);
-      // ---  once after each event --------------------------
-      activebuf_len_ += 1;
+    std::size_t eidx = 0;
+    while (eidx < len) {
+      // transpose as many events as fit into the active page in one go
+      std::size_t n = static_cast<std::size_t>(cfg_.size - activebuf_len_);
+      if (n > len - eidx)
+        n = len - eidx;
+      transpose_(cfg_.datasel.value, e + eidx, n, buf_el_ptrs_);
+      advance_buffer_ptrs(n);
+      eidx += n;
+      events_pushed_.store(events_pushed_.load(std::memory_order_relaxed) + n,
+                           std::memory_order_relaxed);
+      activebuf_len_ += n;
       if (activebuf_len_ == cfg_.size) {
-        switchbuf();
+        publish_page();
         bufpage_became_full = true;
+        if (!next_page_free()) {
+          overflow_ = true;
+          dropped_.store(
+            dropped_.load(std::memory_order_relaxed) + (len - eidx),
+            std::memory_order_relaxed);
+          break;
+        }
+        _reset_buffer_ptrs();
       }
     }
+    partial_len_.store(activebuf_len_, std::memory_order_release);
     return bufpage_became_full;
   }
 
   /**
-   * @brief get_buf returns full buf page for the specified data field.
-   * Used by consumer.
+   * @brief get_buf returns the oldest full buf page for the specified data
+   * field. Used by consumer.
    * Only returns a buffer if there is a full buffer page. No mutex locking
    * is needed since the returned buffer is not used by the producer.
    * The buffer page has a length as returned by size(). After getting all
@@ -127,38 +135,36 @@ public:
    * @return buffer pointer
    */
   void* get_buf(unsigned buf_id) const {
-    if (buf_id >= NR_OF_BUFS)
-      return nullptr;
-    if (buf0full_.load())
-      return buffers_[buf_id];
-    else if (buf1full_.load())
-      return buffers_[buf_id+NR_OF_BUFS];
-    else
+    if (buf_id >= NR_OF_BUFS || !has_data_page())
       return nullptr;
+    return buffers_[buf_id + page_slot(tail_.load(std::memory_order_relaxed))];
   }
 
   /**
    * @brief get_partial_buf returns partial buf page for specified data field.
-   * Used by consumer. Requires that mutex() be locked (which will block the
-   * producer). During the lock, the consumer will want to call this function
-   * for all desired data fields and then call release_partial_page().
+   * Used by consumer. Requires that the producer has stopped pushing (i.e.
+   * the USER_CALLBACKS pipe has been closed) and that all full pages have been
+   * released, before. The consumer will want to call this function for all
+   * desired data fields and then call release_partial_page().
    * @param buf_id must be one of BSTARTCTR, BTIMETAG, ..., BSIGBIT
    * @param b (*b) takes the pointer to the partial buffer
    * @param len (*len) takes the number of valid entries in partial buffer
    */
   void get_partial_buf(unsigned buf_id, void** b, size_t* len) const {
-    if (buf_id >= NR_OF_BUFS ||
+    if (buf_id >= NR_OF_BUFS || overflow_ ||
         ((cfg_.datasel.value & mask_from_bufid[buf_id]) == 0))
     {
       *b = nullptr;
       *len = 0;
+      return;
     }
-    *len = activebuf_len_;
-    *b = buffers_[buf_id+(activebuf_ * NR_OF_BUFS)];
+    *len = partial_len_.load(std::memory_order_acquire);
+    *b = buffers_[buf_id + page_slot(head_.load(std::memory_order_acquire))];
   }
 
   bool has_data_page() const {
-    return (buf0full_.load() || buf1full_.load());
+    return head_.load(std::memory_order_acquire) !=
+      tail_.load(std::memory_order_relaxed);
   }
 
   hid_t get_h5_type(unsigned buf_id) const {
@@ -177,20 +183,20 @@ public:
   /**
    * @brief release_page release a consumed buffer page.
    * Used by the consumer to indicate that it has finished processing the
-   * currently filled buffer page.
+   * oldest full buffer page.
    */
   void release_page() {
-    if (buf0full_.load())
-      buf0full_.store(false);
-    else if (buf1full_.load())
-      buf1full_.store(false);
+    if (!has_data_page())
+      return;
+    tail_.store(tail_.load(std::memory_order_relaxed) + 1,
+                std::memory_order_release);
   }
 
   /**
    * @brief release_partial_page release a consumed partial buffer page.
    * Used by the consumer to indicate that it has finished processing the
-   * latest data from the partially filled buffer page. Requires the mutex()
-   * to be locked by the consumer. Use this in conjunction with get_partial_buf.
+   * latest data from the partially filled buffer page. Same requirements as
+   * for get_partial_buf.
    */
   void release_partial_page();
 
@@ -198,7 +204,37 @@ public:
     return cfg_.size;
   }
 
-  std::mutex& mutex() { return mutex_; }
+  /** element size in bytes of a data field, 0 if the field is not selected */
+  unsigned element_size(unsigned buf_id) const {
+    if (buf_id >= NR_OF_BUFS)
+      return 0;
+    return element_sizes[buf_id];
+  }
+
+  unsigned nr_pages() const {
+    return cfg_.nr_pages;
+  }
+
+  /** number of full pages waiting for the consumer */
+  unsigned fill_level() const {
+    return static_cast<unsigned>(head_.load(std::memory_order_relaxed) -
+      tail_.load(std::memory_order_relaxed));
+  }
+
+  /** maximum number of full pages that were ever waiting for the consumer */
+  unsigned high_water_mark() const {
+    return high_water_.load(std::memory_order_relaxed);
+  }
+
+  /** number of events that were dropped because all pages were full */
+  unsigned long long dropped_events() const {
+    return dropped_.load(std::memory_order_relaxed);
+  }
+
+  /** number of events accepted into the buffer */
+  unsigned long long events_pushed() const {
+    return events_pushed_.load(std::memory_order_relaxed);
+  }
 
   const char* get_name(unsigned buf_id) const {
     if (buf_id >= NR_OF_BUFS)
@@ -207,19 +243,25 @@ public:
   }
 
 private: // methods
-  void switchbuf(bool init=false); // switch between buffer pages #0 and #1
+  void publish_page(); // hand the active page over to the consumer
+  bool next_page_free() const {
+    return head_.load(std::memory_order_relaxed) -
+      tail_.load(std::memory_order_acquire) < cfg_.nr_pages;
+  }
+  // index of the first column buffer of a page in buffers_
+  std::size_t page_slot(unsigned long long page_counter) const {
+    return static_cast<std::size_t>(page_counter % cfg_.nr_pages) * NR_OF_BUFS;
+  }
   void initbufs(); // allocate buffers and set unused element sizes to zero
   void deletebufs(); // free buffers
   void fill_h5types();
 
-  template <typename T>
-  void push_val(unsigned buf_id, const T& val) {
-    if (buf_el_ptrs_[buf_id]==nullptr) throw -1;
-    *reinterpret_cast<T*>(buf_el_ptrs_[buf_id]) = val;
-    buf_el_ptrs_[buf_id] = reinterpret_cast<char*>(buf_el_ptrs_[buf_id])
-        + element_sizes[buf_id];
-    // (had to use the pointer increment from element_sizes, because for
-    // unused data fields, the ptr must remain on the datadummy_ element)
+  void advance_buffer_ptrs(std::size_t n) {
+    for (unsigned i = 0; i < NR_OF_BUFS; i++) {
+      if (buf_el_ptrs_[i] != nullptr)
+        buf_el_ptrs_[i] = static_cast<char*>(buf_el_ptrs_[i])
+          + n * element_sizes[i];
+    }
   }
 
   template <typename T>
@@ -230,19 +272,24 @@ private: // methods
   void _reset_buffer_ptrs();
 
 private:
-  std::mutex mutex_;
   HDF5EventBufConfig cfg_;
-  unsigned long long buf_el_idx_;
 
-  std::atomic_bool buf0full_;
-  std::atomic_bool buf1full_;
-  unsigned activebuf_;
+  // page counters: head_ counts pages handed over to the consumer, tail_
+  // counts pages released by the consumer. The producer fills the page
+  // with index head_ % nr_pages, if head_ - tail_ < nr_pages
+  std::atomic<unsigned long long> head_;
+  std::atomic<unsigned long long> tail_;
+  std::atomic<unsigned> high_water_;
+  std::atomic<unsigned long long> dropped_;
+  std::atomic<unsigned long long> partial_len_;
+  std::atomic<unsigned long long> events_pushed_; // written by the producer
+  // producer-only state
+  bool overflow_; // true, if all pages were full after the last page switch
   unsigned long long activebuf_len_; // number of written elements in active buf
 
-
-  void* buffers_[NR_OF_BUFS*2];
-  void* buf_el_ptrs_[NR_OF_BUFS];
-  unsigned buf_incr_[NR_OF_BUFS]; // byte-address increment of each buffer
+  std::vector<void*> buffers_; // nr_pages * NR_OF_BUFS column buffers
+  void* buf_el_ptrs_[NR_OF_BUFS]; // write positions, nullptr if unselected
+  HDF5EventTransposeFn transpose_; // selected once per configuration
 
   EventDataFieldSelection::type mask_from_bufid[NR_OF_BUFS] =
   { EventDataFieldSelection::STARTCTR, EventDataFieldSelection::TIMETAG,
@@ -265,8 +312,6 @@ private:
 
   hid_t element_h5types[NR_OF_BUFS];
   H5::DataType h5type_objs[NR_OF_BUFS];
-
-  unsigned long long datadummy_;
 };
 
 #endif
@@ -0,0 +1,240 @@
+/*
+ * Copyright (C) 2020 Surface Concept GmbH
+*/
+#include "HDF5EventTranspose.hpp"
+#include "HDF5EventBuf.hpp"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define HDF5EVENTTRANSPOSE_X86
+#include <immintrin.h>
+#endif
+
+namespace {
+
+typedef EventDataFieldSelection S;
+typedef HDF5EventBuf B;
+
+// the default selection (x, y, time)
+const S::type XYT = S::DIF1 | S::DIF2 | S::SUM;
+
+template <typename T>
+T* col(void* const* dst, unsigned buf_id)
+{
+  return static_cast<T*>(dst[buf_id]);
+}
+
+/**
+ * one pass over the events, writing one element per selected column. The
+ * selection is a template parameter, such that the compiler removes all code
+ * for unselected fields. Instantiated for frequently used selections.
+ */
+template <S::type MASK>
+void transpose_rows(S::type, const sc_DldEvent* e, std::size_t n,
+                    void* const* dst)
+{
+  auto startctr = col<decltype(sc_DldEvent::start_counter)>(dst, B::BSTARTCTR);
+  auto timetag = col<decltype(sc_DldEvent::time_tag)>(dst, B::BTIMETAG);
+  auto subdev = col<decltype(sc_DldEvent::subdevice)>(dst, B::BSUBDEV);
+  auto channel = col<decltype(sc_DldEvent::channel)>(dst, B::BCHANNEL);
+  auto sum = col<decltype(sc_DldEvent::sum)>(dst, B::BSUM);
+  auto dif1 = col<decltype(sc_DldEvent::dif1)>(dst, B::BDIF1);
+  auto dif2 = col<decltype(sc_DldEvent::dif2)>(dst, B::BDIF2);
+  auto mrc = col<decltype(sc_DldEvent::master_rst_counter)>(dst, B::BMRC);
+  auto adc = col<decltype(sc_DldEvent::adc)>(dst, B::BADC);
+  auto sigbit = col<decltype(sc_DldEvent::signal1bit)>(dst, B::BSIGBIT);
+  for (std::size_t i = 0; i < n; i++) {
+    const sc_DldEvent& ev = e[i];
+    if (MASK & S::STARTCTR) startctr[i] = ev.start_counter;
+    if (MASK & S::TIMETAG)  timetag[i] = ev.time_tag;
+    if (MASK & S::SUBDEV)   subdev[i] = ev.subdevice;
+    if (MASK & S::CHANNEL)  channel[i] = ev.channel;
+    if (MASK & S::SUM)      sum[i] = ev.sum;
+    if (MASK & S::DIF1)     dif1[i] = ev.dif1;
+    if (MASK & S::DIF2)     dif2[i] = ev.dif2;
+    if (MASK & S::MRC)      mrc[i] = ev.master_rst_counter;
+    if (MASK & S::ADC)      adc[i] = ev.adc;
+    if (MASK & S::SIGBIT)   sigbit[i] = ev.signal1bit;
+  }
+}
+
+template <typename T, T sc_DldEvent::*FIELD>
+void copy_column(const sc_DldEvent* e, std::size_t n, void* dst)
+{
+  T* d = static_cast<T*>(dst);
+  for (std::size_t i = 0; i < n; i++)
+    d[i] = e[i].*FIELD;
+}
+
+/**
+ * generic kernel for all remaining selections: one tight strided loop per
+ * selected column
+ */
+void transpose_columns(S::type mask, const sc_DldEvent* e, std::size_t n,
+                       void* const* dst)
+{
+  typedef sc_DldEvent E;
+  if (mask & S::STARTCTR)
+    copy_column<decltype(E::start_counter), &E::start_counter>(
+      e, n, dst[B::BSTARTCTR]);
+  if (mask & S::TIMETAG)
+    copy_column<decltype(E::time_tag), &E::time_tag>(e, n, dst[B::BTIMETAG]);
+  if (mask & S::SUBDEV)
+    copy_column<decltype(E::subdevice), &E::subdevice>(e, n, dst[B::BSUBDEV]);
+  if (mask & S::CHANNEL)
+    copy_column<decltype(E::channel), &E::channel>(e, n, dst[B::BCHANNEL]);
+  if (mask & S::SUM)
+    copy_column<decltype(E::sum), &E::sum>(e, n, dst[B::BSUM]);
+  if (mask & S::DIF1)
+    copy_column<decltype(E::dif1), &E::dif1>(e, n, dst[B::BDIF1]);
+  if (mask & S::DIF2)
+    copy_column<decltype(E::dif2), &E::dif2>(e, n, dst[B::BDIF2]);
+  if (mask & S::MRC)
+    copy_column<decltype(E::master_rst_counter), &E::master_rst_counter>(
+      e, n, dst[B::BMRC]);
+  if (mask & S::ADC)
+    copy_column<decltype(E::adc), &E::adc>(e, n, dst[B::BADC]);
+  if (mask & S::SIGBIT)
+    copy_column<decltype(E::signal1bit), &E::signal1bit>(
+      e, n, dst[B::BSIGBIT]);
+}
+
+#ifdef HDF5EVENTTRANSPOSE_X86
+
+// The SIMD kernels for the x, y, time selection load the 16 bytes starting
+// at 'sum' from each event, which contain sum (64 bit) followed by dif1 and
+// dif2 (16 bit each). They are only selected if the sc_DldEvent layout of the
+// installed scTDC headers matches this assumption.
+constexpr bool xyt_simd_layout_ok()
+{
+  return sizeof(sc_DldEvent::sum) == 8 && sizeof(sc_DldEvent::dif1) == 2
+    && sizeof(sc_DldEvent::dif2) == 2
+    && offsetof(sc_DldEvent, dif1) == offsetof(sc_DldEvent, sum) + 8
+    && offsetof(sc_DldEvent, dif2) == offsetof(sc_DldEvent, dif1) + 2
+    && offsetof(sc_DldEvent, sum) + 16 <= sizeof(sc_DldEvent);
+}
+
+__attribute__((target("sse4.1")))
+void transpose_xyt_sse41(S::type, const sc_DldEvent* e, std::size_t n,
+                         void* const* dst)
+{
+  auto t = col<decltype(sc_DldEvent::sum)>(dst, B::BSUM);
+  auto x = col<decltype(sc_DldEvent::dif1)>(dst, B::BDIF1);
+  auto y = col<decltype(sc_DldEvent::dif2)>(dst, B::BDIF2);
+  // gathers the dif1 words into the lower and the dif2 words into the upper
+  // half of the register
+  const __m128i split = _mm_setr_epi8(
+    0, 1, 4, 5, 8, 9, 12, 13, 2, 3, 6, 7, 10, 11, 14, 15);
+  const std::size_t stride = sizeof(sc_DldEvent);
+  const char* p = reinterpret_cast<const char*>(e) + offsetof(sc_DldEvent, sum);
+  std::size_t i = 0;
+  for (; i + 4 <= n; i += 4, p += 4 * stride) {
+    __m128i v0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    __m128i v1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + stride));
+    __m128i v2 = _mm_loadu_si128(
+      reinterpret_cast<const __m128i*>(p + 2 * stride));
+    __m128i v3 = _mm_loadu_si128(
+      reinterpret_cast<const __m128i*>(p + 3 * stride));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(t + i),
+                     _mm_unpacklo_epi64(v0, v1));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(t + i + 2),
+                     _mm_unpacklo_epi64(v2, v3));
+    __m128i d = _mm_unpacklo_epi64(_mm_unpackhi_epi32(v0, v1),
+                                   _mm_unpackhi_epi32(v2, v3));
+    d = _mm_shuffle_epi8(d, split);
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(x + i), d);
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(y + i),
+                     _mm_unpackhi_epi64(d, d));
+  }
+  for (; i < n; i++) {
+    t[i] = e[i].sum;
+    x[i] = e[i].dif1;
+    y[i] = e[i].dif2;
+  }
+}
+
+__attribute__((target("avx2")))
+inline __m256i load_2x128(const char* lo, const char* hi)
+{
+  return _mm256_inserti128_si256(
+    _mm256_castsi128_si256(_mm_loadu_si128(
+      reinterpret_cast<const __m128i*>(lo))),
+    _mm_loadu_si128(reinterpret_cast<const __m128i*>(hi)), 1);
+}
+
+// same as the SSE4.1 kernel, but processes events i..i+3 in the lower and
+// i+4..i+7 in the upper 128-bit lane, then fixes up the lane order
+__attribute__((target("avx2")))
+void transpose_xyt_avx2(S::type, const sc_DldEvent* e, std::size_t n,
+                        void* const* dst)
+{
+  auto t = col<decltype(sc_DldEvent::sum)>(dst, B::BSUM);
+  auto x = col<decltype(sc_DldEvent::dif1)>(dst, B::BDIF1);
+  auto y = col<decltype(sc_DldEvent::dif2)>(dst, B::BDIF2);
+  const __m256i split = _mm256_setr_epi8(
+    0, 1, 4, 5, 8, 9, 12, 13, 2, 3, 6, 7, 10, 11, 14, 15,
+    0, 1, 4, 5, 8, 9, 12, 13, 2, 3, 6, 7, 10, 11, 14, 15);
+  const std::size_t stride = sizeof(sc_DldEvent);
+  const char* p = reinterpret_cast<const char*>(e) + offsetof(sc_DldEvent, sum);
+  std::size_t i = 0;
+  for (; i + 8 <= n; i += 8, p += 8 * stride) {
+    __m256i v0 = load_2x128(p, p + 4 * stride);
+    __m256i v1 = load_2x128(p + stride, p + 5 * stride);
+    __m256i v2 = load_2x128(p + 2 * stride, p + 6 * stride);
+    __m256i v3 = load_2x128(p + 3 * stride, p + 7 * stride);
+    __m256i s01 = _mm256_unpacklo_epi64(v0, v1); // t0 t1 | t4 t5
+    __m256i s23 = _mm256_unpacklo_epi64(v2, v3); // t2 t3 | t6 t7
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(t + i),
+                        _mm256_permute2x128_si256(s01, s23, 0x20));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(t + i + 4),
+                        _mm256_permute2x128_si256(s01, s23, 0x31));
+    __m256i d = _mm256_unpacklo_epi64(_mm256_unpackhi_epi32(v0, v1),
+                                      _mm256_unpackhi_epi32(v2, v3));
+    d = _mm256_shuffle_epi8(d, split);      // x0-3 y0-3 | x4-7 y4-7
+    d = _mm256_permute4x64_epi64(d, 0xD8);  // x0-7 | y0-7
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(x + i),
+                     _mm256_castsi256_si128(d));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(y + i),
+                     _mm256_extracti128_si256(d, 1));
+  }
+  for (; i < n; i++) {
+    t[i] = e[i].sum;
+    x[i] = e[i].dif1;
+    y[i] = e[i].dif2;
+  }
+}
+
+#endif // HDF5EVENTTRANSPOSE_X86
+
+} // namespace
+
+
+HDF5EventTransposeFn SelectEventTransposeFn(
+  EventDataFieldSelection::type mask, bool allow_simd)
+{
+  mask &= S::ALL_DLD;
+#ifdef HDF5EVENTTRANSPOSE_X86
+  if (allow_simd && mask == XYT && xyt_simd_layout_ok()) {
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+      return &transpose_xyt_avx2;
+    if (__builtin_cpu_supports("sse4.1"))
+      return &transpose_xyt_sse41;
+  }
+#else
+  (void) allow_simd;
+#endif
+  switch (mask) {
+  case XYT:
+    return &transpose_rows<XYT>;
+  case XYT | S::TIMETAG:
+    return &transpose_rows<XYT | S::TIMETAG>;
+  case XYT | S::STARTCTR:
+    return &transpose_rows<XYT | S::STARTCTR>;
+  case XYT | S::STARTCTR | S::TIMETAG:
+    return &transpose_rows<XYT | S::STARTCTR | S::TIMETAG>;
+  case S::ALL_DLD:
+    return &transpose_rows<S::ALL_DLD>;
+  default:
+    return &transpose_columns;
+  }
+}
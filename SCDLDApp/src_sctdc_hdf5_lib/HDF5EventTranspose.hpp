@@ -0,0 +1,40 @@
+#ifndef HDF5EVENTTRANSPOSE_HPP
+#define HDF5EVENTTRANSPOSE_HPP
+
+/*
+ * Copyright (C) 2020 Surface Concept GmbH
+*/
+
+// kernels for splitting arrays of sc_DldEvent structs into column buffers
+// (array of structs -> struct of arrays), used by HDF5EventBuf::push
+
+#include <cstddef>
+#include "HDF5Config.hpp"
+#include <scTDC_types.h>
+
+/**
+ * @brief signature of a transposition kernel. Copies the selected fields of
+ * n events into the column buffers dst[HDF5EventBuf::BSTARTCTR], ...,
+ * dst[HDF5EventBuf::BSIGBIT], each starting at element 0 of the respective
+ * column. Column buffers of unselected fields are not accessed and may be
+ * nullptr.
+ * @param mask the data field selection (only evaluated by the generic kernel,
+ * the specialized kernels have the selection compiled in)
+ */
+typedef void (*HDF5EventTransposeFn)(
+  EventDataFieldSelection::type mask,
+  const sc_DldEvent* e,
+  std::size_t n,
+  void* const* dst);
+
+/**
+ * @brief SelectEventTransposeFn returns the fastest transposition kernel for
+ * the given data field selection on the current CPU. Intended to be called
+ * once per configuration, not per push.
+ * @param mask data field selection bitmask
+ * @param allow_simd if false, only the portable kernels are considered
+ */
+HDF5EventTransposeFn SelectEventTransposeFn(
+  EventDataFieldSelection::type mask, bool allow_simd = true);
+
+#endif
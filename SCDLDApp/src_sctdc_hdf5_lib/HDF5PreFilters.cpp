@@ -0,0 +1,140 @@
+/*
+ * Copyright (C) 2020 Surface Concept GmbH
+*/
+#include "HDF5PreFilters.hpp"
+#include <cstring>
+
+namespace {
+
+template <typename T>
+void delta_zigzag_encode(const void* src, void* dst, std::size_t n)
+{
+  const unsigned shift = sizeof(T) * 8 - 1;
+  T prev = 0;
+  for (std::size_t i = 0; i < n; i++) {
+    T v;
+    memcpy(&v, static_cast<const char*>(src) + i * sizeof(T), sizeof(T));
+    T d = static_cast<T>(v - prev);
+    prev = v;
+    // zig-zag: 0, -1, 1, -2, 2, ... -> 0, 1, 2, 3, 4, ...
+    T z = static_cast<T>(
+      static_cast<T>(d << 1) ^ static_cast<T>(0 - (d >> shift)));
+    memcpy(static_cast<char*>(dst) + i * sizeof(T), &z, sizeof(T));
+  }
+}
+
+template <typename T>
+void delta_zigzag_decode(void* buf, std::size_t n)
+{
+  T prev = 0;
+  for (std::size_t i = 0; i < n; i++) {
+    T z;
+    memcpy(&z, static_cast<char*>(buf) + i * sizeof(T), sizeof(T));
+    T d = static_cast<T>((z >> 1) ^ static_cast<T>(0 - (z & 1)));
+    prev = static_cast<T>(prev + d);
+    memcpy(static_cast<char*>(buf) + i * sizeof(T), &prev, sizeof(T));
+  }
+}
+
+// HDF5 filter callback. cd_values[0] holds the element size.
+size_t H5Z_filter_sctdc_delta(unsigned flags, size_t cd_nelmts,
+  const unsigned cd_values[], size_t nbytes, size_t* buf_size, void** buf)
+{
+  (void) buf_size;
+  if (cd_nelmts < 1)
+    return 0;
+  bool ok;
+  if (flags & H5Z_FLAG_REVERSE)
+    ok = DeltaZigzagDecode(*buf, nbytes, cd_values[0]);
+  else
+    ok = DeltaZigzagEncode(*buf, *buf, nbytes, cd_values[0]);
+  return ok ? nbytes : 0;
+}
+
+} // namespace
+
+
+const H5Z_class2_t H5Z_SCTDC_DELTA[1] = {{
+  H5Z_CLASS_T_VERS,
+  static_cast<H5Z_filter_t>(SCTDC_H5Z_FILTER_DELTA),
+  1, // encoder present
+  1, // decoder present
+  "sctdc delta zigzag",
+  nullptr, // can_apply
+  nullptr, // set_local (the writer passes the element size in cd_values)
+  H5Z_filter_sctdc_delta
+}};
+
+bool RegisterH5ZDeltaFilter()
+{
+  if (H5Zfilter_avail(SCTDC_H5Z_FILTER_DELTA) > 0)
+    return true;
+  return H5Zregister(H5Z_SCTDC_DELTA) >= 0;
+}
+
+unsigned ResolvePreFilters(unsigned prefilters)
+{
+  if ((prefilters & PreFilter::BITSHUFFLE) &&
+      H5Zfilter_avail(SCTDC_H5Z_FILTER_BITSHUFFLE) <= 0)
+  {
+    prefilters = (prefilters & ~PreFilter::BITSHUFFLE) | PreFilter::SHUFFLE;
+  }
+  if (prefilters & PreFilter::BITSHUFFLE)
+    prefilters &= ~PreFilter::SHUFFLE;
+  return prefilters;
+}
+
+bool DeltaZigzagEncode(const void* src, void* dst, std::size_t nbytes,
+                       std::size_t elsize)
+{
+  switch (elsize) {
+  case 1: delta_zigzag_encode<unsigned char>(src, dst, nbytes); return true;
+  case 2: delta_zigzag_encode<unsigned short>(src, dst, nbytes / 2);
+    break;
+  case 4: delta_zigzag_encode<unsigned>(src, dst, nbytes / 4); break;
+  case 8: delta_zigzag_encode<unsigned long long>(src, dst, nbytes / 8);
+    break;
+  default:
+    return false;
+  }
+  // trailing bytes that do not form a full element are passed through
+  std::size_t rest = nbytes % elsize;
+  if (rest > 0 && src != dst)
+    memcpy(static_cast<char*>(dst) + nbytes - rest,
+           static_cast<const char*>(src) + nbytes - rest, rest);
+  return true;
+}
+
+bool DeltaZigzagDecode(void* buf, std::size_t nbytes, std::size_t elsize)
+{
+  switch (elsize) {
+  case 1: delta_zigzag_decode<unsigned char>(buf, nbytes); return true;
+  case 2: delta_zigzag_decode<unsigned short>(buf, nbytes / 2); return true;
+  case 4: delta_zigzag_decode<unsigned>(buf, nbytes / 4); return true;
+  case 8: delta_zigzag_decode<unsigned long long>(buf, nbytes / 8);
+    return true;
+  default:
+    return false;
+  }
+}
+
+void ByteShuffle(const void* src, void* dst, std::size_t nbytes,
+                 std::size_t elsize)
+{
+  const unsigned char* s = static_cast<const unsigned char*>(src);
+  unsigned char* d = static_cast<unsigned char*>(dst);
+  const std::size_t n = (elsize > 0) ? nbytes / elsize : 0;
+  if (elsize <= 1 || n <= 1) {
+    memcpy(d, s, nbytes);
+    return;
+  }
+  for (std::size_t j = 0; j < elsize; j++) {
+    unsigned char* dj = d + j * n;
+    for (std::size_t i = 0; i < n; i++)
+      dj[i] = s[i * elsize + j];
+  }
+  // like the HDF5 shuffle filter, leftover bytes are copied unchanged
+  std::size_t rest = nbytes - n * elsize;
+  if (rest > 0)
+    memcpy(d + n * elsize, s + n * elsize, rest);
+}
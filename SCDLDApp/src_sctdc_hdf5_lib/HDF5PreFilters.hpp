@@ -0,0 +1,69 @@
+#ifndef HDF5PREFILTERS_HPP
+#define HDF5PREFILTERS_HPP
+
+/*
+ * Copyright (C) 2020 Surface Concept GmbH
+*/
+
+// pre-conditioning filters for the event columns, applied before the codec:
+// byte shuffle (HDF5 built-in), bit shuffle (filter plugin 32008, if
+// available) and delta / zig-zag encoding (our own filter, see below)
+
+#include <cstddef>
+#include <hdf5.h>
+
+/**
+ * ID of the delta / zig-zag filter. The range 256..511 is reserved by The HDF
+ * Group for filters that are not officially registered. Readers need the
+ * sctdc_h5zdelta plugin library in their HDF5_PLUGIN_PATH to decode datasets
+ * using this filter.
+ */
+#define SCTDC_H5Z_FILTER_DELTA 305
+#define SCTDC_H5Z_FILTER_BITSHUFFLE 32008
+
+/** bitmask values for the pre-filters of one data field */
+struct PreFilter
+{
+  static const unsigned DELTA = 0x1;      // delta + zig-zag encoding
+  static const unsigned SHUFFLE = 0x2;    // byte shuffle
+  static const unsigned BITSHUFFLE = 0x4; // bit shuffle
+};
+
+/** the filter class for H5Zregister and for the plugin library */
+extern const H5Z_class2_t H5Z_SCTDC_DELTA[1];
+
+/**
+ * @brief RegisterH5ZDeltaFilter register the delta / zig-zag filter with the
+ * HDF5 library of this process (once)
+ * @return true on success
+ */
+bool RegisterH5ZDeltaFilter();
+
+/**
+ * @brief ResolvePreFilters replaces BITSHUFFLE by SHUFFLE, if the bit shuffle
+ * filter is not available to this process
+ */
+unsigned ResolvePreFilters(unsigned prefilters);
+
+/**
+ * @brief DeltaZigzagEncode replace each element by the difference to its
+ * predecessor (the first element by itself), mapping small negative
+ * differences to small unsigned numbers. src and dst may be identical.
+ * @param elsize element size in bytes, one of 1, 2, 4, 8
+ * @return false if elsize is not supported
+ */
+bool DeltaZigzagEncode(const void* src, void* dst, std::size_t nbytes,
+                       std::size_t elsize);
+
+/** @brief DeltaZigzagDecode inverse of DeltaZigzagEncode, in place */
+bool DeltaZigzagDecode(void* buf, std::size_t nbytes, std::size_t elsize);
+
+/**
+ * @brief ByteShuffle same transformation as the HDF5 shuffle filter: byte j
+ * of element i is moved to position j * nr_elements + i. src and dst must not
+ * overlap.
+ */
+void ByteShuffle(const void* src, void* dst, std::size_t nbytes,
+                 std::size_t elsize);
+
+#endif // HDF5PREFILTERS_HPP
@@ -0,0 +1,29 @@
+#ifndef SCTDC_HDF5_HDF5STATS_HPP
+#define SCTDC_HDF5_HDF5STATS_HPP
+
+/*
+ * Copyright (C) 2020 Surface Concept GmbH
+*/
+
+/** health counters of the writer, for the current or last activation */
+struct HDF5Stats {
+  unsigned long long events_received; // events passed to the writer
+  unsigned long long events_written;  // events written to the file
+  unsigned long long events_dropped;  // events dropped due to a full ring
+  unsigned long long bytes_written;   // data bytes passed to the file
+  double mbytes_per_s;     // write rate since the previous query (1e6 bytes/s)
+  unsigned ring_fill;      // full pages waiting for the writer
+  unsigned ring_highwater; // maximum of ring_fill
+  unsigned ring_pages;     // number of pages in the ring
+  double push_seconds;     // time of the USER_CALLBACKS thread in push
+  double max_append_ms;    // longest single write call to the file
+  bool file_error;         // writing has failed (raw capture mode)
+
+  HDF5Stats()
+    : events_received(0), events_written(0), events_dropped(0),
+      bytes_written(0), mbytes_per_s(0.0), ring_fill(0), ring_highwater(0),
+      ring_pages(0), push_seconds(0.0), max_append_ms(0.0),
+      file_error(false) {}
+};
+
+#endif // SCTDC_HDF5_HDF5STATS_HPP
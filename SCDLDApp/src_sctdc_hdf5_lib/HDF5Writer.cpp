@@ -34,11 +34,34 @@ const HDF5Config& HDF5Writer::config() const
   return p->config();
 }
 
+void HDF5Writer::setRateHint(double rate)
+{
+  p->setRateHint(rate);
+}
+
 bool HDF5Writer::fileError() const
 {
   return p->fileError();
 }
 
+void HDF5Writer::ringStats(
+  unsigned* fill, unsigned* highwater, unsigned long long* dropped) const
+{
+  p->ringStats(fill, highwater, dropped);
+}
+
+void HDF5Writer::markerStats(unsigned long long* pushed,
+  unsigned long long* dropped, unsigned long long* stalls,
+  unsigned long long* capacity) const
+{
+  p->markerStats(pushed, dropped, stalls, capacity);
+}
+
+void HDF5Writer::stats(HDF5Stats* s) const
+{
+  p->stats(s);
+}
+
 void HDF5Writer::devConnected(int devdesc)
 {
   p->devConnected(devdesc);
@@ -7,6 +7,7 @@
 
 #include <memory>
 #include "HDF5Config.hpp"
+#include "HDF5Stats.hpp"
 
 class HDF5WriterImpl; // forward declaration used in unique_ptr requires that a
 // destructor of HDF5Writer is defined in the cpp file (i.e. implicit destructor
@@ -58,11 +59,46 @@ public:
   const HDF5Config& config() const;
 
   /**
-   * @brief query error while opening file
+   * @brief setRateHint set the expected event rate for the automatic chunk
+   * size of the next activation, may be called from any thread, unlike
+   * setConfig
+   * @param rate events per second, <= 0 for none
+   */
+  void setRateHint(double rate);
+
+  /**
+   * @brief query error while opening or writing the file (writing errors are
+   * currently detected in raw capture mode)
    * @return true if error occurred
    */
   bool fileError() const;
 
+  /**
+   * @brief ringStats query the state of the event ring buffer
+   * @param fill number of full buffer pages waiting to be written
+   * @param highwater maximum number of full pages that were waiting
+   * @param dropped number of events dropped due to a full ring buffer
+   */
+  void ringStats(unsigned* fill, unsigned* highwater,
+                 unsigned long long* dropped) const;
+
+  /**
+   * @brief markerStats query the counters of the marker queue
+   * @param pushed number of markers accepted
+   * @param dropped number of markers lost (drop-oldest policy)
+   * @param stalls number of waits for a full queue (block policy)
+   * @param capacity current capacity of the queue
+   */
+  void markerStats(unsigned long long* pushed, unsigned long long* dropped,
+                   unsigned long long* stalls,
+                   unsigned long long* capacity) const;
+
+  /**
+   * @brief stats query the health counters of the writer
+   * @param s receives the counters
+   */
+  void stats(HDF5Stats* s) const;
+
 private:
   std::unique_ptr<HDF5WriterImpl> p;
 };
@@ -4,6 +4,9 @@
 #include "HDF5WriterImpl.hpp"
 //#include <iostream>
 #include "final_act.h"
+#include <cstdio>
+#include <cstring>
+#include <chrono>
 
 HDF5WriterImpl::HDF5WriterImpl()
   : UcbAdapter<HDF5WriterImpl>(this),
@@ -30,7 +33,11 @@ bool HDF5WriterImpl::setActive(bool active_arg)
   if (active_arg == is_active)
     return is_active;
   if (active_arg) {
-    hdf5_thread_.setConfig(cfg_);
+    try {
+      hdf5_thread_.setConfig(cfg_);
+    } catch (const std::bad_alloc&) {
+      return false;
+    }
     bool success1 = hdf5_thread_.start();
     if (!success1) {
       file_error_ = hdf5_thread_.fileError();
@@ -41,9 +48,11 @@ bool HDF5WriterImpl::setActive(bool active_arg)
       install(dev_desc); // install user callbacks pipe
   }
   else {
-    hdf5_thread_.stop();
+    // close the pipe first, such that no more events arrive while the
+    // thread writes the remaining data from the partially filled buffer page
     if (dev_desc > -1) // if deinitialized in the meantime, pipe already closed
       deinstall();
+    hdf5_thread_.stop();
   }
   active_.store(active_arg);
   return active_arg;
@@ -75,9 +84,47 @@ const HDF5Config& HDF5WriterImpl::config() const
   return cfg_;
 }
 
+void HDF5WriterImpl::setRateHint(double rate)
+{
+  hdf5_thread_.setRateHint(rate);
+}
+
 bool HDF5WriterImpl::fileError() const
 {
-  return file_error_;
+  // the thread also reports write errors during the streaming
+  return file_error_ || hdf5_thread_.fileError();
+}
+
+void HDF5WriterImpl::ringStats(
+  unsigned* fill, unsigned* highwater, unsigned long long* dropped) const
+{
+  hdf5_thread_.ringStats(fill, highwater, dropped);
+}
+
+void HDF5WriterImpl::stats(HDF5Stats* s) const
+{
+  hdf5_thread_.stats(s);
+  // write rate since the previous query, updated at most twice per second
+  std::lock_guard<std::mutex> lock(stats_mutex_);
+  const auto now = std::chrono::steady_clock::now();
+  const double dt = std::chrono::duration<double>(now - stats_time_).count();
+  if (s->bytes_written < stats_bytes_) { // new activation
+    stats_bytes_ = 0;
+    stats_rate_ = 0.0;
+  }
+  if (dt >= 0.5) {
+    stats_rate_ = 1e-6 * (s->bytes_written - stats_bytes_) / dt;
+    stats_bytes_ = s->bytes_written;
+    stats_time_ = now;
+  }
+  s->mbytes_per_s = stats_rate_;
+}
+
+void HDF5WriterImpl::markerStats(unsigned long long* pushed,
+  unsigned long long* dropped, unsigned long long* stalls,
+  unsigned long long* capacity) const
+{
+  hdf5_thread_.markerStats(pushed, dropped, stalls, capacity);
 }
 
 // -----------------------------------------------------------------------------
@@ -133,10 +180,16 @@ void HDF5WriterImplThread::stop()
     thread_->join();
   }
   thread_.reset();
+  // remember the event rate for the auto chunk size of the next activation
+  // (at least one second of measurement, to have a meaningful value)
+  if (ms_count_ >= 1000 && (dld_event_buf_ || raw_event_buf_)) {
+    measured_rate_ = static_cast<double>(events_pushed()) * 1000.0
+      / static_cast<double>(ms_count_);
+  }
   //std::cout << "HDF5WriterImplThread::stop() : finished" << std::endl;
 }
 
-bool HDF5WriterImplThread::fileError()
+bool HDF5WriterImplThread::fileError() const
 {
   return file_error_.load();
 }
@@ -146,7 +199,18 @@ void HDF5WriterImplThread::job_()
   //std::cout << "HDF5WriterImplThread::job_() : entered" << std::endl;
   auto clean_up1 = finally([this](){ threadExited_.store(true); });
   (void)clean_up1;
-  loc_.file.open(cfg_.base_path);
+  if (raw_event_buf_) {
+    job_raw_();
+    return;
+  }
+  seq_ = 0;
+  events_written_ = 0;
+  file_first_event_ = 0;
+  pending_markers_.clear();
+  part_names_.clear();
+  part_sizes_.clear();
+  chunk_size_ = chunk_size_for_run_();
+  job_open_file_(loc_.file, 0);
   if (!loc_.file.isOpen()) {
     file_error_.store(true);
     semThreadStarted_.signal();
@@ -158,9 +222,14 @@ void HDF5WriterImplThread::job_()
   file_error_.store(false);
   semThreadStarted_.signal();
 
-  job_write_attributes_();
-  job_add_datasets_();
-  dld_event_counter_ = 0u;
+  if (cfg_.codec != CompressionCodec::NONE) {
+    compressor_.reset(new ChunkCompressor(
+      cfg_.compress_threads, cfg_.codec, static_cast<int>(cfg_.pack_level)));
+  }
+  if (cfg_.rotation()) {
+    loc_.file.addRootAttrib("FirstEventIndex", 0ull);
+    file_start_ = std::chrono::steady_clock::now();
+  }
 
   // ---------------------------------------------------------------------------
   // data streaming part:
@@ -177,100 +246,577 @@ void HDF5WriterImplThread::job_()
   // write last remaining data from ring buffers, close file, -> end of thread
   job_process_last_dld_events_();
   job_process_special_events_(true);
-  loc_.file.closeDataSets();
-  loc_.file.close();
+  compressor_.reset();
+  job_close_file_();
+  if (cfg_.rotation()) {
+    if (loc_.next_file.isOpen()) { // the preopened file was not needed
+      loc_.next_file.closeDataSets();
+      loc_.next_file.close();
+      std::remove(part_path_(seq_ + 1).c_str());
+    }
+    if (cfg_.vds_master)
+      job_write_vds_master_();
+  }
 
   //std::cout << "HDF5WriterImplThread::job_() : exiting" << std::endl;
 }
 
-void HDF5WriterImplThread::job_write_attributes_()
+void HDF5WriterImplThread::job_open_file_(HDF5DataFile& f, unsigned seq)
+{
+  f.open(cfg_.rotation() ? part_path_(seq) : cfg_.base_path);
+  if (!f.isOpen())
+    return;
+  f.setLayout(chunk_size_, cfg_.codec, static_cast<int>(cfg_.pack_level),
+              cfg_.chunk_cache);
+  job_write_attributes_(f);
+  if (cfg_.rotation())
+    f.addRootAttrib("Sequence", static_cast<unsigned long long>(seq));
+  job_add_datasets_(f);
+  if (f.filterError()) {
+    // compressed chunks are written directly with a filter mask of 0, which
+    // would be unreadable if the pipeline of the dataset differs from them
+    f.closeDataSets();
+    f.close();
+    std::remove((cfg_.rotation() ? part_path_(seq) : cfg_.base_path).c_str());
+  }
+}
+
+void HDF5WriterImplThread::job_close_file_()
+{
+  if (cfg_.rotation() && cfg_.vds_master) {
+    std::vector<unsigned long long> sizes(HDF5EventBuf::NR_OF_BUFS + 2, 0);
+    for (std::size_t i = 0; i < HDF5EventBuf::NR_OF_BUFS; i++) {
+      if (cfg_.datasel.value & dld_event_buf_->maskFromBufId(i))
+        sizes[i] = loc_.file.dataSetSize(DS_dld[i]);
+    }
+    sizes[HDF5EventBuf::NR_OF_BUFS] = loc_.file.dataSetSize(DS_msMarkers);
+    sizes[HDF5EventBuf::NR_OF_BUFS + 1] =
+      loc_.file.dataSetSize(DS_startMarkers);
+    const std::string path = part_path_(seq_);
+    const std::size_t slash = path.find_last_of("/\\");
+    part_names_.push_back(
+      (slash == std::string::npos) ? path : path.substr(slash + 1));
+    part_sizes_.push_back(sizes);
+  }
+  loc_.file.closeDataSets();
+  loc_.file.close();
+}
+
+void HDF5WriterImplThread::job_write_attributes_(HDF5DataFile& f)
 {
   if (cfg_.user_comment.size()==0)
     cfg_.user_comment = "(empty)";
-  loc_.file.addRootAttrib("UserComment", cfg_.user_comment);
-  loc_.file.addRootAttrib("Description",
+  f.addRootAttrib("UserComment", cfg_.user_comment);
+  f.addRootAttrib("Description",
     std::string("DLD Detector data"));
+  if (cfg_.delta_sel.value & cfg_.datasel.value) {
+    // stock readers (h5py, h5dump, hdf5plugin) do not know our filter, make
+    // the file tell them what is missing
+    f.addRootAttrib("RequiredFilterPlugins", std::string(
+      "sctdc_h5zdelta (filter 305, delta / zig-zag encoding), "
+      "to be placed in a directory listed in HDF5_PLUGIN_PATH"));
+  }
 }
 
-void HDF5WriterImplThread::job_add_datasets_()
+void HDF5WriterImplThread::job_add_datasets_(HDF5DataFile& f)
 {
   HDF5EventBuf& eb = *dld_event_buf_;
   for (std::size_t i = 0; i < eb.NR_OF_BUFS; i++) {
-    if (cfg_.datasel.value & eb.maskFromBufId(i)) {
-      DS_dld[i] = loc_.file.addDataSetRaw(eb.get_name(i), eb.get_h5_type(i));
+    const EventDataFieldSelection::type m = eb.maskFromBufId(i);
+    unsigned pf = 0;
+    if (cfg_.delta_sel.value & m)
+      pf |= PreFilter::DELTA;
+    if (cfg_.shuffle_sel.value & m)
+      pf |= PreFilter::SHUFFLE;
+    if (cfg_.bitshuffle_sel.value & m)
+      pf |= PreFilter::BITSHUFFLE;
+    prefilters_[i] = ResolvePreFilters(pf);
+    if (cfg_.datasel.value & m) {
+      DS_dld[i] = f.addDataSetRaw(
+        eb.get_name(i), eb.get_h5_type(i), 0, prefilters_[i]);
     }
     else
       DS_dld[i] = 0xFFFFFFFFFFFFFFFFull;
   }
-  DS_msMarkers = loc_.file.addDataSet<unsigned long long>("msMarkers");
-  DS_startMarkers = loc_.file.addDataSet<unsigned long long>("startMarkers");
+  // marker datasets grow slowly, keep their chunks small
+  DS_msMarkers = f.addDataSet<unsigned long long>(
+    "msMarkers", loc_.BUFSIZE);
+  DS_startMarkers = f.addDataSet<unsigned long long>(
+    "startMarkers", loc_.BUFSIZE);
+}
+
+unsigned long long HDF5WriterImplThread::chunk_size_for_run_() const
+{
+  const unsigned long long page = dld_event_buf_->size();
+  unsigned long long c = cfg_.chunk_size;
+  if (c == 0) {
+    const double hint = rate_hint_.load(std::memory_order_relaxed);
+    const double rate = (hint > 0.0) ? hint
+      : ((cfg_.rate_hint > 0.0) ? cfg_.rate_hint : measured_rate_);
+    if (rate <= 0.0 || page <= MIN_AUTO_CHUNK) {
+      c = page;
+    }
+    else {
+      // largest power of two not exceeding the target, within the bounds
+      const double target = rate * AUTO_CHUNK_SECONDS;
+      c = MIN_AUTO_CHUNK;
+      while (c * 2 <= target && c * 2 <= page)
+        c *= 2;
+    }
+  }
+  // with compression, buffer pages are split into whole chunks
+  if (cfg_.codec != CompressionCodec::NONE && page % c != 0)
+    c = page;
+  return c;
+}
+
+
+
+void HDF5WriterImplThread::ringStats(
+  unsigned* fill, unsigned* highwater, unsigned long long* dropped) const
+{
+  std::lock_guard<std::mutex> lock(bufs_mutex_);
+  ringStats_(fill, highwater, dropped);
+}
+
+void HDF5WriterImplThread::ringStats_(
+  unsigned* fill, unsigned* highwater, unsigned long long* dropped) const
+{
+  if (raw_event_buf_) {
+    *fill = raw_event_buf_->fill_level();
+    *highwater = raw_event_buf_->high_water_mark();
+    *dropped = raw_event_buf_->dropped_events();
+    return;
+  }
+  if (!dld_event_buf_) {
+    *fill = 0;
+    *highwater = 0;
+    *dropped = 0;
+    return;
+  }
+  *fill = dld_event_buf_->fill_level();
+  *highwater = dld_event_buf_->high_water_mark();
+  *dropped = dld_event_buf_->dropped_events();
 }
 
+void HDF5WriterImplThread::stats(HDF5Stats* s) const
+{
+  std::lock_guard<std::mutex> lock(bufs_mutex_);
+  ringStats_(&s->ring_fill, &s->ring_highwater, &s->events_dropped);
+  s->ring_pages = raw_event_buf_ ? raw_event_buf_->nr_pages()
+                : (dld_event_buf_ ? dld_event_buf_->nr_pages() : 0);
+  // (events_pushed is updated by the producer, read here without ordering)
+  s->events_received = s->events_dropped +
+    ((dld_event_buf_ || raw_event_buf_) ? events_pushed() : 0);
+  s->events_written = events_written_.load(std::memory_order_relaxed);
+  s->bytes_written = bytes_written_.load(std::memory_order_relaxed);
+  s->push_seconds = 1e-9 * push_ns_.load(std::memory_order_relaxed);
+  s->max_append_ms = 1e-6 * max_append_ns_.load(std::memory_order_relaxed);
+  s->file_error = file_error_.load();
+}
 
+void HDF5WriterImplThread::markerStats(unsigned long long* pushed,
+  unsigned long long* dropped, unsigned long long* stalls,
+  unsigned long long* capacity) const
+{
+  std::lock_guard<std::mutex> lock(bufs_mutex_);
+  if (!special_event_buf_) {
+    *pushed = 0;
+    *dropped = 0;
+    *stalls = 0;
+    *capacity = 0;
+    return;
+  }
+  *pushed = special_event_buf_->pushed();
+  *dropped = special_event_buf_->dropped();
+  *stalls = marker_stalls_.load(std::memory_order_relaxed);
+  *capacity = special_event_buf_->capacity();
+}
 
 void HDF5WriterImplThread::job_process_dld_events_()
 {
-  // don't lock mutex here
+  // drain all full pages that are available at this point
   std::size_t s = dld_event_buf_->size();
-  for (std::size_t buf_id = 0; buf_id < dld_event_buf_->NR_OF_BUFS; buf_id++)
-  {
-    void* b = dld_event_buf_->get_buf(buf_id);
-    if (b)
-      loc_.file.appendToDataSetRaw(
-        DS_dld[buf_id], b, s, dld_event_buf_->get_h5_type(buf_id));
+  while (dld_event_buf_->has_data_page()) {
+    void* bufs[HDF5EventBuf::NR_OF_BUFS];
+    for (unsigned buf_id = 0; buf_id < HDF5EventBuf::NR_OF_BUFS; buf_id++) {
+      void* b = dld_event_buf_->get_buf(buf_id);
+      bufs[buf_id] = direct_chunks_(buf_id) ? b : nullptr;
+      if (b && !direct_chunks_(buf_id)) {
+        const auto t0 = std::chrono::steady_clock::now();
+        loc_.file.appendToDataSetRaw(
+          DS_dld[buf_id], b, s, dld_event_buf_->get_h5_type(buf_id));
+        job_note_write_(t0, s * dld_event_buf_->element_size(buf_id));
+      }
+    }
+    if (compressor_)
+      job_write_compressed_(bufs, s);
+    dld_event_buf_->release_page();
+    events_written_ += s;
+    // files are switched at page boundaries, the producer is not affected
+    if (cfg_.rotation()) {
+      if (job_rotation_due_(1.0))
+        job_rotate_();
+      else if (!loc_.next_file.isOpen() && job_rotation_due_(0.5))
+        job_open_file_(loc_.next_file, seq_ + 1); // retried if this fails
+    }
   }
-  dld_event_buf_->release_page();
 }
 
 void HDF5WriterImplThread::job_process_last_dld_events_()
 {
-  std::unique_lock<std::mutex> lock(dld_event_buf_->mutex());
+  // the producer has stopped at this point (USER_CALLBACKS pipe is closed)
+  job_process_dld_events_();
   void* b;
-  std::size_t len;
-  for (std::size_t buf_id = 0; buf_id < dld_event_buf_->NR_OF_BUFS; buf_id++)
-  {
-    dld_event_buf_->get_partial_buf(buf_id, &b, &len);
+  std::size_t l;
+  std::size_t len = 0; // (the same for all selected data fields)
+  void* bufs[HDF5EventBuf::NR_OF_BUFS];
+  for (unsigned buf_id = 0; buf_id < HDF5EventBuf::NR_OF_BUFS; buf_id++) {
+    dld_event_buf_->get_partial_buf(buf_id, &b, &l);
     if (b)
+      len = l;
+    bufs[buf_id] = direct_chunks_(buf_id) ? b : nullptr;
+    if (b && !direct_chunks_(buf_id)) {
+      const auto t0 = std::chrono::steady_clock::now();
       loc_.file.appendToDataSetRaw(
-        DS_dld[buf_id], b, len, dld_event_buf_->get_h5_type(buf_id));
+        DS_dld[buf_id], b, l, dld_event_buf_->get_h5_type(buf_id));
+      job_note_write_(t0, l * dld_event_buf_->element_size(buf_id));
+    }
   }
+  if (compressor_ && len > 0)
+    job_write_compressed_(bufs, len);
   dld_event_buf_->release_partial_page();
+  events_written_ += len;
+}
+
+void HDF5WriterImplThread::job_write_compressed_(
+  void* const* bufs, std::size_t len)
+{
+  // compress all chunks of all selected data fields of one buffer page in
+  // parallel, then commit them in order by direct chunk writes (writing of
+  // the first chunks overlaps with compression of the later ones)
+  typedef ChunkCompressor::Job Job;
+  const std::size_t chunk = static_cast<std::size_t>(chunk_size_);
+  const std::size_t nchunks = (len + chunk - 1) / chunk;
+  std::size_t njobs = 0;
+  for (unsigned i = 0; i < HDF5EventBuf::NR_OF_BUFS; i++) {
+    if (bufs[i])
+      njobs += nchunks;
+  }
+  if (jobs_.size() < njobs) { // resize before taking pointers to the jobs
+    jobs_.resize(njobs);
+    job_buf_ids_.resize(njobs);
+  }
+  std::size_t k = 0;
+  for (unsigned buf_id = 0; buf_id < HDF5EventBuf::NR_OF_BUFS; buf_id++) {
+    if (!bufs[buf_id])
+      continue;
+    const std::size_t elsize = dld_event_buf_->element_size(buf_id);
+    char* b = static_cast<char*>(bufs[buf_id]);
+    // the last chunk of a partial page is zero-padded to the full chunk size
+    // (the page has room for it, since chunks divide the page size)
+    if (len < nchunks * chunk)
+      memset(b + len * elsize, 0, (nchunks * chunk - len) * elsize);
+    for (std::size_t c = 0; c < nchunks; c++) {
+      Job& j = jobs_[k];
+      j.src = b + c * chunk * elsize;
+      j.nbytes = chunk * elsize;
+      j.elsize = elsize;
+      j.prefilters = prefilters_[buf_id];
+      job_buf_ids_[k] = buf_id;
+      compressor_->submit(&j);
+      k++;
+    }
+  }
+  for (k = 0; k < njobs; k++) {
+    Job& j = jobs_[k];
+    compressor_->wait(&j);
+    const std::size_t c = k % nchunks;
+    const std::size_t elements = (len - c * chunk < chunk) ? len - c * chunk
+                                                           : chunk;
+    // if not compressed, the filter mask marks the codec (the last filter
+    // after the pre-filters) as skipped for this chunk
+    unsigned codec_idx = 0;
+    if (j.prefilters & PreFilter::DELTA)
+      codec_idx++;
+    if (j.prefilters & PreFilter::SHUFFLE)
+      codec_idx++;
+    const auto t0 = std::chrono::steady_clock::now();
+    loc_.file.appendChunkRaw(DS_dld[job_buf_ids_[k]], j.stored, j.outlen,
+      elements, j.compressed ? 0 : (1u << codec_idx));
+    job_note_write_(t0, j.outlen);
+  }
+}
+
+void HDF5WriterImplThread::job_note_write_(
+  std::chrono::steady_clock::time_point t0, unsigned long long nbytes)
+{
+  const unsigned long long ns = static_cast<unsigned long long>(
+    std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now() - t0).count());
+  if (ns > max_append_ns_.load(std::memory_order_relaxed))
+    max_append_ns_.store(ns, std::memory_order_relaxed);
+  bytes_written_.store(bytes_written_.load(std::memory_order_relaxed) + nbytes,
+                       std::memory_order_relaxed);
 }
 
 
 void HDF5WriterImplThread::job_process_special_events_(bool force)
 {
-  std::size_t thresh = (force) ? 0 : loc_.BUFSIZE;
-  special_event_buf_.consume_at_least(
-    thresh, [this](SpecialEvent *e, std::size_t len)
+  job_consume_special_events_((force) ? 0 : special_thresh_);
+  // with rotation, markers at or beyond the written events may still belong
+  // to the next file
+  if (force || !cfg_.rotation())
+    job_write_markers_(~0ull);
+  else
+    job_write_markers_(events_written_);
+}
+
+void HDF5WriterImplThread::job_consume_special_events_(std::size_t thresh)
+{
+  if (special_event_buf_->size() < thresh)
+    return;
+  marker_batch_.resize(loc_.BUFSIZE);
+  std::size_t len;
+  while ((len = special_event_buf_->pop(marker_batch_.data(),
+                                        marker_batch_.size())) > 0)
+  {
+    pending_markers_.insert(pending_markers_.end(), marker_batch_.begin(),
+                            marker_batch_.begin() + len);
+  }
+}
+
+void HDF5WriterImplThread::job_write_markers_(unsigned long long limit)
+{
+  // write the pending markers with eventidx < limit (markers are ordered by
+  // eventidx), in batches of up to loc_.BUFSIZE
+  while (!pending_markers_.empty() &&
+         pending_markers_.front().eventidx < limit)
+  {
+    std::size_t jms = 0;
+    std::size_t jsom = 0;
+    while (!pending_markers_.empty() && jms < loc_.BUFSIZE &&
+           jsom < loc_.BUFSIZE && pending_markers_.front().eventidx < limit)
     {
-      //
-      std::size_t lenleft = len;
-      std::size_t k = 0;
-      while (lenleft > 0) {
-        std::size_t jms = 0;
-        std::size_t jsom = 0;
-        std::size_t len1 = lenleft;
-        if (len1 > loc_.BUFSIZE) len1 = loc_.BUFSIZE;
-        for (std::size_t i = 0; i < len1; i++) {
-          if (e[k].type == SpecialEvent::TYPE_DLD_MILLISEC) {
-            loc_.buf_ms[jms++] = e[k].eventidx;
-          }
-          else if (e[k].type == SpecialEvent::TYPE_DLD_STARTMEAS) {
-            loc_.buf_start[jsom++] = e[k].eventidx;
-            //std::cout << "Start of meas encountered" << std::endl;
-          }
-          k++;
-        }
-        if (jms > 0) {
-          loc_.file.appendToDataSet(DS_msMarkers, loc_.buf_ms.data(), jms);
-          //std::cout << "appending " << jms << " ms markers" << std::endl;
-        }
-        if (jsom > 0)
-          loc_.file.appendToDataSet(
-                DS_startMarkers, loc_.buf_start.data(), jsom);
-        lenleft = lenleft - len1;
+      const SpecialEvent& e = pending_markers_.front();
+      if (e.type == SpecialEvent::TYPE_DLD_MILLISEC)
+        loc_.buf_ms[jms++] = e.eventidx;
+      else if (e.type == SpecialEvent::TYPE_DLD_STARTMEAS)
+        loc_.buf_start[jsom++] = e.eventidx;
+      pending_markers_.pop_front();
+    }
+    const auto t0 = std::chrono::steady_clock::now();
+    if (jms > 0)
+      loc_.file.appendToDataSet(DS_msMarkers, loc_.buf_ms.data(), jms);
+    if (jsom > 0)
+      loc_.file.appendToDataSet(DS_startMarkers, loc_.buf_start.data(), jsom);
+    job_note_write_(t0, (jms + jsom) * sizeof(unsigned long long));
+  }
+}
+
+// -----------------------------------------------------------------------------
+// ---                    file rotation                                      ---
+// -----------------------------------------------------------------------------
+
+std::string HDF5WriterImplThread::part_path_(unsigned seq) const
+{
+  // <stem>_NNNNN<ext>
+  const std::string& p = cfg_.base_path;
+  const std::size_t slash = p.find_last_of("/\\");
+  std::size_t dot = p.rfind('.');
+  if (dot == std::string::npos || (slash != std::string::npos && dot < slash))
+    dot = p.size();
+  char num[16];
+  snprintf(num, sizeof(num), "_%05u", seq);
+  return p.substr(0, dot) + num + p.substr(dot);
+}
+
+bool HDF5WriterImplThread::job_rotation_due_(double fraction) const
+{
+  if (cfg_.rotate_events > 0 &&
+      events_written_ - file_first_event_ >= fraction * cfg_.rotate_events)
+    return true;
+  if (cfg_.rotate_bytes > 0 &&
+      loc_.file.fileSize() >= fraction * cfg_.rotate_bytes)
+    return true;
+  if (cfg_.rotate_seconds > 0.0) {
+    std::chrono::duration<double> t =
+      std::chrono::steady_clock::now() - file_start_;
+    if (t.count() >= fraction * cfg_.rotate_seconds)
+      return true;
+  }
+  return false;
+}
+
+void HDF5WriterImplThread::job_rotate_()
+{
+  // the next file is normally preopened when the current one is half full,
+  // such that switching only closes the current file
+  if (!loc_.next_file.isOpen()) {
+    job_open_file_(loc_.next_file, seq_ + 1);
+    if (!loc_.next_file.isOpen())
+      return; // stay with the current file, retry after the next page
+  }
+  // markers before the first event of the next file belong to this file
+  job_consume_special_events_(0);
+  job_write_markers_(events_written_);
+  job_close_file_();
+  loc_.file.swap(loc_.next_file);
+  seq_++;
+  file_first_event_ = events_written_;
+  file_start_ = std::chrono::steady_clock::now();
+  loc_.file.addRootAttrib("FirstEventIndex", file_first_event_);
+}
+
+void HDF5WriterImplThread::job_write_vds_master_()
+{
+  HDF5DataFile master;
+  master.open(cfg_.base_path);
+  if (!master.isOpen())
+    return;
+  job_write_attributes_(master);
+  master.addRootAttrib("NrOfFiles",
+    static_cast<unsigned long long>(part_names_.size()));
+  std::vector<unsigned long long> sizes(part_sizes_.size());
+  HDF5EventBuf& eb = *dld_event_buf_;
+  for (std::size_t i = 0; i < HDF5EventBuf::NR_OF_BUFS + 2; i++) {
+    if (i < HDF5EventBuf::NR_OF_BUFS && !(cfg_.datasel.value &
+                                          eb.maskFromBufId(i)))
+      continue;
+    for (std::size_t k = 0; k < part_sizes_.size(); k++)
+      sizes[k] = part_sizes_[k][i];
+    if (i < HDF5EventBuf::NR_OF_BUFS)
+      master.addVirtualDataSet(eb.get_name(i), eb.get_h5_type(i),
+                               part_names_, sizes);
+    else
+      master.addVirtualDataSet(
+        (i == HDF5EventBuf::NR_OF_BUFS) ? "msMarkers" : "startMarkers",
+        H5T_NATIVE_UINT64, part_names_, sizes);
+  }
+  master.close();
+}
+
+// -----------------------------------------------------------------------------
+// ---                    raw capture mode                                   ---
+// -----------------------------------------------------------------------------
+
+void HDF5WriterImplThread::job_raw_()
+{
+  raw_file_.open(cfg_.base_path + ".raw", cfg_.raw_prealloc,
+                 cfg_.datasel.value, cfg_.user_comment);
+  if (!raw_file_.isOpen()) {
+    file_error_.store(true);
+    semThreadStarted_.signal();
+    while (!abortRequest_.load()) {
+      std::this_thread::yield();
+    }
+    return;
+  }
+  file_error_.store(false);
+  semThreadStarted_.signal();
+
+  while(!abortRequest_.load()) {
+    while (!raw_event_buf_->has_data_page() && !special_events_thresh_exc() &&
+      !abortRequest_.load())
+    {
+      semWakeUp_.wait();
+    }
+    job_process_raw_events_();
+    job_process_raw_special_events_(false);
+  }
+  // the producer has stopped at this point (USER_CALLBACKS pipe is closed)
+  job_process_raw_events_();
+  std::size_t len;
+  sc_DldEvent* e = raw_event_buf_->get_partial_page(&len);
+  if (e && len > 0 && !file_error_.load()) {
+    const auto t0 = std::chrono::steady_clock::now();
+    if (raw_file_.write(e, len, raw_event_buf_->page_bytes())) {
+      job_note_write_(t0, len * sizeof(sc_DldEvent));
+      events_written_ += len;
+    }
+    else
+      file_error_.store(true);
+  }
+  raw_event_buf_->release_partial_page();
+  job_process_raw_special_events_(true);
+  raw_file_.close();
+}
+
+void HDF5WriterImplThread::job_process_raw_events_()
+{
+  while (raw_event_buf_->has_data_page()) {
+    // after a write error (e.g. disk full), the pages are only released,
+    // such that the producer is not blocked
+    if (!file_error_.load()) {
+      const auto t0 = std::chrono::steady_clock::now();
+      if (raw_file_.write(raw_event_buf_->get_page(), raw_event_buf_->size(),
+                          raw_event_buf_->page_bytes()))
+      {
+        job_note_write_(t0, raw_event_buf_->page_bytes());
+        events_written_ += raw_event_buf_->size();
       }
-      return len;
-    });
+      else
+        file_error_.store(true);
+    }
+    raw_event_buf_->release_page();
+  }
+}
+
+void HDF5WriterImplThread::job_process_raw_special_events_(bool force)
+{
+  if (!force && special_event_buf_->size() < special_thresh_)
+    return;
+  marker_batch_.resize(loc_.BUFSIZE);
+  std::size_t len;
+  while ((len = special_event_buf_->pop(marker_batch_.data(),
+                                        marker_batch_.size())) > 0)
+  {
+    for (std::size_t i = 0; i < len; i++)
+      raw_file_.appendMarker(marker_batch_[i].eventidx, marker_batch_[i].type);
+  }
+}
+
+void HDF5WriterImplThread::push_wait(const sc_DldEvent * const e, size_t len)
+{
+  HDF5EventBuf& eb = *dld_event_buf_;
+  std::size_t k = 0;
+  while (k < len) {
+    // at most one page per push, and only if a page beyond the one that this
+    // push may complete is free, such that push never drops events
+    std::size_t n = len - k;
+    if (n > eb.size())
+      n = eb.size();
+    while (eb.fill_level() + 2 > eb.nr_pages()) {
+      semWakeUp_.signal();
+      std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+    push(e + k, n);
+    k += n;
+  }
+}
+
+void HDF5WriterImplThread::push_marker_wait(unsigned type)
+{
+  // the writer thread drains the marker queue once it holds special_thresh_
+  // markers, which is the case while we wait here
+  while (special_event_buf_->size() >= special_thresh_) {
+    semWakeUp_.signal();
+    std::this_thread::sleep_for(std::chrono::microseconds(100));
+  }
+  if (type == SpecialEvent::TYPE_DLD_MILLISEC)
+    push_millisecond();
+  else if (type == SpecialEvent::TYPE_DLD_STARTMEAS)
+    push_start_of_meas();
+}
+
+void HDF5WriterImplThread::push_special_event_blocking_(const SpecialEvent& e)
+{
+  // MarkerOverflow::BLOCK and the queue is full: wait until the writer thread
+  // has taken markers (it is woken up, since the queue exceeds the threshold)
+  marker_stalls_.store(marker_stalls_.load(std::memory_order_relaxed) + 1,
+                       std::memory_order_relaxed);
+  do {
+    semWakeUp_.signal();
+    std::this_thread::yield();
+  } while (!special_event_buf_->push(e));
 }
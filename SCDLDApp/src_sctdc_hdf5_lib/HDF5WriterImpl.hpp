@@ -6,29 +6,29 @@
 */
 
 #include <atomic>
+#include <chrono>
+#include <deque>
+#include <mutex>
 #include <string>
 #include <vector>
 #include <memory>
 #include <thread>
 #include "HDF5DataFile.hpp"
 #include "HDF5Config.hpp"
+#include "HDF5Stats.hpp"
 #include "HDF5EventBuf.hpp"
+#include "RawEventBuf.hpp"
+#include "RawCaptureFile.hpp"
 #include "UcbAdapter.hpp"
-#include "CircularBuf.hpp"
+#include "MarkerRing.hpp"
+#include "ChunkCompressor.hpp"
+#include "HDF5PreFilters.hpp"
+#include "HDF5Codecs.hpp"
 #include "ThirdParty/sema.h"
 //#include <iostream>
 
 //------------------------------------------------------------------------------
 
-struct SpecialEvent {
-  static const unsigned TYPE_NONE = 0;
-  static const unsigned TYPE_DLD_MILLISEC = 0x10;
-  static const unsigned TYPE_DLD_STARTMEAS = 0x11;
-  static const unsigned TYPE_DLD_ENDMEAS = 0x12;
-  unsigned long long eventidx;
-  unsigned type;
-};
-
 struct HDF5WriterImplThreadLocal {
   static const std::size_t BUFSIZE = 50000;
   std::vector<unsigned short> bufx;
@@ -37,6 +37,7 @@ struct HDF5WriterImplThreadLocal {
   std::vector<unsigned long long> buf_ms;
   std::vector<unsigned long long> buf_start;
   HDF5DataFile file;
+  HDF5DataFile next_file; // file rotation: the preopened next file
   HDF5WriterImplThreadLocal();
 };
 
@@ -44,7 +45,10 @@ struct HDF5WriterImplThreadLocal {
 class HDF5WriterImplThread
 {
   static const size_t DLD_EVENT_BUF_SIZE = 1<<20; // in number of elements
-  static const size_t SPECIAL_EVENT_BUF_SIZE = 1<<16; // in number of elements
+  // auto chunk size: one chunk holds the events of this many seconds, but
+  // at least MIN_AUTO_CHUNK and at most one buffer page
+  static constexpr double AUTO_CHUNK_SECONDS = 0.1;
+  static const unsigned long long MIN_AUTO_CHUNK = 1<<14;
   //std::string basepath_;
   std::unique_ptr<std::thread> thread_;
   Semaphore semThreadStarted_;
@@ -53,74 +57,218 @@ class HDF5WriterImplThread
   std::atomic_bool threadExited_;
   std::atomic_bool fileError_;
   std::unique_ptr<HDF5EventBuf> dld_event_buf_;
-  CircularBuf<SpecialEvent> special_event_buf_{SPECIAL_EVENT_BUF_SIZE};
+  std::unique_ptr<RawEventBuf> raw_event_buf_; // replaces dld_event_buf_ in
+                                               // the raw capture mode
+  RawCaptureFile raw_file_;
+  std::unique_ptr<MarkerRing> special_event_buf_;
+  // held while the buffers above are replaced (setConfig) and while the
+  // statistics are read from them (by any thread)
+  mutable std::mutex bufs_mutex_;
   HDF5WriterImplThreadLocal loc_;
   HDF5Config cfg_;
   std::atomic_bool file_error_;
 
-  //std::size_t dld_thresh_counter_ = 0;
-  std::size_t dld_event_counter_ = 0;
   std::size_t special_thresh_counter_ = 0;
+  // the writer thread takes the markers from special_event_buf_ once this
+  // many are waiting (or when a file is switched or closed)
+  std::size_t special_thresh_ = HDF5WriterImplThreadLocal::BUFSIZE;
+  std::atomic<unsigned long long> marker_stalls_{0}; // waits of the producer
+  std::vector<SpecialEvent> marker_batch_; // for special_event_buf_->pop
+  // health counters (see HDF5Stats)
+  std::atomic<unsigned long long> push_ns_{0}; // producer only
+  std::atomic<unsigned long long> bytes_written_{0}; // writer only
+  std::atomic<unsigned long long> max_append_ns_{0}; // writer only
+  unsigned long long ms_count_ = 0; // millisecond markers of this activation
+  unsigned long long chunk_size_ = 0; // chunk size of the current file
+  // ----------
+  // compression stage, only used if cfg_.codec is not NONE
+  std::unique_ptr<ChunkCompressor> compressor_;
+  std::vector<ChunkCompressor::Job> jobs_;
+  std::vector<std::size_t> job_buf_ids_; // data field of each job
+  double measured_rate_ = 0.0; // event rate of the last activation (events/s)
+  // expected event rate (events/s), set by any thread at any time, so not a
+  // part of cfg_; takes precedence over cfg_.rate_hint
+  std::atomic<double> rate_hint_{0.0};
+  // ----------
+  // file rotation, only used if cfg_.rotation()
+  unsigned seq_ = 0; // sequence number of the current file
+  std::atomic<unsigned long long> events_written_{0}; // in this activation
+  unsigned long long file_first_event_ = 0; // first event of the current file
+  std::chrono::steady_clock::time_point file_start_;
+  // markers taken from special_event_buf_, but not yet written (with
+  // rotation, a marker is written once the file of its event is known)
+  std::deque<SpecialEvent> pending_markers_;
+  std::vector<std::string> part_names_; // closed files, for the VDS master
+  // number of elements per closed file: the event datasets by buffer id,
+  // followed by the ms markers and the start markers
+  std::vector<std::vector<unsigned long long>> part_sizes_;
   // ----------
   std::size_t DS_msMarkers;
   std::size_t DS_startMarkers;
   std::size_t DS_dld[HDF5EventBuf::NR_OF_BUFS];
+  unsigned prefilters_[HDF5EventBuf::NR_OF_BUFS]; // PreFilter flags per field
 
 public:
-  //static const size_t DLD_NOTIF_THR = 50000; //DLD_EVENT_BUF_SIZE/128;
-  static const size_t SPECIAL_NOTIF_THR = 50000; //SPECIAL_EVENT_BUF_SIZE/128;
-
   HDF5WriterImplThread() {}
   bool start();
   void stop();
-  bool fileError();
+  bool fileError() const;
   void push(const sc_DldEvent * const e, size_t len) {
-    if (dld_event_buf_->push(e, len)) {
+    const auto t0 = std::chrono::steady_clock::now();
+    bool page_full = raw_event_buf_ ? raw_event_buf_->push(e, len)
+                                    : dld_event_buf_->push(e, len);
+    if (page_full)
       semWakeUp_.signal();
-    }
-    dld_event_counter_ += len;
+    push_ns_.store(push_ns_.load(std::memory_order_relaxed) +
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - t0).count(),
+      std::memory_order_relaxed);
   }
 
   void push_millisecond() {
-    push_special_event(SpecialEvent::TYPE_DLD_MILLISEC, dld_event_counter_);
+    ms_count_++;
+    push_special_event(SpecialEvent::TYPE_DLD_MILLISEC, events_pushed());
   }
 
   void push_start_of_meas() {
-    push_special_event(SpecialEvent::TYPE_DLD_STARTMEAS, dld_event_counter_);
+    push_special_event(SpecialEvent::TYPE_DLD_STARTMEAS, events_pushed());
+  }
+
+  /**
+   * @brief push_wait same as push, but waits for free buffer pages instead
+   * of dropping events. For the offline conversion of raw captures, must not
+   * be used in the USER_CALLBACKS thread.
+   */
+  void push_wait(const sc_DldEvent * const e, size_t len);
+
+  /**
+   * @brief push_marker_wait same as push_millisecond / push_start_of_meas
+   * (depending on type), but waits for free space in the marker buffer
+   */
+  void push_marker_wait(unsigned type);
+
+  /** number of events accepted so far in this activation */
+  unsigned long long events_pushed() const {
+    return raw_event_buf_ ? raw_event_buf_->events_pushed()
+                          : dld_event_buf_->events_pushed();
   }
 
+  /**
+   * @brief setConfig may throw std::bad_alloc if the event buffer pages
+   * cannot be allocated
+   */
   void setConfig(const HDF5Config& c) {
     cfg_ = c;
-    HDF5EventBufConfig ebc(c.datasel, 50000);
-    dld_event_buf_.reset(new HDF5EventBuf(ebc));
+    ms_count_ = 0;
+    std::lock_guard<std::mutex> lock(bufs_mutex_);
+    dld_event_buf_.reset();
+    raw_event_buf_.reset();
+    special_event_buf_.reset();
+    if (c.raw_capture) {
+      raw_event_buf_.reset(new RawEventBuf(c.page_size, c.nr_bufpages));
+    }
+    else {
+      HDF5EventBufConfig ebc(c.datasel, c.page_size, c.nr_bufpages);
+      dld_event_buf_.reset(new HDF5EventBuf(ebc));
+    }
+    special_event_buf_.reset(
+      new MarkerRing(c.marker_queue_size, c.marker_overflow));
+    special_thresh_ = static_cast<std::size_t>(
+      special_event_buf_->capacity() / 2);
+    if (special_thresh_ > loc_.BUFSIZE)
+      special_thresh_ = loc_.BUFSIZE;
+    special_thresh_counter_ = 0;
+    marker_stalls_.store(0);
+    events_written_.store(0);
+    push_ns_.store(0);
+    bytes_written_.store(0);
+    max_append_ns_.store(0);
   }
 
+  /**
+   * @brief ringStats query fill level, high-water mark (both in pages) and
+   * the number of events dropped due to a full ring buffer
+   */
+  void ringStats(unsigned* fill, unsigned* highwater,
+                 unsigned long long* dropped) const;
+
+  /**
+   * @brief markerStats query the counters of the marker queue: markers
+   * accepted, markers lost (MarkerOverflow::DROP_OLDEST or failed allocation),
+   * waits of the producer for a full queue (MarkerOverflow::BLOCK) and the
+   * current capacity (grows with MarkerOverflow::GROW)
+   */
+  void markerStats(unsigned long long* pushed, unsigned long long* dropped,
+                   unsigned long long* stalls,
+                   unsigned long long* capacity) const;
+
+  /**
+   * @brief stats query the health counters, except mbytes_per_s (which
+   * depends on the time of the previous query, see HDF5WriterImpl::stats)
+   */
+  void stats(HDF5Stats* s) const;
+
   const HDF5Config& config() const {
     return cfg_;
   }
 
+  /** used for the auto chunk size of the next activation */
+  void setRateHint(double rate) {
+    rate_hint_.store(rate, std::memory_order_relaxed);
+  }
+
 private:
+  // ringStats without bufs_mutex_
+  void ringStats_(unsigned* fill, unsigned* highwater,
+                  unsigned long long* dropped) const;
   void job_();
-  void job_write_attributes_();
-  void job_add_datasets_();
+  void job_open_file_(HDF5DataFile& f, unsigned seq);
+  void job_close_file_();
+  void job_write_attributes_(HDF5DataFile& f);
+  void job_add_datasets_(HDF5DataFile& f);
+  unsigned long long chunk_size_for_run_() const;
   void job_process_dld_events_();
   void job_process_last_dld_events_();
+  // file rotation
+  std::string part_path_(unsigned seq) const;
+  // whether the given fraction of one of the rotation limits is reached
+  bool job_rotation_due_(double fraction) const;
+  void job_rotate_();
+  void job_write_vds_master_();
+  void job_write_compressed_(void* const* bufs, std::size_t len);
+  // accounts a write to the file that started at t0
+  void job_note_write_(std::chrono::steady_clock::time_point t0,
+                       unsigned long long nbytes);
+  // true if the data field is compressed by the compressor_ and written by
+  // direct chunk writes (not possible with bit shuffle, which is only
+  // available in the HDF5 filter pipeline)
+  bool direct_chunks_(unsigned buf_id) const {
+    return compressor_ && !(prefilters_[buf_id] & PreFilter::BITSHUFFLE);
+  }
   void job_process_special_events_(bool force);
+  void job_consume_special_events_(std::size_t thresh);
+  void job_write_markers_(unsigned long long limit);
+  // raw capture mode
+  void job_raw_();
+  void job_process_raw_events_();
+  void job_process_raw_special_events_(bool force);
   bool special_events_thresh_exc() {
-    return (special_event_buf_.avail_read() > loc_.BUFSIZE);
+    return (special_event_buf_->size() >= special_thresh_);
   }
 
   void push_special_event(unsigned type, unsigned long long eventidx) {
     SpecialEvent e;
     e.type = type;
     e.eventidx = eventidx;
-    special_event_buf_.put(&e, 1);
+    if (!special_event_buf_->push(e))
+      push_special_event_blocking_(e);
     special_thresh_counter_ += 1;
-    if (special_thresh_counter_ > SPECIAL_NOTIF_THR) {
+    if (special_thresh_counter_ >= special_thresh_) {
       special_thresh_counter_ = 0;
       semWakeUp_.signal();
     }
   }
+  void push_special_event_blocking_(const SpecialEvent& e);
 };
 
 //------------------------------------------------------------------------------
@@ -148,9 +296,22 @@ public:
    */
   void setConfig(const HDF5Config& c);
   const HDF5Config& config() const;
+  void setRateHint(double rate);
   bool fileError() const;
+  void ringStats(unsigned* fill, unsigned* highwater,
+                 unsigned long long* dropped) const;
+  void markerStats(unsigned long long* pushed, unsigned long long* dropped,
+                   unsigned long long* stalls,
+                   unsigned long long* capacity) const;
+  void stats(HDF5Stats* s) const;
 
 private:
+  // previous stats query, for the current write rate
+  mutable std::mutex stats_mutex_;
+  mutable std::chrono::steady_clock::time_point stats_time_;
+  mutable unsigned long long stats_bytes_ = 0;
+  mutable double stats_rate_ = 0.0;
+
   void millisecond() {
     hdf5_thread_.push_millisecond();
   }
@@ -0,0 +1,106 @@
+/*
+ * Copyright (C) 2020 Surface Concept GmbH
+*/
+#include "MarkerRing.hpp"
+#include <new>
+
+MarkerRing::Segment::Segment(unsigned long long size)
+  : slots(new Slot[size]), mask(size - 1), head(0), tail(0), next(nullptr)
+{
+
+}
+
+MarkerRing::MarkerRing(unsigned long long size, unsigned policy)
+  : policy_(policy), capacity_(0), pushed_(0), popped_(0), dropped_(0)
+{
+  if (size > (1ull << 40))
+    size = 1ull << 40;
+  unsigned long long adapted_size = 2;
+  while (adapted_size < size)
+    adapted_size <<= 1;
+  prod_ = cons_ = new Segment(adapted_size);
+  capacity_.store(adapted_size);
+}
+
+MarkerRing::~MarkerRing()
+{
+  Segment* s = cons_;
+  while (s) {
+    Segment* n = s->next.load();
+    delete s;
+    s = n;
+  }
+}
+
+bool MarkerRing::push(const SpecialEvent& e)
+{
+  Segment* s = prod_;
+  unsigned long long h = s->head.load(std::memory_order_relaxed);
+  unsigned long long t = s->tail.load(std::memory_order_acquire);
+  if (h - t > s->mask) { // full
+    if (policy_ == MarkerOverflow::GROW) {
+      Segment* n = nullptr;
+      try {
+        n = new Segment(2 * (s->mask + 1));
+      }
+      catch (const std::bad_alloc&) {
+        count_(dropped_);
+        return true;
+      }
+      // the consumer switches to the new segment once it has drained this one
+      s->next.store(n, std::memory_order_release);
+      prod_ = s = n;
+      h = 0;
+      capacity_.store(s->mask + 1, std::memory_order_relaxed);
+    }
+    else if (policy_ == MarkerOverflow::DROP_OLDEST) {
+      // if this fails, the consumer has just made room
+      if (s->tail.compare_exchange_strong(t, t + 1, std::memory_order_acq_rel))
+        count_(dropped_);
+    }
+    else
+      return false;
+  }
+  Slot& slot = s->slots[h & s->mask];
+  slot.eventidx.store(e.eventidx, std::memory_order_relaxed);
+  slot.type.store(e.type, std::memory_order_relaxed);
+  s->head.store(h + 1, std::memory_order_release);
+  count_(pushed_);
+  return true;
+}
+
+std::size_t MarkerRing::pop(SpecialEvent* dst, std::size_t max)
+{
+  std::size_t len = 0;
+  while (len < max) {
+    Segment* s = cons_;
+    unsigned long long t = s->tail.load(std::memory_order_acquire);
+    unsigned long long h = s->head.load(std::memory_order_acquire);
+    if (h == t) {
+      Segment* n = s->next.load(std::memory_order_acquire);
+      if (!n)
+        break;
+      // the producer may have pushed to s before it switched to n
+      if (s->head.load(std::memory_order_acquire) != t)
+        continue;
+      cons_ = n;
+      delete s;
+      continue;
+    }
+    std::size_t k = (h - t < max - len) ? static_cast<std::size_t>(h - t)
+                                        : max - len;
+    for (std::size_t i = 0; i < k; i++) {
+      const Slot& slot = s->slots[(t + i) & s->mask];
+      dst[len + i].eventidx = slot.eventidx.load(std::memory_order_relaxed);
+      dst[len + i].type = slot.type.load(std::memory_order_relaxed);
+    }
+    // fails only with DROP_OLDEST, if the producer has overwritten the oldest
+    // marker in the meantime; then the copied markers are read again
+    if (s->tail.compare_exchange_strong(t, t + k, std::memory_order_acq_rel)) {
+      len += k;
+      popped_.store(popped_.load(std::memory_order_relaxed) + k,
+                    std::memory_order_release);
+    }
+  }
+  return len;
+}
@@ -0,0 +1,127 @@
+#ifndef MARKERRING_HPP
+#define MARKERRING_HPP
+
+/*
+ * Copyright (C) 2020 Surface Concept GmbH
+*/
+
+#include <atomic>
+#include <memory>
+
+struct SpecialEvent {
+  static const unsigned TYPE_NONE = 0;
+  static const unsigned TYPE_DLD_MILLISEC = 0x10;
+  static const unsigned TYPE_DLD_STARTMEAS = 0x11;
+  static const unsigned TYPE_DLD_ENDMEAS = 0x12;
+  unsigned long long eventidx;
+  unsigned type;
+};
+
+/** what MarkerRing::push does if the ring is full */
+struct MarkerOverflow
+{
+  static const unsigned GROW = 0;        // continue in a ring of twice the size
+  static const unsigned DROP_OLDEST = 1; // overwrite the oldest marker
+  static const unsigned BLOCK = 2;       // push fails, the caller waits
+};
+
+/**
+ * @brief The MarkerRing class passes the millisecond and start-of-measurement
+ * markers from the USER_CALLBACKS thread (single producer) to the writer
+ * thread (single consumer) without locking a mutex. push is wait-free except
+ * for the memory allocation of the GROW policy, which only happens when the
+ * ring is full.
+ * With GROW, the producer continues in a new ring segment of twice the size,
+ * the consumer frees the old segment once it has drained it. If the
+ * allocation fails, the marker is dropped and counted.
+ * With DROP_OLDEST, the producer takes the place of the oldest marker, which
+ * is counted as dropped. The consumer then retries its read of the affected
+ * markers.
+ * With BLOCK, push returns false, and the caller is expected to wake up the
+ * consumer and retry.
+ */
+class MarkerRing
+{
+public:
+  /**
+   * @param size number of markers, rounded up to a power of 2 (at least 2)
+   * @param policy one of the MarkerOverflow values
+   */
+  MarkerRing(unsigned long long size, unsigned policy);
+  ~MarkerRing();
+
+  MarkerRing(const MarkerRing&) = delete;
+  MarkerRing& operator=(const MarkerRing&) = delete;
+
+  /**
+   * @brief push add a marker (producer thread only)
+   * @return false if the ring is full and the policy is BLOCK
+   */
+  bool push(const SpecialEvent& e);
+
+  /**
+   * @brief pop take up to max markers in the order of push (consumer thread
+   * only)
+   * @return the number of markers copied to dst
+   */
+  std::size_t pop(SpecialEvent* dst, std::size_t max);
+
+  /** number of markers waiting for the consumer (approximate while the
+   * other thread is active) */
+  unsigned long long size() const {
+    // popped first, such that the result does not underflow
+    unsigned long long p = popped_.load(std::memory_order_acquire);
+    unsigned long long d = dropped_.load(std::memory_order_acquire);
+    unsigned long long n = pushed_.load(std::memory_order_acquire);
+    return (n > p + d) ? n - p - d : 0;
+  }
+
+  /** number of markers that fit into the segment of the producer */
+  unsigned long long capacity() const {
+    return capacity_.load(std::memory_order_relaxed);
+  }
+
+  unsigned policy() const {
+    return policy_;
+  }
+
+  /** number of markers accepted by push */
+  unsigned long long pushed() const {
+    return pushed_.load(std::memory_order_relaxed);
+  }
+
+  /** number of markers lost due to DROP_OLDEST or a failed allocation */
+  unsigned long long dropped() const {
+    return dropped_.load(std::memory_order_relaxed);
+  }
+
+private:
+  struct Slot {
+    // atomic, since DROP_OLDEST may overwrite a slot while it is being read
+    std::atomic<unsigned long long> eventidx;
+    std::atomic<unsigned> type;
+  };
+  struct Segment {
+    explicit Segment(unsigned long long size);
+    std::unique_ptr<Slot[]> slots;
+    unsigned long long mask;
+    // counters of pushed / popped markers, the difference is the fill level
+    std::atomic<unsigned long long> head;
+    std::atomic<unsigned long long> tail;
+    std::atomic<Segment*> next; // set by the producer after the last push
+  };
+
+  void count_(std::atomic<unsigned long long>& c) {
+    c.store(c.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+  }
+
+  unsigned policy_;
+  Segment* prod_; // producer-only
+  Segment* cons_; // consumer-only
+  std::atomic<unsigned long long> capacity_;
+  std::atomic<unsigned long long> pushed_;
+  std::atomic<unsigned long long> popped_;
+  std::atomic<unsigned long long> dropped_;
+};
+
+#endif // MARKERRING_HPP
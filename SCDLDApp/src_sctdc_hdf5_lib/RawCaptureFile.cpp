@@ -0,0 +1,155 @@
+/*
+ * Copyright (C) 2020 Surface Concept GmbH
+*/
+#include "RawCaptureFile.hpp"
+#include "RawEventBuf.hpp"
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace {
+
+bool pwrite_all(int fd, const void* buf, std::size_t nbytes,
+                unsigned long long offset)
+{
+  const char* p = static_cast<const char*>(buf);
+  while (nbytes > 0) {
+    ssize_t r = pwrite(fd, p, nbytes, static_cast<off_t>(offset));
+    if (r < 0) {
+      if (errno == EINTR)
+        continue;
+      return false;
+    }
+    p += r;
+    nbytes -= static_cast<std::size_t>(r);
+    offset += static_cast<unsigned long long>(r);
+  }
+  return true;
+}
+
+} // namespace
+
+RawCaptureFile::~RawCaptureFile()
+{
+  close();
+}
+
+bool RawCaptureFile::open(const std::string& path,
+  unsigned long long prealloc_bytes, EventDataFieldSelection::type datasel,
+  const std::string& user_comment)
+{
+  close();
+  const int flags = O_WRONLY | O_CREAT | O_TRUNC;
+#ifdef O_DIRECT
+  fd_ = ::open(path.c_str(), flags | O_DIRECT, 0644);
+  if (fd_ < 0 && errno == EINVAL) // file system without O_DIRECT support
+    fd_ = ::open(path.c_str(), flags, 0644);
+#else
+  fd_ = ::open(path.c_str(), flags, 0644);
+#endif
+  if (fd_ < 0)
+    return false;
+  idx_ = std::fopen((path + ".idx").c_str(), "wb");
+  if (!idx_) {
+    ::close(fd_);
+    fd_ = -1;
+    return false;
+  }
+#ifdef __linux__
+  // reserve the space without writing it (no fallback if unsupported)
+  if (prealloc_bytes > 0)
+    fallocate(fd_, 0, 0, static_cast<off_t>(RAW_HEADER_SIZE + prealloc_bytes));
+#else
+  (void) prealloc_bytes;
+#endif
+  nr_events_ = 0;
+  nr_markers_ = 0;
+  offset_ = RAW_HEADER_SIZE;
+  padded_ = false;
+  datasel_ = datasel;
+  comment_ = user_comment;
+  if (!write_header_(RAW_NOT_FINALIZED)) {
+    close();
+    return false;
+  }
+  return true;
+}
+
+bool RawCaptureFile::write_header_(unsigned long long nr_events)
+{
+  void* p = nullptr;
+  if (posix_memalign(&p, RawEventBuf::ALIGNMENT, RAW_HEADER_SIZE) != 0)
+    return false;
+  char* buf = static_cast<char*>(p);
+  memset(buf, 0, RAW_HEADER_SIZE);
+  RawCaptureHeader h;
+  memset(&h, 0, sizeof(h));
+  memcpy(h.magic, RAW_MAGIC, sizeof(h.magic));
+  h.version = RAW_VERSION;
+  h.header_size = static_cast<unsigned>(RAW_HEADER_SIZE);
+  h.event_size = static_cast<unsigned>(sizeof(sc_DldEvent));
+  h.datasel = datasel_;
+  h.nr_events = nr_events;
+  h.nr_markers = nr_markers_;
+  std::size_t clen = comment_.size();
+  if (clen > RAW_HEADER_SIZE - sizeof(h))
+    clen = RAW_HEADER_SIZE - sizeof(h);
+  h.comment_len = static_cast<unsigned>(clen);
+  memcpy(buf, &h, sizeof(h));
+  memcpy(buf + sizeof(h), comment_.data(), clen);
+  bool ok = pwrite_all(fd_, buf, RAW_HEADER_SIZE, 0);
+  free(p);
+  return ok;
+}
+
+bool RawCaptureFile::write(sc_DldEvent* e, std::size_t n,
+                           std::size_t capacity_bytes)
+{
+  if (fd_ < 0 || padded_)
+    return false;
+  const std::size_t nbytes = n * sizeof(sc_DldEvent);
+  std::size_t wbytes = nbytes;
+  if (nbytes % RawEventBuf::ALIGNMENT != 0) {
+    wbytes = (nbytes / RawEventBuf::ALIGNMENT + 1) * RawEventBuf::ALIGNMENT;
+    if (wbytes > capacity_bytes)
+      return false;
+    memset(reinterpret_cast<char*>(e) + nbytes, 0, wbytes - nbytes);
+    padded_ = true;
+  }
+  if (!pwrite_all(fd_, e, wbytes, offset_))
+    return false;
+  offset_ += nbytes;
+  nr_events_ += n;
+  return true;
+}
+
+void RawCaptureFile::appendMarker(unsigned long long eventidx, unsigned type)
+{
+  if (!idx_)
+    return;
+  RawCaptureMarker m;
+  m.eventidx = eventidx;
+  m.type = type;
+  m.reserved = 0;
+  if (std::fwrite(&m, sizeof(m), 1, idx_) == 1)
+    nr_markers_++;
+}
+
+void RawCaptureFile::close()
+{
+  if (idx_) {
+    std::fclose(idx_);
+    idx_ = nullptr;
+  }
+  if (fd_ < 0)
+    return;
+  write_header_(nr_events_);
+  // removes the padding of the last write and the unused preallocated space
+  // (if this fails, the header still tells the converter where events end)
+  int ret = ftruncate(fd_, static_cast<off_t>(offset_));
+  (void) ret;
+  ::close(fd_);
+  fd_ = -1;
+}
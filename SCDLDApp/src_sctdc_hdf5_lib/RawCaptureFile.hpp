@@ -0,0 +1,105 @@
+#ifndef RAWCAPTUREFILE_HPP
+#define RAWCAPTUREFILE_HPP
+
+/*
+ * Copyright (C) 2020 Surface Concept GmbH
+*/
+
+// Raw capture format (all integers in the byte order of the capturing host):
+//
+// <path>      header of RAW_HEADER_SIZE bytes (RawCaptureHeader followed by
+//             the user comment and zero padding), then the sc_DldEvent
+//             structs exactly as received from the scTDC library
+// <path>.idx  the markers, one RawCaptureMarker per millisecond marker or
+//             start of measurement, in the order of occurrence
+//
+// The header is written with nr_events = RAW_NOT_FINALIZED when the capture
+// starts and rewritten with the actual numbers when it ends.
+// The sctdc_raw2hdf5 tool converts a capture into the HDF5 layout of the
+// streaming mode.
+
+#include <cstdio>
+#include <string>
+#include <scTDC_types.h>
+#include "HDF5Config.hpp"
+
+static const char RAW_MAGIC[8] = {'S','C','T','D','C','R','A','W'};
+static const unsigned RAW_VERSION = 1;
+static const std::size_t RAW_HEADER_SIZE = 4096;
+static const unsigned long long RAW_NOT_FINALIZED = ~0ull;
+
+struct RawCaptureHeader {
+  char magic[8];                // RAW_MAGIC
+  unsigned version;             // RAW_VERSION
+  unsigned header_size;         // offset of the first event in bytes
+  unsigned event_size;          // sizeof(sc_DldEvent) of the capturing host
+  unsigned datasel;             // EventDataFieldSelection for the conversion
+  unsigned long long nr_events; // number of events in the file
+  unsigned long long nr_markers; // number of records in the index file
+  unsigned comment_len;         // length of the user comment in bytes
+  unsigned reserved;
+};
+
+struct RawCaptureMarker {
+  unsigned long long eventidx;  // number of events before the marker
+  unsigned type;                // SpecialEvent::TYPE_DLD_...
+  unsigned reserved;
+};
+
+/**
+ * @brief The RawCaptureFile class appends buffer pages of sc_DldEvent structs
+ * to a capture file. On Linux, the file is opened with O_DIRECT (if the file
+ * system supports it), such that the data bypasses the page cache. Buffers,
+ * sizes and file offsets of write() are multiples of RawEventBuf::ALIGNMENT.
+ */
+class RawCaptureFile
+{
+public:
+  RawCaptureFile() {}
+  ~RawCaptureFile();
+
+  RawCaptureFile(const RawCaptureFile&) = delete;
+  RawCaptureFile& operator=(const RawCaptureFile&) = delete;
+
+  /**
+   * @brief open create the capture file and the index file, write the header
+   * @param prealloc_bytes number of bytes to reserve on disk in advance (0:
+   * none); the file is truncated to the actual size by close()
+   * @return false on error
+   */
+  bool open(const std::string& path, unsigned long long prealloc_bytes,
+            EventDataFieldSelection::type datasel,
+            const std::string& user_comment);
+  bool isOpen() const { return fd_ >= 0; }
+
+  /**
+   * @brief write append events
+   * @param e aligned to RawEventBuf::ALIGNMENT
+   * @param n number of events
+   * @param capacity_bytes size of the memory at e. If the data size is not a
+   * multiple of the alignment, the data is padded in place up to the next
+   * multiple, which must not exceed capacity_bytes; the padding is removed by
+   * close().
+   * @return false on error
+   */
+  bool write(sc_DldEvent* e, std::size_t n, std::size_t capacity_bytes);
+
+  void appendMarker(unsigned long long eventidx, unsigned type);
+
+  /** finalize the header, truncate the preallocated space and close */
+  void close();
+
+private:
+  bool write_header_(unsigned long long nr_events);
+
+  int fd_ = -1;
+  std::FILE* idx_ = nullptr;
+  unsigned long long nr_events_ = 0;
+  unsigned long long nr_markers_ = 0;
+  unsigned long long offset_ = 0; // next write position
+  bool padded_ = false; // the last write was padded (no further writes)
+  EventDataFieldSelection::type datasel_ = 0;
+  std::string comment_;
+};
+
+#endif // RAWCAPTUREFILE_HPP
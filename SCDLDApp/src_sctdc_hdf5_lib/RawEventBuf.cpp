@@ -0,0 +1,49 @@
+/*
+ * Copyright (C) 2020 Surface Concept GmbH
+*/
+#include "RawEventBuf.hpp"
+#include <cstdlib>
+#include <new>
+
+RawEventBuf::RawEventBuf(unsigned long long size, unsigned nr_pages)
+  : size_(size), nr_pages_(nr_pages), head_(0), tail_(0), high_water_(0),
+    dropped_(0), partial_len_(0), events_pushed_(0), overflow_(false),
+    activebuf_len_(0)
+{
+  // the smallest number of events whose size is a multiple of ALIGNMENT
+  std::size_t step = 1;
+  while ((step * sizeof(sc_DldEvent)) % ALIGNMENT != 0)
+    step++;
+  if (size_ < 1)
+    size_ = 1;
+  size_ = (size_ + step - 1) / step * step;
+  if (nr_pages_ < 2)
+    nr_pages_ = 2;
+  pages_.resize(nr_pages_, nullptr);
+  for (unsigned j = 0; j < nr_pages_; j++) {
+    void* p = nullptr;
+    if (posix_memalign(&p, ALIGNMENT, page_bytes()) != 0) {
+      for (unsigned i = 0; i < j; i++)
+        free(pages_[i]);
+      throw std::bad_alloc();
+    }
+    pages_[j] = static_cast<sc_DldEvent*>(p);
+  }
+}
+
+RawEventBuf::~RawEventBuf()
+{
+  for (std::size_t i = 0; i < pages_.size(); i++)
+    free(pages_[i]);
+}
+
+void RawEventBuf::publish_page()
+{
+  auto h = head_.load(std::memory_order_relaxed) + 1;
+  head_.store(h, std::memory_order_release);
+  activebuf_len_ = 0;
+  auto level = static_cast<unsigned>(
+    h - tail_.load(std::memory_order_relaxed));
+  if (level > high_water_.load(std::memory_order_relaxed))
+    high_water_.store(level, std::memory_order_relaxed);
+}
@@ -0,0 +1,182 @@
+#ifndef RAWEVENTBUF_HPP
+#define RAWEVENTBUF_HPP
+
+/*
+ * Copyright (C) 2020 Surface Concept GmbH
+*/
+
+#include <atomic>
+#include <cstring>
+#include <vector>
+#include <scTDC_types.h>
+
+/**
+ * @brief The RawEventBuf class is the counterpart of HDF5EventBuf for the raw
+ * capture mode: a ring of N pages with a single producer and a single
+ * consumer, where the pages hold the sc_DldEvent structs unchanged (no
+ * transposition). The pages are aligned to, and their sizes are multiples of
+ * ALIGNMENT bytes, such that the consumer can write them to a file opened
+ * with O_DIRECT.
+ * If the consumer falls behind such that all pages are full, incoming events
+ * are dropped and counted, instead of stalling the TDC readout.
+ */
+class RawEventBuf
+{
+public:
+  static const std::size_t ALIGNMENT = 4096;
+
+  /**
+   * @param size requested number of events per page, rounded up such that
+   * the page size in bytes is a multiple of ALIGNMENT
+   * @param nr_pages number of pages in the ring (at least 2)
+   * @throws std::bad_alloc if the pages cannot be allocated
+   */
+  RawEventBuf(unsigned long long size, unsigned nr_pages);
+  ~RawEventBuf();
+
+  RawEventBuf(const RawEventBuf&) = delete;
+  RawEventBuf& operator=(const RawEventBuf&) = delete;
+
+  /**
+   * @brief push add DLD events. Must only be called from a single producer
+   * thread. Does not lock any mutex and does not wait.
+   * @return true if at least one buffer page became full
+   */
+  bool push(const sc_DldEvent *const e, std::size_t len)
+  {
+    if (overflow_) {
+      if (!next_page_free()) {
+        dropped_.store(dropped_.load(std::memory_order_relaxed) + len,
+                       std::memory_order_relaxed);
+        return false;
+      }
+      overflow_ = false;
+    }
+    bool bufpage_became_full = false;
+    std::size_t eidx = 0;
+    while (eidx < len) {
+      std::size_t n = static_cast<std::size_t>(size_ - activebuf_len_);
+      if (n > len - eidx)
+        n = len - eidx;
+      memcpy(page(head_.load(std::memory_order_relaxed)) + activebuf_len_,
+             e + eidx, n * sizeof(sc_DldEvent));
+      eidx += n;
+      events_pushed_.store(events_pushed_.load(std::memory_order_relaxed) + n,
+                           std::memory_order_relaxed);
+      activebuf_len_ += n;
+      if (activebuf_len_ == size_) {
+        publish_page();
+        bufpage_became_full = true;
+        if (!next_page_free()) {
+          overflow_ = true;
+          dropped_.store(
+            dropped_.load(std::memory_order_relaxed) + (len - eidx),
+            std::memory_order_relaxed);
+          break;
+        }
+      }
+    }
+    partial_len_.store(activebuf_len_, std::memory_order_release);
+    return bufpage_became_full;
+  }
+
+  /** the oldest full page (size() events), nullptr if there is none */
+  sc_DldEvent* get_page() const {
+    if (!has_data_page())
+      return nullptr;
+    return page(tail_.load(std::memory_order_relaxed));
+  }
+
+  /**
+   * @brief get_partial_page the partially filled page. Same requirements as
+   * HDF5EventBuf::get_partial_buf (producer stopped, full pages released).
+   * The page memory is writable up to the full page size, so the consumer
+   * may pad the data.
+   */
+  sc_DldEvent* get_partial_page(std::size_t* len) const {
+    if (overflow_) {
+      *len = 0;
+      return nullptr;
+    }
+    *len = partial_len_.load(std::memory_order_acquire);
+    return page(head_.load(std::memory_order_acquire));
+  }
+
+  bool has_data_page() const {
+    return head_.load(std::memory_order_acquire) !=
+      tail_.load(std::memory_order_relaxed);
+  }
+
+  void release_page() {
+    if (!has_data_page())
+      return;
+    tail_.store(tail_.load(std::memory_order_relaxed) + 1,
+                std::memory_order_release);
+  }
+
+  void release_partial_page() {
+    activebuf_len_ = 0;
+    partial_len_.store(0, std::memory_order_release);
+  }
+
+  /** number of events per page */
+  std::size_t size() const {
+    return static_cast<std::size_t>(size_);
+  }
+
+  /** page size in bytes, a multiple of ALIGNMENT */
+  std::size_t page_bytes() const {
+    return static_cast<std::size_t>(size_) * sizeof(sc_DldEvent);
+  }
+
+  unsigned nr_pages() const {
+    return nr_pages_;
+  }
+
+  /** number of full pages waiting for the consumer */
+  unsigned fill_level() const {
+    return static_cast<unsigned>(head_.load(std::memory_order_relaxed) -
+      tail_.load(std::memory_order_relaxed));
+  }
+
+  /** maximum number of full pages that were ever waiting for the consumer */
+  unsigned high_water_mark() const {
+    return high_water_.load(std::memory_order_relaxed);
+  }
+
+  /** number of events that were dropped because all pages were full */
+  unsigned long long dropped_events() const {
+    return dropped_.load(std::memory_order_relaxed);
+  }
+
+  /** number of events accepted into the buffer */
+  unsigned long long events_pushed() const {
+    return events_pushed_.load(std::memory_order_relaxed);
+  }
+
+private:
+  void publish_page();
+  bool next_page_free() const {
+    return head_.load(std::memory_order_relaxed) -
+      tail_.load(std::memory_order_acquire) < nr_pages_;
+  }
+  sc_DldEvent* page(unsigned long long page_counter) const {
+    return pages_[static_cast<std::size_t>(page_counter % nr_pages_)];
+  }
+
+  unsigned long long size_;
+  unsigned nr_pages_;
+  std::vector<sc_DldEvent*> pages_;
+  // page counters, same meaning as in HDF5EventBuf
+  std::atomic<unsigned long long> head_;
+  std::atomic<unsigned long long> tail_;
+  std::atomic<unsigned> high_water_;
+  std::atomic<unsigned long long> dropped_;
+  std::atomic<unsigned long long> partial_len_;
+  std::atomic<unsigned long long> events_pushed_; // written by the producer
+  // producer-only state
+  bool overflow_;
+  unsigned long long activebuf_len_;
+};
+
+#endif // RAWEVENTBUF_HPP
@@ -0,0 +1,261 @@
+/*
+ * Copyright (C) 2020 Surface Concept GmbH
+*/
+
+// Converts a raw capture (see RawCaptureFile.hpp, sc_tdc_hdf5_cfg_rawcapture)
+// into the HDF5 layout of the streaming mode. The events and markers are fed
+// into the same writer as during a live measurement (HDF5WriterImplThread),
+// so the result is identical to what the streaming mode would have written.
+// A reader thread reads the capture ahead, the writer thread and the
+// compression threads run concurrently with the transposition.
+//
+// usage: sctdc_raw2hdf5 [options] capture.raw [output.h5]
+//   -c codec    none, deflate, lz4 or zstd (default: none)
+//   -l level    compression level of the codec (default: 0, codec default)
+//   -j threads  number of compression threads (default: 0, automatic)
+//   -d mask     data field selection (default: as recorded in the capture)
+// If no output file is given, the .raw suffix of the capture is removed.
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <unistd.h>
+#include "HDF5WriterImpl.hpp"
+#include "HDF5Codecs.hpp"
+#include "RawCaptureFile.hpp"
+
+namespace {
+
+const std::size_t READ_BLOCK_EVENTS = 1 << 20;
+const std::size_t READ_AHEAD_BLOCKS = 3;
+
+void usage(const char* prog)
+{
+  std::fprintf(stderr,
+    "usage: %s [-c none|deflate|lz4|zstd] [-l level] [-j threads] "
+    "[-d mask] capture.raw [output.h5]\n", prog);
+}
+
+bool parse_codec(const char* s, unsigned* codec)
+{
+  static const char* names[] = {"none", "deflate", "lz4", "zstd"};
+  for (unsigned i = 0; i < 4; i++) {
+    if (strcmp(s, names[i]) == 0) {
+      *codec = i; // same order as CompressionCodec
+      return true;
+    }
+  }
+  return false;
+}
+
+/** reads the events of the capture in blocks on a separate thread */
+class BlockReader
+{
+public:
+  BlockReader(std::FILE* f, unsigned long long nr_events)
+    : f_(f), left_(nr_events), thread_(&BlockReader::run_, this) {}
+  ~BlockReader() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      quit_ = true;
+    }
+    cv_.notify_all();
+    thread_.join();
+  }
+  /** next block, empty at the end of the events or on read errors */
+  std::vector<sc_DldEvent> next() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    cv_.wait(lock, [this]() { return !blocks_.empty() || done_; });
+    if (blocks_.empty())
+      return std::vector<sc_DldEvent>();
+    std::vector<sc_DldEvent> b(std::move(blocks_.front()));
+    blocks_.pop_front();
+    cv_.notify_all();
+    return b;
+  }
+private:
+  void run_() {
+    while (left_ > 0) {
+      std::size_t n = (left_ < READ_BLOCK_EVENTS)
+                      ? static_cast<std::size_t>(left_) : READ_BLOCK_EVENTS;
+      std::vector<sc_DldEvent> b(n);
+      n = std::fread(b.data(), sizeof(sc_DldEvent), n, f_);
+      if (n == 0)
+        break;
+      b.resize(n);
+      left_ -= n;
+      std::unique_lock<std::mutex> lock(mutex_);
+      cv_.wait(lock, [this]() {
+        return blocks_.size() < READ_AHEAD_BLOCKS || quit_; });
+      if (quit_)
+        break;
+      blocks_.push_back(std::move(b));
+      cv_.notify_all();
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    done_ = true;
+    cv_.notify_all();
+  }
+
+  std::FILE* f_;
+  unsigned long long left_;
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::deque<std::vector<sc_DldEvent>> blocks_;
+  bool done_ = false;
+  bool quit_ = false;
+  std::thread thread_;
+};
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+  unsigned codec = CompressionCodec::NONE;
+  int level = 0;
+  unsigned threads = 0;
+  long long datasel = -1;
+  int opt;
+  while ((opt = getopt(argc, argv, "c:l:j:d:")) != -1) {
+    switch (opt) {
+    case 'c':
+      if (!parse_codec(optarg, &codec)) {
+        usage(argv[0]);
+        return 1;
+      }
+      break;
+    case 'l': level = std::atoi(optarg); break;
+    case 'j': threads = static_cast<unsigned>(std::atoi(optarg)); break;
+    case 'd': datasel = std::strtoll(optarg, nullptr, 0); break;
+    default:
+      usage(argv[0]);
+      return 1;
+    }
+  }
+  if (optind >= argc || argc - optind > 2) {
+    usage(argv[0]);
+    return 1;
+  }
+  const std::string inpath(argv[optind]);
+  std::string outpath;
+  if (argc - optind == 2)
+    outpath = argv[optind + 1];
+  else if (inpath.size() > 4 &&
+           inpath.compare(inpath.size() - 4, 4, ".raw") == 0)
+    outpath = inpath.substr(0, inpath.size() - 4);
+  else
+    outpath = inpath + ".h5";
+  if (!CodecAvailable(codec)) {
+    std::fprintf(stderr, "codec not available in this build\n");
+    return 1;
+  }
+
+  // ---- header and markers
+  std::FILE* f = std::fopen(inpath.c_str(), "rb");
+  if (!f) {
+    std::fprintf(stderr, "cannot open %s\n", inpath.c_str());
+    return 1;
+  }
+  std::vector<char> hbuf(RAW_HEADER_SIZE);
+  RawCaptureHeader h;
+  if (std::fread(hbuf.data(), 1, RAW_HEADER_SIZE, f) != RAW_HEADER_SIZE) {
+    std::fprintf(stderr, "%s: file too short\n", inpath.c_str());
+    std::fclose(f);
+    return 1;
+  }
+  memcpy(&h, hbuf.data(), sizeof(h));
+  if (memcmp(h.magic, RAW_MAGIC, sizeof(h.magic)) != 0 ||
+      h.version != RAW_VERSION || h.event_size != sizeof(sc_DldEvent) ||
+      h.header_size != RAW_HEADER_SIZE ||
+      h.comment_len > RAW_HEADER_SIZE - sizeof(h))
+  {
+    std::fprintf(stderr, "%s: not a raw capture of a compatible version\n",
+                 inpath.c_str());
+    std::fclose(f);
+    return 1;
+  }
+  if (h.nr_events == RAW_NOT_FINALIZED) {
+    std::fprintf(stderr, "%s: the capture was not finalized\n",
+                 inpath.c_str());
+    std::fclose(f);
+    return 1;
+  }
+  std::vector<RawCaptureMarker> markers;
+  std::FILE* fi = std::fopen((inpath + ".idx").c_str(), "rb");
+  if (fi) {
+    markers.resize(static_cast<std::size_t>(h.nr_markers));
+    markers.resize(std::fread(markers.data(), sizeof(RawCaptureMarker),
+                              markers.size(), fi));
+    std::fclose(fi);
+  }
+  if (markers.size() != h.nr_markers)
+    std::fprintf(stderr, "warning: %llu of %llu markers found\n",
+      static_cast<unsigned long long>(markers.size()), h.nr_markers);
+
+  // ---- writer, configured as during the live measurement
+  HDF5Config cfg;
+  cfg.base_path = outpath;
+  cfg.user_comment.assign(hbuf.data() + sizeof(h), h.comment_len);
+  cfg.datasel.value = (datasel >= 0) ? static_cast<unsigned>(datasel)
+                                     : h.datasel;
+  cfg.codec = codec;
+  cfg.pack_level = static_cast<unsigned>(ClampCodecLevel(codec, level));
+  cfg.compress_threads = threads;
+  unsigned long long nr_ms = 0;
+  for (const RawCaptureMarker& m : markers)
+    nr_ms += (m.type == SpecialEvent::TYPE_DLD_MILLISEC);
+  if (nr_ms > 0) // for the automatic chunk size
+    cfg.rate_hint = static_cast<double>(h.nr_events) * 1000.0 / nr_ms;
+  HDF5WriterImplThread w;
+  w.setConfig(cfg);
+  if (!w.start()) {
+    std::fprintf(stderr, "cannot create %s\n", outpath.c_str());
+    std::fclose(f);
+    return 1;
+  }
+
+  // ---- events, interleaved with the markers at their positions
+  std::size_t m = 0;
+  unsigned long long pos = 0; // events pushed so far
+  {
+    BlockReader reader(f, h.nr_events);
+    while (true) {
+      std::vector<sc_DldEvent> b = reader.next();
+      if (b.empty())
+        break;
+      std::size_t k = 0;
+      while (k < b.size()) {
+        while (m < markers.size() && markers[m].eventidx <= pos)
+          w.push_marker_wait(markers[m++].type);
+        std::size_t n = b.size() - k;
+        if (m < markers.size() && markers[m].eventidx - pos < n)
+          n = static_cast<std::size_t>(markers[m].eventidx - pos);
+        w.push_wait(b.data() + k, n);
+        k += n;
+        pos += n;
+      }
+    }
+  }
+  while (m < markers.size())
+    w.push_marker_wait(markers[m++].type);
+  w.stop();
+  std::fclose(f);
+
+  unsigned fill, highwater;
+  unsigned long long dropped;
+  w.ringStats(&fill, &highwater, &dropped);
+  if (pos != h.nr_events || dropped > 0) {
+    std::fprintf(stderr, "error: %llu of %llu events converted\n",
+                 pos - dropped, h.nr_events);
+    return 1;
+  }
+  std::printf("%s: %llu events, %llu markers\n", outpath.c_str(), pos,
+              static_cast<unsigned long long>(markers.size()));
+  return 0;
+}
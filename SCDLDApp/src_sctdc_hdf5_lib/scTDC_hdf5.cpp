@@ -2,12 +2,14 @@
  * Copyright (C) 2020 Surface Concept GmbH
 */
 
-#define LIB_VERSION "0.1.3"
+#define LIB_VERSION "0.10.0"
 
 #include <unordered_map>
 #include <utility>
 #include "HDF5Writer.hpp"
 #include "HDF5Config.hpp"
+#include "HDF5Codecs.hpp"
+#include "MarkerRing.hpp"
 #include <scTDC.h>
 #include "scTDC_hdf5.h"
 #include "scTDC_hdf5_error_codes.h"
@@ -166,6 +168,242 @@ int sc_tdc_hdf5_cfg_datasel(int hdf5obj, unsigned mask)
   return 0;
 }
 
+int sc_tdc_hdf5_cfg_bufpages(int hdf5obj, unsigned nr_pages)
+{
+  auto it = instances.find(hdf5obj);
+  if (it != instances.end()) {
+    it->second.cfg->nr_bufpages = (nr_pages < 2) ? 2 : nr_pages;
+    it->second.writer->setConfig(*(it->second.cfg));
+  }
+  else
+    return ERR_INSTANCE_NOTEXIST;
+  return 0;
+}
+
+int sc_tdc_hdf5_cfg_pagesize(int hdf5obj, unsigned long long events)
+{
+  auto it = instances.find(hdf5obj);
+  if (it != instances.end()) {
+    it->second.cfg->page_size = (events < 1) ? 1 : events;
+    it->second.writer->setConfig(*(it->second.cfg));
+  }
+  else
+    return ERR_INSTANCE_NOTEXIST;
+  return 0;
+}
+
+int sc_tdc_hdf5_cfg_chunksize(int hdf5obj, unsigned long long events)
+{
+  auto it = instances.find(hdf5obj);
+  if (it != instances.end()) {
+    it->second.cfg->chunk_size = events;
+    it->second.writer->setConfig(*(it->second.cfg));
+  }
+  else
+    return ERR_INSTANCE_NOTEXIST;
+  return 0;
+}
+
+int sc_tdc_hdf5_cfg_chunkcache(int hdf5obj, unsigned long long bytes)
+{
+  auto it = instances.find(hdf5obj);
+  if (it != instances.end()) {
+    it->second.cfg->chunk_cache = bytes;
+    it->second.writer->setConfig(*(it->second.cfg));
+  }
+  else
+    return ERR_INSTANCE_NOTEXIST;
+  return 0;
+}
+
+int sc_tdc_hdf5_cfg_packlevel(int hdf5obj, unsigned level)
+{
+  auto it = instances.find(hdf5obj);
+  if (it != instances.end()) {
+    it->second.cfg->codec = (level > 0) ? CompressionCodec::DEFLATE
+                                        : CompressionCodec::NONE;
+    it->second.cfg->pack_level = (level > 9) ? 9 : level;
+    it->second.writer->setConfig(*(it->second.cfg));
+  }
+  else
+    return ERR_INSTANCE_NOTEXIST;
+  return 0;
+}
+
+int sc_tdc_hdf5_cfg_compression(int hdf5obj, unsigned codec, int level)
+{
+  auto it = instances.find(hdf5obj);
+  if (it != instances.end()) {
+    if (!CodecAvailable(codec))
+      return ERR_INVALID_ARG;
+    it->second.cfg->codec = codec;
+    it->second.cfg->pack_level =
+      static_cast<unsigned>(ClampCodecLevel(codec, level));
+    it->second.writer->setConfig(*(it->second.cfg));
+  }
+  else
+    return ERR_INSTANCE_NOTEXIST;
+  return 0;
+}
+
+int sc_tdc_hdf5_cfg_compressthreads(int hdf5obj, unsigned nr_threads)
+{
+  auto it = instances.find(hdf5obj);
+  if (it != instances.end()) {
+    it->second.cfg->compress_threads = nr_threads;
+    it->second.writer->setConfig(*(it->second.cfg));
+  }
+  else
+    return ERR_INSTANCE_NOTEXIST;
+  return 0;
+}
+
+int sc_tdc_hdf5_cfg_prefilter(int hdf5obj, unsigned filter, unsigned mask)
+{
+  auto it = instances.find(hdf5obj);
+  if (it != instances.end()) {
+    HDF5Config& cfg = *(it->second.cfg);
+    switch (filter) {
+    case SC_TDC_HDF5_PREFILTER_DELTA:
+      cfg.delta_sel.value = mask;
+      break;
+    case SC_TDC_HDF5_PREFILTER_SHUFFLE:
+      cfg.shuffle_sel.value = mask;
+      break;
+    case SC_TDC_HDF5_PREFILTER_BITSHUFFLE:
+      cfg.bitshuffle_sel.value = mask;
+      break;
+    default:
+      return ERR_INVALID_ARG;
+    }
+    it->second.writer->setConfig(cfg);
+  }
+  else
+    return ERR_INSTANCE_NOTEXIST;
+  return 0;
+}
+
+int sc_tdc_hdf5_cfg_rawcapture(int hdf5obj, int enable,
+  unsigned long long prealloc_bytes)
+{
+  auto it = instances.find(hdf5obj);
+  if (it != instances.end()) {
+    it->second.cfg->raw_capture = (enable != 0);
+    it->second.cfg->raw_prealloc = prealloc_bytes;
+    it->second.writer->setConfig(*(it->second.cfg));
+  }
+  else
+    return ERR_INSTANCE_NOTEXIST;
+  return 0;
+}
+
+int sc_tdc_hdf5_cfg_rotation(int hdf5obj, unsigned long long max_bytes,
+  unsigned long long max_events, double max_seconds, int vds_master)
+{
+  if (!(max_seconds >= 0.0))
+    return ERR_INVALID_ARG;
+  auto it = instances.find(hdf5obj);
+  if (it != instances.end()) {
+    it->second.cfg->rotate_bytes = max_bytes;
+    it->second.cfg->rotate_events = max_events;
+    it->second.cfg->rotate_seconds = max_seconds;
+    it->second.cfg->vds_master = (vds_master != 0);
+    it->second.writer->setConfig(*(it->second.cfg));
+  }
+  else
+    return ERR_INSTANCE_NOTEXIST;
+  return 0;
+}
+
+int sc_tdc_hdf5_cfg_ratehint(int hdf5obj, double rate)
+{
+  auto it = instances.find(hdf5obj);
+  if (it != instances.end()) {
+    // not through the config, which belongs to the thread of the other
+    // sc_tdc_hdf5_cfg_* calls
+    it->second.writer->setRateHint((rate > 0.0) ? rate : 0.0);
+  }
+  else
+    return ERR_INSTANCE_NOTEXIST;
+  return 0;
+}
+
+int sc_tdc_hdf5_get_ringstats(int hdf5obj, unsigned* fill,
+  unsigned* highwater, unsigned long long* dropped_events)
+{
+  auto it = instances.find(hdf5obj);
+  if (it != instances.end()) {
+    unsigned f, h;
+    unsigned long long d;
+    it->second.writer->ringStats(&f, &h, &d);
+    if (fill) *fill = f;
+    if (highwater) *highwater = h;
+    if (dropped_events) *dropped_events = d;
+  }
+  else
+    return ERR_INSTANCE_NOTEXIST;
+  return 0;
+}
+
+int sc_tdc_hdf5_cfg_markerqueue(int hdf5obj, unsigned long long size,
+  unsigned policy)
+{
+  if (policy > MarkerOverflow::BLOCK)
+    return ERR_INVALID_ARG;
+  auto it = instances.find(hdf5obj);
+  if (it != instances.end()) {
+    it->second.cfg->marker_queue_size = size;
+    it->second.cfg->marker_overflow = policy;
+    it->second.writer->setConfig(*(it->second.cfg));
+  }
+  else
+    return ERR_INSTANCE_NOTEXIST;
+  return 0;
+}
+
+int sc_tdc_hdf5_get_markerstats(int hdf5obj, unsigned long long* pushed,
+  unsigned long long* dropped, unsigned long long* stalls,
+  unsigned long long* capacity)
+{
+  auto it = instances.find(hdf5obj);
+  if (it != instances.end()) {
+    unsigned long long p, d, s, c;
+    it->second.writer->markerStats(&p, &d, &s, &c);
+    if (pushed) *pushed = p;
+    if (dropped) *dropped = d;
+    if (stalls) *stalls = s;
+    if (capacity) *capacity = c;
+  }
+  else
+    return ERR_INSTANCE_NOTEXIST;
+  return 0;
+}
+
+int sc_tdc_hdf5_get_stats(int hdf5obj, struct sc_tdc_hdf5_stats* stats)
+{
+  if (!stats)
+    return ERR_INVALID_ARG;
+  auto it = instances.find(hdf5obj);
+  if (it != instances.end()) {
+    HDF5Stats s;
+    it->second.writer->stats(&s);
+    stats->events_received = s.events_received;
+    stats->events_written = s.events_written;
+    stats->events_dropped = s.events_dropped;
+    stats->bytes_written = s.bytes_written;
+    stats->mbytes_per_s = s.mbytes_per_s;
+    stats->ring_fill = s.ring_fill;
+    stats->ring_highwater = s.ring_highwater;
+    stats->ring_pages = s.ring_pages;
+    stats->push_seconds = s.push_seconds;
+    stats->max_append_ms = s.max_append_ms;
+    stats->file_error = s.file_error ? 1 : 0;
+  }
+  else
+    return ERR_INSTANCE_NOTEXIST;
+  return 0;
+}
+
 void sc_tdc_hdf5_version(char *buf, size_t len)
 {
   if (buf==nullptr) return;
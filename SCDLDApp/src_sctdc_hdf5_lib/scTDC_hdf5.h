@@ -127,6 +127,324 @@ SCTDCHDF5DLL_PUBLIC int sc_tdc_hdf5_cfg_comment(int hdf5obj, const char* msg);
  */
 SCTDCHDF5DLL_PUBLIC int sc_tdc_hdf5_cfg_datasel(int hdf5obj, unsigned mask);
 
+/**
+ * @brief set the number of buffer pages in the ring buffer that passes events
+ * from the USER_CALLBACKS thread to the HDF5 writer thread. More pages allow
+ * the writer thread to fall behind for a longer time (for example, during
+ * slow disk accesses), before events have to be dropped. Values smaller than
+ * 2 are replaced by 2. This must be called before activating the streaming by
+ * sc_tdc_hdf5_setactive. The default is 8.
+ * @param hdf5obj the object handle as returned by sc_tdc_hdf5_create
+ * @param nr_pages the number of buffer pages
+ * @return 0 on success or negative error code
+ */
+SCTDCHDF5DLL_PUBLIC int sc_tdc_hdf5_cfg_bufpages(int hdf5obj, unsigned nr_pages);
+
+/**
+ * @brief set the number of events per buffer page. Each buffer page is written
+ * to the HDF5 file by one append operation per data field, so larger pages
+ * reduce the per-append overhead at high event rates, at the cost of memory
+ * (nr_pages * page_size * bytes per selected data fields). Values of 0 are
+ * replaced by 1. This must be called before activating the streaming by
+ * sc_tdc_hdf5_setactive. The default is 262144.
+ * @param hdf5obj the object handle as returned by sc_tdc_hdf5_create
+ * @param events the number of events per buffer page
+ * @return 0 on success or negative error code
+ */
+SCTDCHDF5DLL_PUBLIC int sc_tdc_hdf5_cfg_pagesize(int hdf5obj,
+  unsigned long long events);
+
+/**
+ * @brief set the number of events per HDF5 chunk in the event datasets.
+ * If events is 0 (the default), the chunk size is chosen automatically when
+ * the streaming is activated: a power of two of events, such that one chunk
+ * holds roughly 0.1 s worth of data at the expected event rate (see
+ * sc_tdc_hdf5_cfg_ratehint), limited to the range from 16384 to the page
+ * size. Without a known event rate, the page size is used. Choosing the chunk
+ * size such that it divides the page size is most efficient.
+ * @param hdf5obj the object handle as returned by sc_tdc_hdf5_create
+ * @param events the number of events per chunk, or 0 for automatic choice
+ * @return 0 on success or negative error code
+ */
+SCTDCHDF5DLL_PUBLIC int sc_tdc_hdf5_cfg_chunksize(int hdf5obj,
+  unsigned long long events);
+
+/**
+ * @brief set the size of the HDF5 chunk cache per dataset. If bytes is 0 (the
+ * default), the cache is sized to hold two chunks, which avoids that the HDF5
+ * library reads back partially written chunks from the file.
+ * @param hdf5obj the object handle as returned by sc_tdc_hdf5_create
+ * @param bytes the chunk cache size in bytes, or 0 for automatic choice
+ * @return 0 on success or negative error code
+ */
+SCTDCHDF5DLL_PUBLIC int sc_tdc_hdf5_cfg_chunkcache(int hdf5obj,
+  unsigned long long bytes);
+
+/**
+ * @brief set the deflate compression level for the event datasets. 0 (the
+ * default) disables compression, 1..9 are the zlib compression levels, higher
+ * values are replaced by 9. This is a shortcut for sc_tdc_hdf5_cfg_compression
+ * with SC_TDC_HDF5_CODEC_DEFLATE (level > 0) or SC_TDC_HDF5_CODEC_NONE.
+ * @param hdf5obj the object handle as returned by sc_tdc_hdf5_create
+ * @param level the compression level
+ * @return 0 on success or negative error code
+ */
+SCTDCHDF5DLL_PUBLIC int sc_tdc_hdf5_cfg_packlevel(int hdf5obj, unsigned level);
+
+/** compression codecs for sc_tdc_hdf5_cfg_compression */
+enum sc_tdc_hdf5_codec {
+  SC_TDC_HDF5_CODEC_NONE = 0,    /**< no compression */
+  SC_TDC_HDF5_CODEC_DEFLATE = 1, /**< zlib, levels 1..9 */
+  SC_TDC_HDF5_CODEC_LZ4 = 2,     /**< LZ4 (filter ID 32004), no levels */
+  SC_TDC_HDF5_CODEC_ZSTD = 3     /**< Zstandard (filter ID 32015), 1..22 */
+};
+
+/**
+ * @brief select the compression codec and level for the event datasets.
+ * LZ4 and Zstd are much faster than deflate and suitable for streaming at
+ * high event rates. They are stored with the filter IDs registered with The
+ * HDF Group, in the same format as the common filter plugins, so that readers
+ * with these plugins decode the data transparently (for example, h5py after
+ * "import hdf5plugin"). LZ4 and Zstd are optional features at build time.
+ * This must be called before activating the streaming by
+ * sc_tdc_hdf5_setactive. By default, no compression is used.
+ * @param hdf5obj the object handle as returned by sc_tdc_hdf5_create
+ * @param codec one of the sc_tdc_hdf5_codec values
+ * @param level the compression level of the codec; 0 selects the default
+ * level of the codec (deflate 6, Zstd 3), values above the maximum are
+ * replaced by the maximum. Without effect for LZ4.
+ * @return 0 on success or negative error code (-4 ERR_INVALID_ARG for an
+ * unknown codec or a codec that is not available in this build)
+ */
+SCTDCHDF5DLL_PUBLIC int sc_tdc_hdf5_cfg_compression(int hdf5obj,
+  unsigned codec, int level);
+
+/**
+ * @brief set the number of worker threads that compress the event data if a
+ * compression codec is configured (see sc_tdc_hdf5_cfg_compression). The
+ * compressed chunks are written to the file by direct chunk writes; the result
+ * is the same as with the HDF5 filter of the codec. With
+ * compression, the chunk size is adjusted to the page size if it does not
+ * divide the page size. If nr_threads is 0 (the default), the number of
+ * hardware threads minus two is used (at least 1).
+ * @param hdf5obj the object handle as returned by sc_tdc_hdf5_create
+ * @param nr_threads the number of compression threads, or 0 for automatic
+ * choice
+ * @return 0 on success or negative error code
+ */
+SCTDCHDF5DLL_PUBLIC int sc_tdc_hdf5_cfg_compressthreads(int hdf5obj,
+  unsigned nr_threads);
+
+/** pre-filters for sc_tdc_hdf5_cfg_prefilter */
+enum sc_tdc_hdf5_prefilter {
+  SC_TDC_HDF5_PREFILTER_DELTA = 1,      /**< delta + zig-zag encoding */
+  SC_TDC_HDF5_PREFILTER_SHUFFLE = 2,    /**< byte shuffle */
+  SC_TDC_HDF5_PREFILTER_BITSHUFFLE = 3  /**< bit shuffle */
+};
+
+/**
+ * @brief select the data fields that are pre-conditioned by the specified
+ * filter before compression (see sc_tdc_hdf5_cfg_compression). This is most
+ * effective for the nearly monotonic 64-bit fields (start counter 0x1, time
+ * tag 0x2, time 0x10, master reset counter 0x80) with delta encoding followed
+ * by shuffle. Pre-filters are applied in the order delta, (bit) shuffle,
+ * codec. They are stored as HDF5 filters in the datasets, so readers decode
+ * them transparently:
+ * Byte shuffle is built into every HDF5 library.
+ * Bit shuffle requires the bitshuffle filter plugin (ID 32008) for writing and
+ * reading; if it is not available at activation time, byte shuffle is used
+ * instead. Bit shuffle also disables the parallel compression for the
+ * affected data fields (the HDF5 library compresses them on the writer
+ * thread).
+ * Delta / zig-zag encoding is a filter of this library (ID 305, from the range
+ * that is not officially registered). It is mandatory for reading: h5py,
+ * h5dump and the hdf5plugin package cannot read the affected datasets unless
+ * the sctdc_h5zdelta plugin library (built with this library) is in a
+ * directory listed in the HDF5_PLUGIN_PATH environment variable. Such files
+ * carry a root attribute "RequiredFilterPlugins" naming the plugin. Only
+ * select delta encoding if all readers of the files have the plugin.
+ * This must be called before activating the streaming by
+ * sc_tdc_hdf5_setactive. By default, no pre-filters are selected.
+ * @param hdf5obj the object handle as returned by sc_tdc_hdf5_create
+ * @param filter one of the sc_tdc_hdf5_prefilter values
+ * @param mask bitmask of data fields, same as in sc_tdc_hdf5_cfg_datasel
+ * @return 0 on success or negative error code (-4 ERR_INVALID_ARG for an
+ * unknown filter)
+ */
+SCTDCHDF5DLL_PUBLIC int sc_tdc_hdf5_cfg_prefilter(int hdf5obj, unsigned filter,
+  unsigned mask);
+
+/**
+ * @brief inform the streamer about the expected event rate, used for the
+ * automatic chunk size (see sc_tdc_hdf5_cfg_chunksize). If no rate hint is
+ * given (or rate <= 0), the event rate measured during the previous
+ * activation is used, if it lasted at least one second of measurement time.
+ * Unlike the other configuration functions, this one may be called from any
+ * thread, concurrently with them.
+ * @param hdf5obj the object handle as returned by sc_tdc_hdf5_create
+ * @param rate the expected event rate in events per second
+ * @return 0 on success or negative error code
+ */
+SCTDCHDF5DLL_PUBLIC int sc_tdc_hdf5_cfg_ratehint(int hdf5obj, double rate);
+
+/**
+ * @brief enable or disable the raw capture mode. In the raw capture mode, no
+ * HDF5 file is written during the measurement. Instead, the events are
+ * appended unchanged (the sc_DldEvent structs as delivered by the scTDC
+ * library) to the file <path>.raw, where <path> is the file path set by
+ * sc_tdc_hdf5_cfg_outfile, and the millisecond and start-of-measurement
+ * markers to <path>.raw.idx. On Linux, the capture file is written with
+ * O_DIRECT, bypassing the page cache. This has the lowest overhead per event
+ * and is intended for the highest event rates. The sctdc_raw2hdf5 tool
+ * converts a capture into the HDF5 file that the normal mode would have
+ * written. The data field selection (sc_tdc_hdf5_cfg_datasel) and the user
+ * comment are stored in the capture for the conversion. The page size and
+ * number of buffer pages apply as in the normal mode (the page size is
+ * rounded up such that pages are multiples of 4096 bytes, for O_DIRECT).
+ * This must be called before activating the streaming by
+ * sc_tdc_hdf5_setactive. By default, the raw capture mode is disabled.
+ * @param hdf5obj the object handle as returned by sc_tdc_hdf5_create
+ * @param enable 1 to enable, 0 to disable the raw capture mode
+ * @param prealloc_bytes disk space that is reserved for the capture file
+ * when the streaming is activated, avoiding file system metadata updates
+ * while the file grows (the unused rest is released at deactivation). 0
+ * disables the preallocation. Default: 1 GiB.
+ * @return 0 on success or negative error code
+ */
+SCTDCHDF5DLL_PUBLIC int sc_tdc_hdf5_cfg_rawcapture(int hdf5obj, int enable,
+  unsigned long long prealloc_bytes);
+
+/**
+ * @brief split long measurements into a series of files. With rotation, the
+ * data is written to <stem>_00000<ext>, <stem>_00001<ext>, ... where
+ * <stem><ext> is the file path set by sc_tdc_hdf5_cfg_outfile. A new file is
+ * started as soon as one of the limits is reached. The limits are checked
+ * whenever a buffer page has been written, so files end at page boundaries
+ * (see sc_tdc_hdf5_cfg_pagesize), and the time limit is only checked while
+ * events arrive. The next file is created in advance, once half of one of the
+ * limits is reached, so switching files does not delay the writing and no
+ * events are lost.
+ * Every file has the same datasets and attributes as without rotation, plus
+ * the attributes "Sequence" (0, 1, ...) and "FirstEventIndex" (the index of
+ * the first event of the file within the whole measurement). The values in
+ * msMarkers and startMarkers count the events of the whole measurement, as
+ * without rotation; each marker is stored in the file that contains the event
+ * it refers to.
+ * Optionally, a master file is written at the end of the measurement under
+ * the path set by sc_tdc_hdf5_cfg_outfile. It contains the datasets of all
+ * files concatenated as HDF5 virtual datasets (requires HDF5 1.10 readers);
+ * the files must stay in the same directory as the master file.
+ * Rotation does not apply to the raw capture mode (sc_tdc_hdf5_cfg_rawcapture).
+ * This must be called before activating the streaming by
+ * sc_tdc_hdf5_setactive. By default, rotation is disabled.
+ * @param hdf5obj the object handle as returned by sc_tdc_hdf5_create
+ * @param max_bytes maximum file size in bytes, 0 for no limit
+ * @param max_events maximum number of events per file, 0 for no limit
+ * @param max_seconds maximum wall time per file in seconds, 0 for no limit
+ * @param vds_master 1 to write the master file, 0 otherwise
+ * @return 0 on success or negative error code (-4 ERR_INVALID_ARG for
+ * negative max_seconds)
+ */
+SCTDCHDF5DLL_PUBLIC int sc_tdc_hdf5_cfg_rotation(int hdf5obj,
+  unsigned long long max_bytes, unsigned long long max_events,
+  double max_seconds, int vds_master);
+
+/**
+ * @brief query the state of the ring buffer between the USER_CALLBACKS thread
+ * and the HDF5 writer thread. The values refer to the current or the last
+ * activation of the streaming. Any of the pointer arguments may be NULL.
+ * @param hdf5obj the object handle as returned by sc_tdc_hdf5_create
+ * @param fill receives the number of full buffer pages waiting to be written
+ * @param highwater receives the maximum number of full buffer pages that were
+ * waiting to be written at the same time (the high-water mark)
+ * @param dropped_events receives the number of events that were dropped
+ * because all buffer pages were full
+ * @return 0 on success or negative error code
+ */
+SCTDCHDF5DLL_PUBLIC int sc_tdc_hdf5_get_ringstats(int hdf5obj, unsigned* fill,
+  unsigned* highwater, unsigned long long* dropped_events);
+
+/** overflow policies of the marker queue for sc_tdc_hdf5_cfg_markerqueue */
+enum sc_tdc_hdf5_marker_overflow {
+  SC_TDC_HDF5_MARKERS_GROW = 0,        /**< enlarge the queue */
+  SC_TDC_HDF5_MARKERS_DROP_OLDEST = 1, /**< replace the oldest marker */
+  SC_TDC_HDF5_MARKERS_BLOCK = 2        /**< wait for the writer thread */
+};
+
+/**
+ * @brief configure the queue that passes the millisecond and
+ * start-of-measurement markers from the USER_CALLBACKS thread to the HDF5
+ * writer thread. The writer thread takes the markers from the queue when it
+ * is half full (at most 50000 markers), or when a file is closed. If the
+ * queue is full nevertheless, the policy decides:
+ * SC_TDC_HDF5_MARKERS_GROW (the default) continues in a queue of twice the
+ * size, without loss and without waiting; SC_TDC_HDF5_MARKERS_DROP_OLDEST
+ * discards the oldest marker; SC_TDC_HDF5_MARKERS_BLOCK makes the
+ * USER_CALLBACKS thread wait until the writer thread has made room (which
+ * delays the readout).
+ * See sc_tdc_hdf5_get_markerstats for the counters of lost markers and waits.
+ * This must be called before activating the streaming by
+ * sc_tdc_hdf5_setactive. Default: 65536 markers, SC_TDC_HDF5_MARKERS_GROW.
+ * @param hdf5obj the object handle as returned by sc_tdc_hdf5_create
+ * @param size the number of markers, rounded up to a power of 2
+ * @param policy one of the sc_tdc_hdf5_marker_overflow values
+ * @return 0 on success or negative error code (-4 ERR_INVALID_ARG for an
+ * unknown policy)
+ */
+SCTDCHDF5DLL_PUBLIC int sc_tdc_hdf5_cfg_markerqueue(int hdf5obj,
+  unsigned long long size, unsigned policy);
+
+/**
+ * @brief query the counters of the marker queue (see
+ * sc_tdc_hdf5_cfg_markerqueue). The values refer to the current or the last
+ * activation of the streaming. Any of the pointer arguments may be NULL.
+ * @param hdf5obj the object handle as returned by sc_tdc_hdf5_create
+ * @param pushed receives the number of markers accepted into the queue
+ * @param dropped receives the number of markers that were lost
+ * (SC_TDC_HDF5_MARKERS_DROP_OLDEST, or if growing the queue failed)
+ * @param stalls receives the number of times the USER_CALLBACKS thread had to
+ * wait for a full queue (SC_TDC_HDF5_MARKERS_BLOCK)
+ * @param capacity receives the current capacity of the queue in markers
+ * @return 0 on success or negative error code
+ */
+SCTDCHDF5DLL_PUBLIC int sc_tdc_hdf5_get_markerstats(int hdf5obj,
+  unsigned long long* pushed, unsigned long long* dropped,
+  unsigned long long* stalls, unsigned long long* capacity);
+
+/** health counters of the HDF5 streamer, see sc_tdc_hdf5_get_stats */
+struct sc_tdc_hdf5_stats {
+  unsigned long long events_received; /**< events delivered by the device */
+  unsigned long long events_written;  /**< events written to the file */
+  unsigned long long events_dropped;  /**< events lost due to a full ring */
+  unsigned long long bytes_written;   /**< data bytes written (compressed) */
+  double mbytes_per_s;     /**< write rate since the previous query, MB/s */
+  unsigned ring_fill;      /**< full buffer pages waiting to be written */
+  unsigned ring_highwater; /**< maximum of ring_fill */
+  unsigned ring_pages;     /**< number of buffer pages */
+  double push_seconds;     /**< time of the USER_CALLBACKS thread in the
+                                streamer (copying into the ring buffer) */
+  double max_append_ms;    /**< longest single write of data to the file */
+  int file_error;          /**< 1 if writing to the file has failed, the
+                                events since then are not written */
+};
+
+/**
+ * @brief query the health counters of the HDF5 streamer. The values refer to
+ * the current or the last activation of the streaming. A growing ring_fill,
+ * a write rate below the data rate of the device or long write calls
+ * indicate that the storage does not keep up, before events_dropped starts
+ * counting. The write rate is computed from the bytes written since the
+ * previous call of this function (if that was at least 0.5 s ago, otherwise
+ * the previous value is repeated).
+ * With the raw capture mode, bytes_written counts the sc_DldEvent structs
+ * and max_append_ms refers to the writes of the capture file.
+ * @param hdf5obj the object handle as returned by sc_tdc_hdf5_create
+ * @param stats receives the counters
+ * @return 0 on success or negative error code
+ */
+SCTDCHDF5DLL_PUBLIC int sc_tdc_hdf5_get_stats(int hdf5obj,
+  struct sc_tdc_hdf5_stats* stats);
+
 /**
  * @brief retrieve version string
  * @param buf user-provided buffer where the version string is copied to
@@ -5,5 +5,6 @@ enum sc_tdc_hdf5_error_code {
   ERR_UNSPECIFIED = -1,
   ERR_BAD_ALLOC = -2,
   ERR_FILE = -3,
+  ERR_INVALID_ARG = -4,
   ERR_INSTANCE_NOTEXIST = -10
 };
@@ -0,0 +1,353 @@
+/*
+ * Copyright (C) 2020 Surface Concept GmbH
+*/
+#include "MockDevice.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <scTDC_error_codes.h>
+
+namespace {
+
+const unsigned long long MAX_OWN_BUFFER = 1ull << 31; // bytes
+
+} // namespace
+
+struct MockDevice::Pipe
+{
+  int type = -1;
+  bool open = true;
+  sc_pipe_callbacks cb;  // USER_CALLBACKS
+  // DLD_IMAGE_XY, DLD_IMAGE_3D, DLD_SUM_HISTO
+  std::size_t depth = 4; // bytes per bin
+  int channel = -1;
+  unsigned long long modulo = 0;
+  unsigned long long bin[3] = {1, 1, 1};   // x, y, time
+  long long offset[3] = {0, 0, 0};
+  unsigned long long size[3] = {1, 1, 1};
+  // DLD_IMAGE_XY, DLD_IMAGE_3D, DLD_SUM_HISTO, STATISTICS
+  void* owner = nullptr;
+  int (*alloc)(void*, void**) = nullptr;
+  std::vector<unsigned char> own; // buffer if there is no allocator
+  void* buf = nullptr;
+  bool ready = false;
+
+  template <typename P>
+  bool set_histo(const P& h) {
+    switch (h.depth) {
+    case BS8: depth = 1; break;
+    case BS16: depth = 2; break;
+    case BS32: depth = 4; break;
+    case BS64: depth = 8; break;
+    default: return false;
+    }
+    channel = h.channel;
+    modulo = h.modulo;
+    bin[0] = std::max(1ull, static_cast<unsigned long long>(h.binning.x));
+    bin[1] = std::max(1ull, static_cast<unsigned long long>(h.binning.y));
+    bin[2] = std::max(1ull, static_cast<unsigned long long>(h.binning.time));
+    offset[0] = static_cast<long long>(h.roi.offset.x);
+    offset[1] = static_cast<long long>(h.roi.offset.y);
+    offset[2] = static_cast<long long>(h.roi.offset.time);
+    size[0] = h.roi.size.x;
+    size[1] = h.roi.size.y;
+    size[2] = h.roi.size.time;
+    owner = h.allocator_owner;
+    alloc = h.allocator_cb;
+    return size[0] > 0 && size[1] > 0 && size[2] > 0 &&
+      (alloc || nr_bins() <= MAX_OWN_BUFFER / depth);
+  }
+
+  unsigned long long nr_bins() const {
+    if (type == DLD_IMAGE_XY)
+      return (size[0] > MAX_OWN_BUFFER / size[1]) ? MAX_OWN_BUFFER + 1
+                                                  : size[0] * size[1];
+    if (type == DLD_IMAGE_3D)
+      return (size[0] > MAX_OWN_BUFFER / size[1] ||
+              size[0] * size[1] > MAX_OWN_BUFFER / size[2])
+        ? MAX_OWN_BUFFER + 1 : size[0] * size[1] * size[2];
+    return size[2];
+  }
+
+  std::size_t buffer_bytes() const {
+    if (type == STATISTICS)
+      return sizeof(statistics_t);
+    return static_cast<std::size_t>(nr_bins()) * depth;
+  }
+
+  bool is_histo() const {
+    return type == DLD_IMAGE_XY || type == DLD_IMAGE_3D ||
+      type == DLD_SUM_HISTO;
+  }
+
+  template <typename T>
+  void fill(const sc_DldEvent* e, std::size_t n) {
+    T* h = static_cast<T*>(buf);
+    for (std::size_t i = 0; i < n; i++) {
+      if (channel >= 0 && e[i].channel != static_cast<unsigned>(channel))
+        continue;
+      const unsigned long long t = modulo ? e[i].sum % modulo : e[i].sum;
+      const long long bx = static_cast<long long>(e[i].dif1 / bin[0]) - offset[0];
+      const long long by = static_cast<long long>(e[i].dif2 / bin[1]) - offset[1];
+      const long long bt = static_cast<long long>(t / bin[2]) - offset[2];
+      if (bx < 0 || by < 0 || bt < 0 ||
+          static_cast<unsigned long long>(bx) >= size[0] ||
+          static_cast<unsigned long long>(by) >= size[1] ||
+          static_cast<unsigned long long>(bt) >= size[2])
+        continue;
+      if (type == DLD_IMAGE_XY)
+        h[static_cast<std::size_t>(by) * size[0] + bx]++;
+      else if (type == DLD_IMAGE_3D) // x fastest, then y, then t
+        h[(static_cast<std::size_t>(bt) * size[1] + by) * size[0] + bx]++;
+      else
+        h[bt]++;
+    }
+  }
+
+  void fill(const sc_DldEvent* e, std::size_t n) {
+    switch (depth) {
+    case 1: fill<unsigned char>(e, n); break;
+    case 2: fill<unsigned short>(e, n); break;
+    case 4: fill<unsigned>(e, n); break;
+    default: fill<unsigned long long>(e, n); break;
+    }
+  }
+};
+
+MockDevice::MockDevice(const MockSettings& s)
+  : s_(s), gen_(s), interrupt_(false)
+{
+  memset(&stats_, 0, sizeof(stats_));
+  thread_ = std::thread(&MockDevice::run_, this);
+}
+
+MockDevice::~MockDevice()
+{
+  {
+    std::lock_guard<std::mutex> lock(state_mutex_);
+    quit_ = true;
+    interrupt_ = true;
+  }
+  state_cv_.notify_all();
+  thread_.join();
+}
+
+int MockDevice::open_pipe(int type, const void* params)
+{
+  if (!params)
+    return MockError::PARAMETER;
+  std::shared_ptr<Pipe> p(new Pipe);
+  p->type = type;
+  switch (type) {
+  case USER_CALLBACKS: {
+    auto cp = static_cast<const sc_pipe_callback_params_t*>(params);
+    if (!cp->callbacks)
+      return MockError::PARAMETER;
+    p->cb = *cp->callbacks;
+    break;
+  }
+  case DLD_IMAGE_XY:
+    if (!p->set_histo(
+          *static_cast<const sc_pipe_dld_image_xy_params_t*>(params)))
+      return MockError::PARAMETER;
+    break;
+  case DLD_IMAGE_3D:
+    if (!p->set_histo(
+          *static_cast<const sc_pipe_dld_image_3d_params_t*>(params)))
+      return MockError::PARAMETER;
+    break;
+  case DLD_SUM_HISTO:
+    if (!p->set_histo(
+          *static_cast<const sc_pipe_dld_sum_histo_params_t*>(params)))
+      return MockError::PARAMETER;
+    break;
+  case STATISTICS: {
+    auto sp = static_cast<const sc_pipe_statistics_params_t*>(params);
+    p->owner = sp->allocator_owner;
+    p->alloc = sp->allocator_cb;
+    break;
+  }
+  default:
+    return MockError::PIPETYPE;
+  }
+  std::lock_guard<std::recursive_mutex> lock(pipes_mutex_);
+  const int pd = next_pd_++;
+  pipes_[pd] = p;
+  return pd;
+}
+
+int MockDevice::close_pipe(int pd)
+{
+  std::lock_guard<std::recursive_mutex> lock(pipes_mutex_);
+  auto it = pipes_.find(pd);
+  if (it == pipes_.end())
+    return MockError::NOPIPE;
+  it->second->open = false;
+  pipes_.erase(it);
+  pipes_cv_.notify_all();
+  return 0;
+}
+
+int MockDevice::read_pipe(int pd, void** buf, unsigned timeout_ms)
+{
+  if (!buf)
+    return MockError::PARAMETER;
+  std::unique_lock<std::recursive_mutex> lock(pipes_mutex_);
+  auto it = pipes_.find(pd);
+  if (it == pipes_.end())
+    return MockError::NOPIPE;
+  std::shared_ptr<Pipe> p = it->second;
+  if (p->type == USER_CALLBACKS)
+    return MockError::PIPETYPE;
+  pipes_cv_.wait_for(lock, std::chrono::milliseconds(timeout_ms),
+    [&p]() { return p->ready || !p->open; });
+  if (!p->ready)
+    return p->open ? MockError::TIMEOUT : MockError::NOPIPE;
+  p->ready = false;
+  *buf = p->buf;
+  return 0;
+}
+
+int MockDevice::start(int exposure_ms)
+{
+  if (exposure_ms < 0)
+    return MockError::PARAMETER;
+  {
+    std::lock_guard<std::mutex> lock(state_mutex_);
+    if (busy_)
+      return SC_TDC_ERR_NOTRDY;
+    busy_ = true;
+    request_ms_ = exposure_ms;
+    interrupt_ = false;
+  }
+  state_cv_.notify_all();
+  return 0;
+}
+
+int MockDevice::interrupt()
+{
+  interrupt_ = true;
+  return 0;
+}
+
+void MockDevice::set_complete_callback(void* priv, void (*cb)(void*, int))
+{
+  std::lock_guard<std::mutex> lock(state_mutex_);
+  complete_priv_ = priv;
+  complete_cb_ = cb;
+}
+
+void MockDevice::run_()
+{
+  std::unique_lock<std::mutex> lock(state_mutex_);
+  while (true) {
+    state_cv_.wait(lock, [this]() { return quit_ || request_ms_ >= 0; });
+    if (quit_)
+      break;
+    const int exposure_ms = request_ms_;
+    request_ms_ = -1;
+    lock.unlock();
+    const int reason = measure_(exposure_ms);
+    lock.lock();
+    // the complete callback may start the next measurement
+    busy_ = false;
+    void* priv = complete_priv_;
+    void (*cb)(void*, int) = complete_cb_;
+    lock.unlock();
+    if (cb)
+      cb(priv, reason);
+    lock.lock();
+  }
+}
+
+int MockDevice::measure_(int exposure_ms)
+{
+  memset(&stats_, 0, sizeof(stats_));
+  {
+    std::lock_guard<std::recursive_mutex> lock(pipes_mutex_);
+    for (auto& p : pipes_snapshot_()) {
+      if (p->type == USER_CALLBACKS) {
+        if (p->open && p->cb.start_of_measure)
+          p->cb.start_of_measure(p->cb.priv);
+        continue;
+      }
+      p->ready = false;
+      p->buf = nullptr;
+      if (p->alloc) {
+        if (p->alloc(p->owner, &p->buf) != 0)
+          p->buf = nullptr;
+      }
+      else {
+        p->own.assign(p->buffer_bytes(), 0);
+        p->buf = p->own.data();
+      }
+    }
+  }
+
+  const auto t0 = std::chrono::steady_clock::now();
+  int k = 0;
+  for (; k < exposure_ms && !interrupt_; k++) {
+    gen_.generate(ms_++, events_);
+    const unsigned n = static_cast<unsigned>(events_.size());
+    for (unsigned i = 0; i < 4; i++) {
+      stats_.counts_read[0][i] += n;
+      stats_.counts_received[0][i] += n;
+    }
+    stats_.events_found[0] += n;
+    stats_.events_in_roi[0] += n;
+    stats_.events_received[0] += n;
+    {
+      std::lock_guard<std::recursive_mutex> lock(pipes_mutex_);
+      PipeList pipes = pipes_snapshot_();
+      deliver_(pipes, events_.data(), events_.size());
+      for (auto& p : pipes) {
+        if (p->open && p->type == USER_CALLBACKS && p->cb.millisecond_countup)
+          p->cb.millisecond_countup(p->cb.priv);
+      }
+    }
+    if (s_.realtime)
+      std::this_thread::sleep_until(t0 + std::chrono::milliseconds(k + 1));
+  }
+
+  std::lock_guard<std::recursive_mutex> lock(pipes_mutex_);
+  PipeList pipes = pipes_snapshot_();
+  for (auto& p : pipes) {
+    if (p->open && p->type == STATISTICS && p->buf)
+      memcpy(p->buf, &stats_, sizeof(stats_));
+    if (p->open && p->type == USER_CALLBACKS && p->cb.statistics)
+      p->cb.statistics(p->cb.priv, &stats_);
+  }
+  for (auto& p : pipes) {
+    if (p->open && p->type == USER_CALLBACKS && p->cb.end_of_measure)
+      p->cb.end_of_measure(p->cb.priv);
+  }
+  for (auto& p : pipes) {
+    if (p->type != USER_CALLBACKS)
+      p->ready = (p->buf != nullptr);
+  }
+  pipes_cv_.notify_all();
+  return (k < exposure_ms) ? 2 : 1; // interrupted by user : finished
+}
+
+MockDevice::PipeList MockDevice::pipes_snapshot_()
+{
+  PipeList l;
+  l.reserve(pipes_.size());
+  for (auto& kv : pipes_)
+    l.push_back(kv.second);
+  return l;
+}
+
+void MockDevice::deliver_(
+  const PipeList& pipes, const sc_DldEvent* e, std::size_t n)
+{
+  for (auto& p : pipes) {
+    if (p->type == USER_CALLBACKS) {
+      for (std::size_t i = 0; i < n && p->open && p->cb.dld_event;
+           i += s_.block)
+        p->cb.dld_event(p->cb.priv, e + i, std::min<std::size_t>(s_.block, n - i));
+    }
+    else if (p->open && p->is_histo() && p->buf)
+      p->fill(e, n);
+  }
+}
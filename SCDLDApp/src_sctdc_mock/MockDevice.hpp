@@ -0,0 +1,103 @@
+#ifndef MOCKDEVICE_HPP
+#define MOCKDEVICE_HPP
+
+/*
+ * Copyright (C) 2020 Surface Concept GmbH
+*/
+
+#include <atomic>
+#include <condition_variable>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <scTDC_types.h>
+#include "MockEventGenerator.hpp"
+#include "MockSettings.hpp"
+
+/** error codes of the mock library, see sc_get_err_msg in scTDC_mock.cpp */
+struct MockError
+{
+  enum {
+    DEFAULT = -1,
+    INIFILE = -2,
+    NOMEM = -4,
+    PARAMETER = -7,
+    NOTINIT = -10,
+    TIMEOUT = -20,
+    PIPETYPE = -21,
+    NOPIPE = -22
+  };
+};
+
+/**
+ * @brief The MockDevice class is one initialized device of the mock scTDC
+ * library. A measurement thread runs the measurements started by start():
+ * every millisecond, it synthesizes the events (MockEventGenerator), passes
+ * them to the dld_event callbacks of the USER_CALLBACKS pipes and sorts them
+ * into the buffers of the histogram pipes, then calls millisecond_countup.
+ * At the end, it fills the statistics, calls end_of_measure and finally the
+ * complete callback (reason 1 when finished, 2 when interrupted).
+ * The pipes are only accessed under pipes_mutex_, which the measurement
+ * thread holds while it delivers one millisecond, such that a pipe is never
+ * used after sc_pipe_close2 returned. It is recursive, because the
+ * callbacks may close pipes.
+ */
+class MockDevice
+{
+public:
+  explicit MockDevice(const MockSettings& s);
+  ~MockDevice();
+
+  MockDevice(const MockDevice&) = delete;
+  MockDevice& operator=(const MockDevice&) = delete;
+
+  /** @return the pipe descriptor or a negative error code */
+  int open_pipe(int type, const void* params);
+  int close_pipe(int pd);
+  /**
+   * @brief read_pipe wait for the buffer of a histogram or statistics pipe,
+   * which becomes available at the end of a measurement
+   */
+  int read_pipe(int pd, void** buf, unsigned timeout_ms);
+  /** @return 0 or SC_TDC_ERR_NOTRDY if a measurement is still running */
+  int start(int exposure_ms);
+  int interrupt();
+  void set_complete_callback(void* priv, void (*cb)(void*, int));
+  double binsize_ns() const {
+    return s_.binsize_ns;
+  }
+
+private:
+  struct Pipe;
+  typedef std::vector<std::shared_ptr<Pipe>> PipeList;
+
+  void run_();
+  int measure_(int exposure_ms);
+  PipeList pipes_snapshot_();
+  void deliver_(const PipeList& pipes, const sc_DldEvent* e, std::size_t n);
+
+  MockSettings s_;
+  MockEventGenerator gen_;
+  std::vector<sc_DldEvent> events_;
+  unsigned long long ms_ = 0; // milliseconds measured since initialization
+  statistics_t stats_;
+
+  std::recursive_mutex pipes_mutex_;
+  std::condition_variable_any pipes_cv_; // buffers of histogram pipes ready
+  std::map<int, std::shared_ptr<Pipe>> pipes_;
+  int next_pd_ = 0;
+
+  std::mutex state_mutex_;
+  std::condition_variable state_cv_;
+  bool busy_ = false;
+  int request_ms_ = -1; // exposure of the next measurement
+  bool quit_ = false;
+  std::atomic<bool> interrupt_;
+  void* complete_priv_ = nullptr;
+  void (*complete_cb_)(void*, int) = nullptr;
+  std::thread thread_;
+};
+
+#endif // MOCKDEVICE_HPP
@@ -0,0 +1,125 @@
+/*
+ * Copyright (C) 2020 Surface Concept GmbH
+*/
+#include "MockEventGenerator.hpp"
+#include <algorithm>
+#include <cmath>
+
+MockEventGenerator::MockEventGenerator(const MockSettings& s)
+  : s_(s), gen_(s.seed), rnd_(s.seed * 0x9E3779B97F4A7C15ull + 1)
+{
+  fill_patterns_();
+}
+
+void MockEventGenerator::generate(
+  unsigned long long ms, std::vector<sc_DldEvent>& out)
+{
+  const std::size_t n = next_count_();
+  out.resize(n);
+  if (n == 0)
+    return;
+  const double spacing_ns = 1e6 / static_cast<double>(n);
+  const double t0_ns = static_cast<double>(ms) * 1e6;
+  const double bins_per_start = s_.start_period_ns / s_.binsize_ns;
+  for (std::size_t i = 0; i < n; i++) {
+    const unsigned long long r = xorshift_();
+    const Pattern& p = patterns_[static_cast<std::size_t>(
+      r >> (64 - PATTERN_BITS))];
+    // evenly spaced arrival times with a random offset within the spacing,
+    // which keeps the events in order
+    const double t_ns = t0_ns +
+      (static_cast<double>(i) + static_cast<double>(r & 0xFFFF) / 65536.0)
+      * spacing_ns;
+    const unsigned long long start =
+      static_cast<unsigned long long>(t_ns / s_.start_period_ns);
+    sc_DldEvent& e = out[i];
+    e.start_counter = start;
+    e.time_tag = static_cast<unsigned long long>(
+      static_cast<double>(start) * bins_per_start);
+    e.subdevice = 0;
+    e.channel = 0;
+    e.sum = p.tof;
+    e.dif1 = p.x;
+    e.dif2 = p.y;
+    e.master_rst_counter = 0;
+    e.adc = 0;
+    e.signal1bit = 0;
+  }
+}
+
+std::size_t MockEventGenerator::next_count_()
+{
+  double mean = s_.rate / 1000.0;
+  if (s_.bursty) {
+    // per millisecond, a burst ends with probability 1 / burst_ms and a pause
+    // ends with probability 1 / pause_ms (geometric lengths)
+    const double pause_ms = s_.burst_ms * (1.0 - s_.burst_duty) / s_.burst_duty;
+    std::uniform_real_distribution<double> u(0.0, 1.0);
+    if (in_burst_) {
+      if (u(gen_) < 1.0 / s_.burst_ms)
+        in_burst_ = false;
+    }
+    else if (pause_ms < 1.0 || u(gen_) < 1.0 / pause_ms)
+      in_burst_ = true;
+    if (!in_burst_)
+      return 0;
+    mean /= s_.burst_duty;
+  }
+  if (mean <= 0.0)
+    return 0;
+  std::poisson_distribution<unsigned long long> d(mean);
+  return static_cast<std::size_t>(d(gen_));
+}
+
+void MockEventGenerator::fill_patterns_()
+{
+  const double PI = 3.14159265358979323846;
+  std::uniform_real_distribution<double> u(0.0, 1.0);
+  std::normal_distribution<double> g(0.0, 1.0);
+  const double cx = 0.5 * s_.size_x;
+  const double cy = 0.5 * s_.size_y;
+  const double radius = 0.5 * std::min(s_.size_x, s_.size_y);
+
+  // spots at random positions inside the detector, with random intensities
+  std::vector<double> spot_x(s_.spots), spot_y(s_.spots), spot_w(s_.spots);
+  double wsum = 0.0;
+  for (unsigned k = 0; k < s_.spots; k++) {
+    const double r = 0.8 * radius * std::sqrt(u(gen_));
+    const double phi = 2.0 * PI * u(gen_);
+    spot_x[k] = cx + r * std::cos(phi);
+    spot_y[k] = cy + r * std::sin(phi);
+    wsum += 1.0 + 2.0 * u(gen_);
+    spot_w[k] = wsum;
+  }
+  std::vector<double> peaks(s_.tof_peaks);
+  for (double& t : peaks)
+    t = (0.1 + 0.8 * u(gen_)) * s_.tof_range_ns;
+
+  patterns_.resize(std::size_t(1) << PATTERN_BITS);
+  for (Pattern& p : patterns_) {
+    double x, y, tof_ns;
+    if (s_.spots == 0 || u(gen_) < s_.background) {
+      const double r = radius * std::sqrt(u(gen_));
+      const double phi = 2.0 * PI * u(gen_);
+      x = cx + r * std::cos(phi);
+      y = cy + r * std::sin(phi);
+      tof_ns = u(gen_) * s_.tof_range_ns;
+    }
+    else {
+      const std::size_t k = static_cast<std::size_t>(
+        std::lower_bound(spot_w.begin(), spot_w.end(), u(gen_) * wsum)
+        - spot_w.begin());
+      const std::size_t spot = std::min(k, spot_w.size() - 1);
+      x = spot_x[spot] + s_.spot_sigma * g(gen_);
+      y = spot_y[spot] + s_.spot_sigma * g(gen_);
+      tof_ns = peaks.empty() ? u(gen_) * s_.tof_range_ns
+        : peaks[spot % peaks.size()] + s_.tof_sigma_ns * g(gen_);
+    }
+    x = std::max(0.0, std::min(x, s_.size_x - 1.0));
+    y = std::max(0.0, std::min(y, s_.size_y - 1.0));
+    tof_ns = std::max(0.0, std::min(tof_ns, s_.tof_range_ns));
+    p.x = static_cast<unsigned short>(x);
+    p.y = static_cast<unsigned short>(y);
+    p.tof = static_cast<unsigned long long>(tof_ns / s_.binsize_ns);
+  }
+}
@@ -0,0 +1,63 @@
+#ifndef MOCKEVENTGENERATOR_HPP
+#define MOCKEVENTGENERATOR_HPP
+
+/*
+ * Copyright (C) 2020 Surface Concept GmbH
+*/
+
+#include <random>
+#include <vector>
+#include <scTDC_types.h>
+#include "MockSettings.hpp"
+
+/**
+ * @brief The MockEventGenerator class synthesizes the sc_DldEvent stream of a
+ * delay-line detector, one millisecond at a time.
+ * The number of events per millisecond is Poisson distributed around the
+ * configured rate. In the bursty mode, the detector alternates between
+ * bursts and pauses of geometrically distributed lengths, and the rate
+ * during bursts is raised such that the mean rate is still as configured.
+ * Positions and times of flight are drawn from a table of pre-computed
+ * events (gaussian spots, each with its own time-of-flight peak, plus a
+ * background spread over the round detector area and the time-of-flight
+ * range), so that the cost per event is a table lookup, which allows for
+ * rates of several 10 Mevents/s on one core.
+ */
+class MockEventGenerator
+{
+public:
+  explicit MockEventGenerator(const MockSettings& s);
+
+  /**
+   * @brief generate fill out with the events of one millisecond
+   * @param ms index of the millisecond since the initialization of the
+   * device, determines the start counters and time tags
+   */
+  void generate(unsigned long long ms, std::vector<sc_DldEvent>& out);
+
+private:
+  struct Pattern {
+    unsigned short x;
+    unsigned short y;
+    unsigned long long tof; // in TDC bins
+  };
+  static const std::size_t PATTERN_BITS = 16;
+
+  void fill_patterns_();
+  std::size_t next_count_();
+  unsigned long long xorshift_() {
+    // xorshift64*, good enough for picking table entries
+    rnd_ ^= rnd_ >> 12;
+    rnd_ ^= rnd_ << 25;
+    rnd_ ^= rnd_ >> 27;
+    return rnd_ * 0x2545F4914F6CDD1Dull;
+  }
+
+  MockSettings s_;
+  std::mt19937_64 gen_;
+  unsigned long long rnd_;
+  std::vector<Pattern> patterns_;
+  bool in_burst_ = false;
+};
+
+#endif // MOCKEVENTGENERATOR_HPP
@@ -0,0 +1,104 @@
+/*
+ * Copyright (C) 2020 Surface Concept GmbH
+*/
+#include "MockSettings.hpp"
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <fstream>
+
+namespace {
+
+std::string trim(const std::string& s)
+{
+  std::size_t b = s.find_first_not_of(" \t\r\n");
+  if (b == std::string::npos)
+    return std::string();
+  std::size_t e = s.find_last_not_of(" \t\r\n");
+  return s.substr(b, e - b + 1);
+}
+
+std::string lower(std::string s)
+{
+  for (char& c : s)
+    c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+  return s;
+}
+
+std::string upper(std::string s)
+{
+  for (char& c : s)
+    c = static_cast<char>(std::toupper(static_cast<unsigned char>(c)));
+  return s;
+}
+
+const char* KEYS[] = {
+  "rate", "mode", "burst_ms", "burst_duty", "spots", "spot_sigma",
+  "background", "size_x", "size_y", "tof_peaks", "tof_range_ns",
+  "tof_sigma_ns", "start_period_ns", "binsize_ns", "block", "realtime", "seed"
+};
+
+} // namespace
+
+bool MockSettings::load(const std::string& inifile)
+{
+  std::ifstream f(inifile);
+  if (!f)
+    return false;
+  std::string line;
+  bool in_section = false;
+  while (std::getline(f, line)) {
+    line = trim(line.substr(0, line.find_first_of(";#")));
+    if (line.empty())
+      continue;
+    if (line[0] == '[') {
+      in_section = lower(line) == "[mock]";
+      continue;
+    }
+    std::size_t eq = line.find('=');
+    if (in_section && eq != std::string::npos)
+      set_(lower(trim(line.substr(0, eq))), trim(line.substr(eq + 1)));
+  }
+  for (const char* key : KEYS) {
+    const char* v = std::getenv(("SCTDC_MOCK_" + upper(key)).c_str());
+    if (v)
+      set_(key, trim(v));
+  }
+  rate = std::max(0.0, std::min(rate, 1e9));
+  burst_ms = std::max(1.0, burst_ms);
+  burst_duty = std::max(0.001, std::min(burst_duty, 1.0));
+  spots = std::min(spots, 1000u);
+  spot_sigma = std::max(0.1, spot_sigma);
+  background = std::max(0.0, std::min(background, 1.0));
+  size_x = std::max(2u, std::min(size_x, 65535u));
+  size_y = std::max(2u, std::min(size_y, 65535u));
+  tof_peaks = std::min(tof_peaks, 1000u);
+  tof_range_ns = std::max(1.0, tof_range_ns);
+  tof_sigma_ns = std::max(0.001, tof_sigma_ns);
+  start_period_ns = std::max(1.0, start_period_ns);
+  binsize_ns = std::max(1e-6, binsize_ns);
+  block = std::max(1u, std::min(block, 1u << 24));
+  return true;
+}
+
+void MockSettings::set_(const std::string& key, const std::string& value)
+{
+  const char* v = value.c_str();
+  if (key == "rate") rate = std::atof(v);
+  else if (key == "mode") bursty = lower(value) == "bursty";
+  else if (key == "burst_ms") burst_ms = std::atof(v);
+  else if (key == "burst_duty") burst_duty = std::atof(v);
+  else if (key == "spots") spots = static_cast<unsigned>(std::atoi(v));
+  else if (key == "spot_sigma") spot_sigma = std::atof(v);
+  else if (key == "background") background = std::atof(v);
+  else if (key == "size_x") size_x = static_cast<unsigned>(std::atoi(v));
+  else if (key == "size_y") size_y = static_cast<unsigned>(std::atoi(v));
+  else if (key == "tof_peaks") tof_peaks = static_cast<unsigned>(std::atoi(v));
+  else if (key == "tof_range_ns") tof_range_ns = std::atof(v);
+  else if (key == "tof_sigma_ns") tof_sigma_ns = std::atof(v);
+  else if (key == "start_period_ns") start_period_ns = std::atof(v);
+  else if (key == "binsize_ns") binsize_ns = std::atof(v);
+  else if (key == "block") block = static_cast<unsigned>(std::atoi(v));
+  else if (key == "realtime") realtime = std::atoi(v) != 0;
+  else if (key == "seed") seed = std::strtoull(v, nullptr, 0);
+}
@@ -0,0 +1,66 @@
+#ifndef MOCKSETTINGS_HPP
+#define MOCKSETTINGS_HPP
+
+/*
+ * Copyright (C) 2020 Surface Concept GmbH
+*/
+
+// Settings of the mock scTDC library, read from the [Mock] section of the
+// ini file passed to sc_tdc_init_inifile (the other sections are ignored, so
+// the ini file of a real detector can be used). Every key can be overridden
+// by an environment variable SCTDC_MOCK_<KEY>, e.g. SCTDC_MOCK_RATE=2e7.
+//
+// [Mock]
+// rate = 1e6            ; mean event rate in events/s
+// mode = poisson        ; poisson or bursty
+// burst_ms = 5          ; bursty: mean length of a burst in ms
+// burst_duty = 0.2      ; bursty: fraction of the time in bursts
+// spots = 8             ; number of gaussian spots on the detector
+// spot_sigma = 12       ; width of the spots in detector pixels
+// background = 0.1      ; fraction of events spread over the detector
+// size_x = 1450         ; detector size in pixels (dif1 / dif2 range)
+// size_y = 1450
+// tof_peaks = 4         ; number of peaks in the time-of-flight spectrum
+// tof_range_ns = 1000   ; time-of-flight range
+// tof_sigma_ns = 2      ; width of the time-of-flight peaks
+// start_period_ns = 1000 ; period of the start pulses
+// binsize_ns = 0.0823045 ; TDC bin size, reported by sc_tdc_get_binsize2
+// block = 4096          ; maximum number of events per dld_event callback
+// realtime = 1          ; 1: events at the wall clock rate, 0: as fast as
+//                       ; the consumers accept them
+// seed = 1              ; seed of the random number generators
+
+#include <string>
+
+struct MockSettings
+{
+  double rate = 1e6;
+  bool bursty = false;
+  double burst_ms = 5.0;
+  double burst_duty = 0.2;
+  unsigned spots = 8;
+  double spot_sigma = 12.0;
+  double background = 0.1;
+  unsigned size_x = 1450;
+  unsigned size_y = 1450;
+  unsigned tof_peaks = 4;
+  double tof_range_ns = 1000.0;
+  double tof_sigma_ns = 2.0;
+  double start_period_ns = 1000.0;
+  double binsize_ns = 0.0823045;
+  unsigned block = 4096;
+  bool realtime = true;
+  unsigned long long seed = 1;
+
+  /**
+   * @brief load read the [Mock] section of an ini file and the environment
+   * variables, clamp the values to sensible ranges
+   * @return false if the ini file cannot be read
+   */
+  bool load(const std::string& inifile);
+
+private:
+  void set_(const std::string& key, const std::string& value);
+};
+
+#endif // MOCKSETTINGS_HPP
@@ -0,0 +1,169 @@
+/*
+ * Copyright (C) 2020 Surface Concept GmbH
+*/
+
+// Stand-in for the scTDC library of the SDK, for testing and benchmarking
+// dldApp, the sctdc_hdf5 library and the areaDetector driver without a
+// detector. It implements the subset of the scTDC API used in this tree:
+// device initialization from an ini file, the DLD_IMAGE_XY, DLD_IMAGE_3D,
+// DLD_SUM_HISTO, STATISTICS and USER_CALLBACKS pipes, timed measurements
+// with interruption and the complete callback. The events are synthesized
+// according to the [Mock] section of the ini file, see MockSettings.hpp.
+//
+// The library is built as libscTDC from the SDK headers if SCTDC_MOCK = YES
+// in configure/CONFIG_SCTDC. It is placed in the lib directory of this tree,
+// where the linker finds it before the library of the SDK.
+//
+// scTDC.h is not included here, such that the definitions do not conflict
+// with the declarations of a particular SDK version (const qualifiers, enum
+// parameter types). The functions have the same C linkage and parameters.
+
+#include <cstdio>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <scTDC_types.h>
+#include <scTDC_error_codes.h>
+#include "MockDevice.hpp"
+
+namespace {
+
+const std::size_t ERRSTRLEN_ = 256; // ERRSTRLEN from scTDC.h
+
+std::mutex devices_mutex;
+std::map<int, std::shared_ptr<MockDevice>> devices;
+
+std::shared_ptr<MockDevice> device(int dd)
+{
+  std::lock_guard<std::mutex> lock(devices_mutex);
+  auto it = devices.find(dd);
+  return (it == devices.end()) ? std::shared_ptr<MockDevice>() : it->second;
+}
+
+} // namespace
+
+extern "C" {
+
+int sc_tdc_init_inifile(const char* ini_filename)
+{
+  MockSettings s;
+  if (!ini_filename || !s.load(ini_filename))
+    return MockError::INIFILE;
+  std::lock_guard<std::mutex> lock(devices_mutex);
+  int dd = 0;
+  while (devices.count(dd))
+    dd++;
+  try {
+    devices[dd] = std::make_shared<MockDevice>(s);
+  }
+  catch (const std::bad_alloc&) {
+    return MockError::NOMEM;
+  }
+  return dd;
+}
+
+int sc_tdc_deinit2(int dev_desc)
+{
+  std::shared_ptr<MockDevice> d;
+  {
+    std::lock_guard<std::mutex> lock(devices_mutex);
+    auto it = devices.find(dev_desc);
+    if (it == devices.end())
+      return MockError::NOTINIT;
+    d = it->second;
+    devices.erase(it);
+  }
+  d.reset(); // stops the measurement thread, outside of devices_mutex
+  return 0;
+}
+
+int sc_tdc_start_measure2(int dev_desc, int exposure)
+{
+  auto d = device(dev_desc);
+  if (!d)
+    return MockError::NOTINIT;
+  return d->start(exposure);
+}
+
+int sc_tdc_interrupt2(int dev_desc)
+{
+  auto d = device(dev_desc);
+  if (!d)
+    return MockError::NOTINIT;
+  return d->interrupt();
+}
+
+int sc_tdc_set_complete_callback2(
+  int dev_desc, void* private_data, void (*cb)(void*, int))
+{
+  auto d = device(dev_desc);
+  if (!d)
+    return MockError::NOTINIT;
+  d->set_complete_callback(private_data, cb);
+  return 0;
+}
+
+int sc_tdc_get_binsize2(int dev_desc, double* binsize_ns)
+{
+  auto d = device(dev_desc);
+  if (!d)
+    return MockError::NOTINIT;
+  if (!binsize_ns)
+    return MockError::PARAMETER;
+  *binsize_ns = d->binsize_ns();
+  return 0;
+}
+
+int sc_pipe_open2(int dev_desc, int type, const void* params)
+{
+  auto d = device(dev_desc);
+  if (!d)
+    return MockError::NOTINIT;
+  try {
+    return d->open_pipe(type, params);
+  }
+  catch (const std::bad_alloc&) {
+    return MockError::NOMEM;
+  }
+}
+
+int sc_pipe_close2(int dev_desc, int pipe_id)
+{
+  auto d = device(dev_desc);
+  if (!d)
+    return MockError::NOTINIT;
+  return d->close_pipe(pipe_id);
+}
+
+int sc_pipe_read2(int dev_desc, int pipe_id, void** buffer, unsigned timeout)
+{
+  auto d = device(dev_desc);
+  if (!d)
+    return MockError::NOTINIT;
+  return d->read_pipe(pipe_id, buffer, timeout);
+}
+
+void sc_get_err_msg(int err_code, char* err_msg)
+{
+  if (!err_msg)
+    return;
+  const char* m;
+  if (err_code == SC_TDC_ERR_NOTRDY)
+    m = "mock scTDC: measurement in progress";
+  else switch (err_code) {
+  case 0: m = "no error"; break;
+  case MockError::INIFILE: m = "mock scTDC: cannot read the ini file"; break;
+  case MockError::NOMEM: m = "mock scTDC: out of memory"; break;
+  case MockError::PARAMETER: m = "mock scTDC: invalid parameter"; break;
+  case MockError::NOTINIT: m = "mock scTDC: device not initialized"; break;
+  case MockError::TIMEOUT: m = "mock scTDC: timeout"; break;
+  case MockError::PIPETYPE:
+    m = "mock scTDC: pipe type not supported"; break;
+  case MockError::NOPIPE: m = "mock scTDC: no such pipe"; break;
+  default: m = "mock scTDC: error"; break;
+  }
+  std::snprintf(err_msg, ERRSTRLEN_, "%s", m);
+}
+
+} // extern "C"
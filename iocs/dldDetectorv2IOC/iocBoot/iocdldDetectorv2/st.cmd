@@ -41,6 +41,11 @@ NDStdArraysConfigure("Image1", 3, 0, "$(PORT)", 0)
 # This waveform allows transporting 32-bit images
 dbLoadRecords("NDStdArrays.template", "P=$(PREFIX),R=LiveImageXY:,PORT=Image1,ADDR=0,TIMEOUT=1,NDARRAY_PORT=$(PORT),TYPE=Int32,FTVL=LONG,NELEMENTS=12000000")
 
+# The XYT cube (cam1:XYTCube) is sent on NDArray address 2, as 3D arrays of
+# x, y and time slices. To save the cubes, uncomment:
+#NDFileHDF5Configure("FileHDF5XYT", $(QSIZE), 0, "$(PORT)", 2)
+#dbLoadRecords("NDFileHDF5.template", "P=$(PREFIX),R=HDFXYT:,PORT=FileHDF5XYT,ADDR=0,TIMEOUT=1,XMLSIZE=2048,NDARRAY_PORT=$(PORT),NDARRAY_ADDR=2")
+
 
 # Load all other plugins using commonPlugins.cmd
 < commonPlugins.cmd